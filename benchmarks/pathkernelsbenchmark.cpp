@@ -0,0 +1,121 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <QtTest>
+#include <QtMath>
+
+#include <limits>
+
+#include "riveqtpathkernels.h"
+
+// the inner loops of the tessellation, the variant is picked once per process,
+// run it a second time with RIVEQTQUICKPLUGIN_DISABLE_SIMD set to get the scalar numbers
+class PathKernelsBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void flattenCubic();
+    void transformPoints();
+    void packVertices();
+    void narrowIndices();
+    void offsetSegments();
+
+private:
+    QVector<QVector2D> m_points;
+};
+
+void PathKernelsBenchmark::initTestCase()
+{
+    qInfo() << "Path kernels use" << RiveQtPathKernels::instructionSet();
+
+    // a closed wavy outline, about the size of the flattened paths of a complex artboard
+    const int pointCount = 4096;
+    m_points.resize(pointCount + 1);
+    for (int i = 0; i <= pointCount; ++i) {
+        const float angle = 2.0f * float(M_PI) * i / pointCount;
+        const float radius = 200.0f + 20.0f * qSin(angle * 32.0f);
+        m_points[i] = QVector2D(radius * qCos(angle), radius * qSin(angle));
+    }
+}
+
+void PathKernelsBenchmark::flattenCubic()
+{
+    // the upper bound of segments per cubic in RiveQtPath
+    QVector<QVector2D> points(100);
+    const QVector2D p0(0.0f, 0.0f);
+    const QVector2D p1(30.0f, 120.0f);
+    const QVector2D p2(170.0f, -80.0f);
+    const QVector2D p3(200.0f, 40.0f);
+
+    QBENCHMARK {
+        for (int segments = 1; segments <= points.size(); ++segments) {
+            RiveQtPathKernels::flattenCubic(p0, p1, p2, p3, segments, points.data());
+        }
+    }
+    QCOMPARE(points.last(), p3);
+}
+
+void PathKernelsBenchmark::transformPoints()
+{
+    QMatrix4x4 matrix;
+    matrix.translate(10.0f, 20.0f);
+    matrix.rotate(30.0f, 0.0f, 0.0f, 1.0f);
+    matrix.scale(1.5f, 0.5f);
+    QMatrix4x4 inverse = matrix.inverted();
+
+    QVector<QVector2D> points = m_points;
+    QBENCHMARK {
+        // back and forth, so the points stay in range
+        RiveQtPathKernels::transformPoints(points.data(), points.size(), matrix);
+        RiveQtPathKernels::transformPoints(points.data(), points.size(), inverse);
+    }
+}
+
+void PathKernelsBenchmark::packVertices()
+{
+    QVector<qreal> coordinates;
+    coordinates.reserve(2 * m_points.size());
+    for (const QVector2D &point : qAsConst(m_points)) {
+        coordinates << point.x() << point.y();
+    }
+
+    QVector<QVector2D> vertices(m_points.size());
+    QBENCHMARK {
+        RiveQtPathKernels::packVertices(coordinates.constData(), vertices.size(), vertices.data());
+    }
+    QCOMPARE(vertices.first(), m_points.first());
+}
+
+void PathKernelsBenchmark::narrowIndices()
+{
+    QVector<quint32> indices(3 * m_points.size());
+    for (int i = 0; i < indices.size(); ++i) {
+        indices[i] = quint32(i % std::numeric_limits<quint16>::max());
+    }
+
+    QVector<quint16> target(indices.size());
+    QBENCHMARK {
+        RiveQtPathKernels::narrowIndices(indices.constData(), indices.size(), target.data());
+    }
+    QCOMPARE(target.last(), quint16(indices.last()));
+}
+
+void PathKernelsBenchmark::offsetSegments()
+{
+    const int segmentCount = m_points.size() - 1;
+    QVector<QVector2D> directions(segmentCount);
+    QVector<QVector2D> vertices(4 * segmentCount);
+
+    QBENCHMARK {
+        RiveQtPathKernels::offsetSegments(m_points.constData(), segmentCount, 3.0f, directions.data(), vertices.data());
+    }
+    QVERIFY(qAbs(directions.first().length() - 1.0f) < 1e-5f);
+}
+
+QTEST_GUILESS_MAIN(PathKernelsBenchmark)
+
+#include "pathkernelsbenchmark.moc"
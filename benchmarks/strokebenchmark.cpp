@@ -0,0 +1,137 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include <QtTest>
+#include <QtMath>
+
+#include <memory>
+
+#include "riveqtpath.h"
+
+// compares the native stroker against QPainterPathStroker + qTriangulate on the kind of paths rive files contain
+class StrokeBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void stroke_data();
+    void stroke();
+
+private:
+    static std::shared_ptr<RiveQtPath> circle();
+    static std::shared_ptr<RiveQtPath> zigZag();
+    static std::shared_ptr<RiveQtPath> wave();
+
+    QList<QPair<const char *, std::shared_ptr<RiveQtPath>>> m_paths;
+};
+
+// 4 cubics, the typical ellipse shape
+std::shared_ptr<RiveQtPath> StrokeBenchmark::circle()
+{
+    const float r = 100.0f;
+    const float k = 0.5522847f * r;
+    auto path = std::make_shared<RiveQtPath>();
+    path->moveTo(r, 0.0f);
+    path->cubicTo(r, k, k, r, 0.0f, r);
+    path->cubicTo(-k, r, -r, k, -r, 0.0f);
+    path->cubicTo(-r, -k, -k, -r, 0.0f, -r);
+    path->cubicTo(k, -r, r, -k, r, 0.0f);
+    path->close();
+    return path;
+}
+
+// an open polyline with sharp corners, every point needs a join
+std::shared_ptr<RiveQtPath> StrokeBenchmark::zigZag()
+{
+    auto path = std::make_shared<RiveQtPath>();
+    path->moveTo(0.0f, 0.0f);
+    for (int i = 1; i <= 200; ++i) {
+        path->lineTo(i * 5.0f, (i % 2) ? 20.0f : 0.0f);
+    }
+    return path;
+}
+
+// a closed path of many curves, like a hand drawn outline
+std::shared_ptr<RiveQtPath> StrokeBenchmark::wave()
+{
+    auto path = std::make_shared<RiveQtPath>();
+    const int curves = 64;
+    path->moveTo(200.0f, 0.0f);
+    for (int i = 0; i < curves; ++i) {
+        const float a0 = 2.0f * float(M_PI) * i / curves;
+        const float a1 = 2.0f * float(M_PI) * (i + 1) / curves;
+        const float r0 = (i % 2) ? 180.0f : 220.0f;
+        const float r1 = (i % 2) ? 220.0f : 180.0f;
+        path->cubicTo(r0 * qCos(a0 + 0.02f), r0 * qSin(a0 + 0.02f), r1 * qCos(a1 - 0.02f), r1 * qSin(a1 - 0.02f), r1 * qCos(a1),
+                      r1 * qSin(a1));
+    }
+    path->close();
+    return path;
+}
+
+void StrokeBenchmark::initTestCase()
+{
+    m_paths = {
+        { "circle", circle() },
+        { "zigzag", zigZag() },
+        { "wave", wave() },
+    };
+}
+
+void StrokeBenchmark::stroke_data()
+{
+    QTest::addColumn<int>("path");
+    QTest::addColumn<int>("joinStyle");
+    QTest::addColumn<int>("strokeMode");
+
+    const QList<QPair<const char *, Qt::PenJoinStyle>> joins {
+        { "miter", Qt::MiterJoin },
+        { "round", Qt::RoundJoin },
+    };
+    const QList<QPair<const char *, RiveRenderSettings::StrokeMode>> modes {
+        { "qt", RiveRenderSettings::QtStroking },
+        { "native", RiveRenderSettings::NativeStroking },
+    };
+
+    for (int path = 0; path < m_paths.size(); ++path) {
+        for (const auto &join : joins) {
+            for (const auto &mode : modes) {
+                QTest::addRow("%s/%s/%s", m_paths.at(path).first, join.first, mode.first) << path << int(join.second) << int(mode.second);
+            }
+        }
+    }
+}
+
+void StrokeBenchmark::stroke()
+{
+    QFETCH(int, path);
+    QFETCH(int, joinStyle);
+    QFETCH(int, strokeMode);
+
+    // the path keeps the stroke of the last pen, two pens that take turns force a new stroke each time
+    QPen pens[2];
+    for (int i = 0; i < 2; ++i) {
+        pens[i].setWidthF(6.0 + i * 0.5);
+        pens[i].setJoinStyle(static_cast<Qt::PenJoinStyle>(joinStyle));
+        pens[i].setCapStyle(Qt::RoundCap);
+    }
+
+    RiveQtPath *strokedPath = m_paths.at(path).second.get();
+    const auto mode = static_cast<RiveRenderSettings::StrokeMode>(strokeMode);
+
+    int turn = 0;
+    int indexCount = 0;
+    QBENCHMARK {
+        const RiveQtPathGeometry geometry = strokedPath->strokeGeometry(pens[turn], mode);
+        indexCount = geometry.indexCount();
+        turn ^= 1;
+    }
+    QVERIFY(indexCount > 0);
+}
+
+QTEST_GUILESS_MAIN(StrokeBenchmark)
+
+#include "strokebenchmark.moc"
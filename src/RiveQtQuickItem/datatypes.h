@@ -56,6 +56,11 @@ struct RiveRenderSettings
     Q_PROPERTY(PostprocessingMode postprocessingMode MEMBER postprocessingMode)
     Q_PROPERTY(QSGRendererInterface::GraphicsApi graphicsApi MEMBER graphicsApi)
     Q_PROPERTY(FillMode fillMode MEMBER fillMode)
+    Q_PROPERTY(FillRenderMode fillRenderMode MEMBER fillRenderMode)
+    Q_PROPERTY(StrokeMode strokeMode MEMBER strokeMode)
+    Q_PROPERTY(AntialiasingMode antialiasingMode MEMBER antialiasingMode)
+    Q_PROPERTY(bool nestedArtboardCaching MEMBER nestedArtboardCaching)
+    Q_PROPERTY(bool renderAtlas MEMBER renderAtlas)
 
 public:
     enum RenderQuality
@@ -81,9 +86,38 @@ public:
     };
     Q_ENUM(PostprocessingMode)
 
+    enum FillRenderMode
+    {
+        TriangulatedFill,
+        StencilCoverFill,
+        AutomaticFill,
+        GpuTessellatedFill
+    };
+    Q_ENUM(FillRenderMode)
+
+    enum StrokeMode
+    {
+        QtStroking,
+        NativeStroking,
+        GpuStroking
+    };
+    Q_ENUM(StrokeMode)
+
+    enum AntialiasingMode
+    {
+        NoAntialiasing,
+        AnalyticAntialiasing
+    };
+    Q_ENUM(AntialiasingMode)
+
     RenderQuality renderQuality { Medium };
     PostprocessingMode postprocessingMode { None };
     QSGRendererInterface::GraphicsApi graphicsApi { QSGRendererInterface::GraphicsApi::Software };
     FillMode fillMode { PreserveAspectFit };
+    FillRenderMode fillRenderMode { AutomaticFill };
+    StrokeMode strokeMode { QtStroking };
+    AntialiasingMode antialiasingMode { NoAntialiasing };
+    bool nestedArtboardCaching { false };
+    bool renderAtlas { false };
 };
 Q_DECLARE_METATYPE(RiveRenderSettings)
@@ -0,0 +1,153 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "renderer/riveqtdisplaylist.h"
+#include "renderer/riveqtutils.h"
+#include "riveqtpath.h"
+
+#include <QHash>
+
+void RiveQtDisplayList::clear()
+{
+    // clear() keeps the capacity, so the next frame records into the same memory
+    m_commands.clear();
+    m_transforms.clear();
+    m_clipPaths.clear();
+    m_pathDraws.clear();
+    m_imageDraws.clear();
+    m_imageMeshDraws.clear();
+}
+
+void RiveQtDisplayList::replay(rive::Renderer *renderer) const
+{
+    replay(renderer, 0, m_commands.count());
+}
+
+void RiveQtDisplayList::replay(rive::Renderer *renderer, int begin, int end) const
+{
+    for (int i = begin; i < end; ++i) {
+        const Command &command = m_commands[i];
+        switch (command.type) {
+        case CommandType::Save:
+            renderer->save();
+            break;
+        case CommandType::Restore:
+            renderer->restore();
+            break;
+        case CommandType::Transform:
+            renderer->transform(m_transforms[command.index]);
+            break;
+        case CommandType::ClipPath:
+            renderer->clipPath(m_clipPaths[command.index]);
+            break;
+        case CommandType::DrawPath: {
+            const PathDraw &draw = m_pathDraws[command.index];
+            renderer->drawPath(draw.path, draw.paint);
+            break;
+        }
+        case CommandType::DrawImage: {
+            const ImageDraw &draw = m_imageDraws[command.index];
+            renderer->drawImage(draw.image, draw.blendMode, draw.opacity);
+            break;
+        }
+        case CommandType::DrawImageMesh: {
+            const ImageMeshDraw &draw = m_imageMeshDraws[command.index];
+            renderer->drawImageMesh(draw.image, draw.vertices, draw.uvCoords, draw.indices, draw.vertexCount, draw.indexCount,
+                                    draw.blendMode, draw.opacity);
+            break;
+        }
+        }
+    }
+}
+
+size_t RiveQtDisplayList::fingerprint() const
+{
+    return fingerprint(0, m_commands.count());
+}
+
+size_t RiveQtDisplayList::fingerprint(int begin, int end) const
+{
+    size_t fingerprint = qHashMulti(0, end - begin);
+    for (int i = begin; i < end; ++i) {
+        const Command &command = m_commands[i];
+        fingerprint = qHashMulti(fingerprint, int(command.type));
+
+        switch (command.type) {
+        case CommandType::Save:
+        case CommandType::Restore:
+            break;
+        case CommandType::Transform: {
+            const rive::Mat2D &m = m_transforms[command.index];
+            fingerprint = qHashMulti(fingerprint, m[0], m[1], m[2], m[3], m[4], m[5]);
+            break;
+        }
+        case CommandType::ClipPath: {
+            const RiveQtPath *path = static_cast<const RiveQtPath *>(m_clipPaths[command.index]);
+            fingerprint = qHashMulti(fingerprint, quintptr(path), path ? path->contentVersion() : 0);
+            break;
+        }
+        case CommandType::DrawPath: {
+            const PathDraw &draw = m_pathDraws[command.index];
+            const RiveQtPath *path = static_cast<const RiveQtPath *>(draw.path);
+            const RiveQtPaint *paint = static_cast<const RiveQtPaint *>(draw.paint);
+            fingerprint = qHashMulti(fingerprint, quintptr(path), path ? path->contentVersion() : 0, quintptr(paint),
+                                     paint ? paint->contentVersion() : 0);
+            break;
+        }
+        case CommandType::DrawImage: {
+            const ImageDraw &draw = m_imageDraws[command.index];
+            fingerprint = qHashMulti(fingerprint, quintptr(draw.image), int(draw.blendMode), draw.opacity);
+            break;
+        }
+        case CommandType::DrawImageMesh:
+            // the mesh is deformed in place
+            return 0;
+        }
+    }
+    return fingerprint;
+}
+
+void RiveQtDisplayList::save()
+{
+    m_commands.append({ CommandType::Save });
+}
+
+void RiveQtDisplayList::restore()
+{
+    m_commands.append({ CommandType::Restore });
+}
+
+void RiveQtDisplayList::transform(const rive::Mat2D &transform)
+{
+    m_commands.append({ CommandType::Transform, int(m_transforms.size()) });
+    m_transforms.append(transform);
+}
+
+void RiveQtDisplayList::drawPath(rive::RenderPath *path, rive::RenderPaint *paint)
+{
+    m_commands.append({ CommandType::DrawPath, int(m_pathDraws.size()) });
+    m_pathDraws.append({ path, paint });
+}
+
+void RiveQtDisplayList::clipPath(rive::RenderPath *path)
+{
+    m_commands.append({ CommandType::ClipPath, int(m_clipPaths.size()) });
+    m_clipPaths.append(path);
+}
+
+void RiveQtDisplayList::drawImage(const rive::RenderImage *image, rive::BlendMode blendMode, float opacity)
+{
+    m_commands.append({ CommandType::DrawImage, int(m_imageDraws.size()) });
+    m_imageDraws.append({ image, blendMode, opacity });
+}
+
+void RiveQtDisplayList::drawImageMesh(const rive::RenderImage *image, rive::rcp<rive::RenderBuffer> vertices_f32,
+                                      rive::rcp<rive::RenderBuffer> uvCoords_f32, rive::rcp<rive::RenderBuffer> indices_u16,
+                                      uint32_t vertexCount, uint32_t indexCount, rive::BlendMode blendMode, float opacity)
+{
+    m_commands.append({ CommandType::DrawImageMesh, int(m_imageMeshDraws.size()) });
+    m_imageMeshDraws.append({ image, std::move(vertices_f32), std::move(uvCoords_f32), std::move(indices_u16), vertexCount, indexCount,
+                              blendMode, opacity });
+}
@@ -0,0 +1,105 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#pragma once
+
+#include <rive/renderer.hpp>
+#include <rive/math/mat2d.hpp>
+
+#include <QVector>
+
+// records the calls rive makes while it draws an artboard, so a backend can replay them afterwards
+// the arenas keep their capacity when cleared, once they grew large enough recording does not allocate anymore
+// paths, paints and images are only referenced, they stay valid until the artboard draws again
+// passes over the whole stream run here before any backend work, culling and batching need the tessellation and stay in the backends
+class RiveQtDisplayList : public rive::Renderer
+{
+public:
+    enum class CommandType : quint8
+    {
+        Save,
+        Restore,
+        Transform,
+        ClipPath,
+        DrawPath,
+        DrawImage,
+        DrawImageMesh
+    };
+
+    struct Command
+    {
+        CommandType type;
+        // index into the arena of the type, unused for save and restore
+        int index { 0 };
+    };
+
+    struct PathDraw
+    {
+        rive::RenderPath *path { nullptr };
+        rive::RenderPaint *paint { nullptr };
+    };
+
+    void clear();
+    // executes the recorded calls in order on the renderer
+    void replay(rive::Renderer *renderer) const;
+    // the same for the commands from begin up to, not including, end
+    void replay(rive::Renderer *renderer, int begin, int end) const;
+
+    // changes with everything that decides the pixels of the commands, 0 in case they can not be compared
+    // paths and paints have to come from RiveQtFactory, their content versions are hashed instead of their content
+    size_t fingerprint() const;
+    size_t fingerprint(int begin, int end) const;
+
+    const QVector<Command> &commands() const { return m_commands; }
+    bool isEmpty() const { return m_commands.isEmpty(); }
+
+    // the arguments of a command, by its index
+    const rive::Mat2D &transformAt(int index) const { return m_transforms[index]; }
+    rive::RenderPath *clipPathAt(int index) const { return m_clipPaths[index]; }
+    const PathDraw &pathDrawAt(int index) const { return m_pathDraws[index]; }
+
+    void save() override;
+    void restore() override;
+    void transform(const rive::Mat2D &transform) override;
+    void drawPath(rive::RenderPath *path, rive::RenderPaint *paint) override;
+    void clipPath(rive::RenderPath *path) override;
+    void drawImage(const rive::RenderImage *image, rive::BlendMode blendMode, float opacity) override;
+    void drawImageMesh(const rive::RenderImage *image,
+                       rive::rcp<rive::RenderBuffer> vertices_f32,
+                       rive::rcp<rive::RenderBuffer> uvCoords_f32,
+                       rive::rcp<rive::RenderBuffer> indices_u16,
+                       uint32_t vertexCount,
+                       uint32_t indexCount,
+                       rive::BlendMode blendMode,
+                       float opacity) override;
+
+private:
+    struct ImageDraw
+    {
+        const rive::RenderImage *image { nullptr };
+        rive::BlendMode blendMode { rive::BlendMode::srcOver };
+        float opacity { 1.0 };
+    };
+
+    // the mesh buffers are handed over by value, so they are kept alive here
+    struct ImageMeshDraw
+    {
+        const rive::RenderImage *image { nullptr };
+        rive::rcp<rive::RenderBuffer> vertices;
+        rive::rcp<rive::RenderBuffer> uvCoords;
+        rive::rcp<rive::RenderBuffer> indices;
+        uint32_t vertexCount { 0 };
+        uint32_t indexCount { 0 };
+        rive::BlendMode blendMode { rive::BlendMode::srcOver };
+        float opacity { 1.0 };
+    };
+
+    QVector<Command> m_commands;
+    QVector<rive::Mat2D> m_transforms;
+    QVector<rive::RenderPath *> m_clipPaths;
+    QVector<PathDraw> m_pathDraws;
+    QVector<ImageDraw> m_imageDraws;
+    QVector<ImageMeshDraw> m_imageMeshDraws;
+};
@@ -0,0 +1,376 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "renderer/riveqtnestedartboardcache.h"
+#include "renderer/riveqtdisplaylist.h"
+#include "renderer/riveqtrhirenderer.h"
+#include "riveqsgrhirendernode.h"
+#include "riveqtpath.h"
+
+#include <rive/artboard.hpp>
+#include <rive/nested_artboard.hpp>
+#include <rive/shapes/shape.hpp>
+#include <rive/shapes/path_composer.hpp>
+
+#include <QQuickWindow>
+#include <QtMath>
+#include <private/qrhi_p.h>
+
+#include <algorithm>
+#include <atomic>
+
+// larger nested artboards are drawn path by path, their texture would cost more memory than it saves
+#define NESTED_ARTBOARD_CACHE_MAX_SIZE 2048
+
+// below this scale the textures would be too coarse to be reused at all
+#define NESTED_ARTBOARD_CACHE_MIN_SCALE 0.0625
+
+struct RiveQtNestedArtboardCache::Target
+{
+    Target(RiveQSGRHIRenderNode *node, QRhi *rhi, const QSize &textureSize);
+    ~Target();
+
+    QSize size;
+    // only A is used, nested artboards drawn from a texture contain srcOver draws only
+    RiveQSGRHIRenderNode::RenderSurface surface;
+    QRhiRenderBuffer *stencilClippingBuffer { nullptr };
+    RiveQtRhiRenderer *renderer { nullptr };
+    // changes whenever the renderer records the nested artboard anew
+    quint64 contentVersion { 0 };
+    // recorded, but not rendered yet
+    bool dirty { false };
+};
+
+RiveQtNestedArtboardCache::Target::Target(RiveQSGRHIRenderNode *node, QRhi *rhi, const QSize &textureSize)
+    : size(textureSize)
+{
+    // the pipelines of the item are used, so the surface has the same format and sample count
+    stencilClippingBuffer = rhi->newRenderBuffer(QRhiRenderBuffer::DepthStencil, size, node->sampleCount());
+    stencilClippingBuffer->create();
+    surface.create(rhi, node->sampleCount(), size, stencilClippingBuffer);
+
+    renderer = new RiveQtRhiRenderer(node->window(), node);
+    renderer->updateViewPort(QRectF(QPointF(0, 0), QSizeF(size)));
+    renderer->setRiveRect(QRectF(QPointF(0, 0), QSizeF(size)));
+    renderer->updateArtboardSize(size);
+    // the surface keeps its content, the first draw overwrites it instead of a clearing pass
+    renderer->setClearByDraw(true);
+}
+
+RiveQtNestedArtboardCache::Target::~Target()
+{
+    delete renderer;
+    surface.cleanUp();
+    stencilClippingBuffer->destroy();
+    stencilClippingBuffer->deleteLater();
+}
+
+static quint64 nextContentVersion()
+{
+    static std::atomic<quint64> version { 0 };
+    return ++version;
+}
+
+static QTransform toQTransform(const rive::Mat2D &m)
+{
+    return QTransform(m[0], m[1], m[2], m[3], m[4], m[5]);
+}
+
+static void collectPaths(rive::Artboard *artboard, int owner, QHash<const rive::RenderPath *, int> &pathOwners)
+{
+    for (rive::Core *object : artboard->objects()) {
+        if (!object) {
+            continue;
+        }
+
+        if (object->is<rive::NestedArtboard>()) {
+            rive::Artboard *nestedArtboard = object->as<rive::NestedArtboard>()->artboardInstance();
+            if (nestedArtboard) {
+                collectPaths(nestedArtboard, owner, pathOwners);
+            }
+            continue;
+        }
+
+        if (!object->is<rive::Shape>()) {
+            continue;
+        }
+
+        const rive::PathComposer *pathComposer = object->as<rive::Shape>()->pathComposer();
+        if (auto *localPath = pathComposer->localPath()) {
+            pathOwners.insert(static_cast<RiveQtPath *>(localPath), owner);
+        }
+        if (auto *worldPath = pathComposer->worldPath()) {
+            pathOwners.insert(static_cast<RiveQtPath *>(worldPath), owner);
+        }
+    }
+}
+
+void RiveQtNestedArtboardCache::setArtboard(rive::Artboard *artboard)
+{
+    if (artboard == m_artboard) {
+        return;
+    }
+
+    clear();
+    m_artboard = artboard;
+    if (!artboard) {
+        return;
+    }
+
+    int owner = 0;
+    for (rive::Core *object : artboard->objects()) {
+        if (!object || !object->is<rive::NestedArtboard>()) {
+            continue;
+        }
+
+        rive::Artboard *nestedArtboard = object->as<rive::NestedArtboard>()->artboardInstance();
+        if (nestedArtboard) {
+            collectPaths(nestedArtboard, owner++, m_pathOwners);
+        }
+    }
+
+    m_entries.resize(owner);
+}
+
+void RiveQtNestedArtboardCache::clear()
+{
+    m_artboard = nullptr;
+    m_pathOwners.clear();
+    m_entries.clear();
+}
+
+void RiveQtNestedArtboardCache::replay(const RiveQtDisplayList &displayList, RiveQSGRHIRenderNode *node, RiveQtRhiRenderer *renderer,
+                                       float pixelScale)
+{
+    const QVector<Block> blocks = m_pathOwners.isEmpty() ? QVector<Block>() : findBlocks(displayList);
+
+    int position = 0;
+    for (const Block &block : blocks) {
+        // the scale is rounded up, so the texture is never magnified
+        const QTransform &transform = block.transform;
+        const qreal scale = pixelScale * qMax(qSqrt(transform.m11() * transform.m11() + transform.m12() * transform.m12()),
+                                              qSqrt(transform.m21() * transform.m21() + transform.m22() * transform.m22()));
+        const qreal bucket = qPow(2.0, qCeil(std::log2(qMax(scale, NESTED_ARTBOARD_CACHE_MIN_SCALE))));
+
+        Entry &entry = m_entries[block.owner];
+        if (!updateEntry(displayList, block, bucket, entry, node, renderer)) {
+            continue;
+        }
+
+        displayList.replay(renderer, position, block.begin);
+
+        // the texture is drawn at its pixel size, scaled back into the coordinates of the block
+        const float inverseScale = 1.0 / entry.scale;
+        renderer->save();
+        renderer->transform(rive::Mat2D(inverseScale, 0.0f, 0.0f, inverseScale, entry.origin.x(), entry.origin.y()));
+        renderer->drawTexture(entry.target->surface.texture, entry.target->size, entry.target->contentVersion);
+        renderer->restore();
+
+        position = block.end + 1;
+    }
+
+    displayList.replay(renderer, position, displayList.commands().count());
+}
+
+void RiveQtNestedArtboardCache::render(RiveQSGRHIRenderNode *node, QRhiCommandBuffer *commandBuffer)
+{
+    for (Entry &entry : m_entries) {
+        if (!entry.target || !entry.target->dirty) {
+            continue;
+        }
+
+        node->redirectRenderSurfaces(&entry.target->surface);
+        entry.target->renderer->render(commandBuffer);
+        node->restoreRenderSurfaces();
+        entry.target->dirty = false;
+    }
+}
+
+QVector<RiveQtNestedArtboardCache::Block> RiveQtNestedArtboardCache::findBlocks(const RiveQtDisplayList &displayList) const
+{
+    const QVector<RiveQtDisplayList::Command> &commands = displayList.commands();
+
+    // the saves enclosing all draws of a nested artboard so far, the innermost one is where it is drawn
+    QVector<QVector<int>> enclosingSaves(m_entries.count());
+    QVector<bool> drawn(m_entries.count(), false);
+    QVector<int> matchingRestores(commands.count(), -1);
+    QVector<QTransform> saveTransforms(commands.count());
+
+    QVector<int> saves;
+    QVector<QTransform> transforms;
+    QTransform transform;
+
+    for (int i = 0; i < commands.count(); ++i) {
+        const RiveQtDisplayList::Command &command = commands[i];
+        switch (command.type) {
+        case RiveQtDisplayList::CommandType::Save:
+            saves.append(i);
+            transforms.append(transform);
+            saveTransforms[i] = transform;
+            break;
+        case RiveQtDisplayList::CommandType::Restore:
+            if (!saves.isEmpty()) {
+                matchingRestores[saves.takeLast()] = i;
+                transform = transforms.takeLast();
+            }
+            break;
+        case RiveQtDisplayList::CommandType::Transform:
+            transform = toQTransform(displayList.transformAt(command.index)) * transform;
+            break;
+        case RiveQtDisplayList::CommandType::DrawPath: {
+            const int owner = m_pathOwners.value(displayList.pathDrawAt(command.index).path, -1);
+            if (owner < 0) {
+                break;
+            }
+
+            QVector<int> &enclosing = enclosingSaves[owner];
+            if (!drawn[owner]) {
+                drawn[owner] = true;
+                enclosing = saves;
+                break;
+            }
+
+            int common = 0;
+            while (common < enclosing.count() && common < saves.count() && enclosing[common] == saves[common]) {
+                ++common;
+            }
+            enclosing.resize(common);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    QVector<Block> blocks;
+    for (int owner = 0; owner < m_entries.count(); ++owner) {
+        if (!drawn[owner] || enclosingSaves[owner].isEmpty()) {
+            continue;
+        }
+
+        Block block;
+        block.owner = owner;
+        block.begin = enclosingSaves[owner].last();
+        block.end = matchingRestores[block.begin];
+        block.transform = saveTransforms[block.begin];
+        if (block.end >= 0) {
+            blocks.append(block);
+        }
+    }
+
+    std::sort(blocks.begin(), blocks.end(), [](const Block &a, const Block &b) { return a.begin < b.begin; });
+    return blocks;
+}
+
+bool RiveQtNestedArtboardCache::updateEntry(const RiveQtDisplayList &displayList, const Block &block, qreal scale, Entry &entry,
+                                            RiveQSGRHIRenderNode *node, const RiveQtRhiRenderer *renderer) const
+{
+    const QVector<RiveQtDisplayList::Command> &commands = displayList.commands();
+
+    QRectF bounds;
+
+    QVector<QTransform> transforms;
+    QTransform transform;
+
+    for (int i = block.begin; i <= block.end; ++i) {
+        const RiveQtDisplayList::Command &command = commands[i];
+        switch (command.type) {
+        case RiveQtDisplayList::CommandType::Save:
+            transforms.append(transform);
+            break;
+        case RiveQtDisplayList::CommandType::Restore:
+            if (!transforms.isEmpty()) {
+                transform = transforms.takeLast();
+            }
+            break;
+        case RiveQtDisplayList::CommandType::Transform: {
+            transform = toQTransform(displayList.transformAt(command.index)) * transform;
+            break;
+        }
+        case RiveQtDisplayList::CommandType::ClipPath:
+            break;
+        case RiveQtDisplayList::CommandType::DrawPath: {
+            const RiveQtDisplayList::PathDraw &draw = displayList.pathDrawAt(command.index);
+            // the block may contain the background of the nested artboard, but nothing of another one
+            const int owner = m_pathOwners.value(draw.path, block.owner);
+            const RiveQtPath *path = static_cast<const RiveQtPath *>(draw.path);
+            const RiveQtPaint *paint = static_cast<const RiveQtPaint *>(draw.paint);
+            // only srcOver gives the same result when the texture is blended instead of the paths
+            if (owner != block.owner || !path || !paint || paint->blendMode() != rive::BlendMode::srcOver) {
+                return false;
+            }
+
+            const QPen pen = paint->pen();
+            const bool stroke = paint->paintStyle() == rive::RenderPaintStyle::stroke;
+
+            QRectF pathBounds = path->controlPointBounds();
+            if (stroke) {
+                const qreal margin = pen.widthF() * (pen.joinStyle() == Qt::MiterJoin ? qMax(pen.miterLimit(), 1.0) : 1.0);
+                pathBounds.adjust(-margin, -margin, margin, margin);
+            }
+            pathBounds = transform.mapRect(pathBounds);
+            bounds = bounds.isEmpty() ? pathBounds : bounds.united(pathBounds);
+            break;
+        }
+        default:
+            // images and meshes are drawn as they are
+            return false;
+        }
+    }
+
+    // everything that decides the pixels of the block, in the coordinates of the block
+    const size_t fingerprint = qHashMulti(displayList.fingerprint(block.begin, block.end + 1), block.owner);
+    if (entry.target && entry.fingerprint == fingerprint && qFuzzyCompare(entry.scale, scale)) {
+        return true;
+    }
+
+    // one pixel of padding keeps the antialiased edges
+    const QRect textureRect =
+        QRectF(bounds.topLeft() * scale, bounds.size() * scale).toAlignedRect().adjusted(-1, -1, 1, 1);
+    if (bounds.isEmpty() || textureRect.width() > NESTED_ARTBOARD_CACHE_MAX_SIZE
+        || textureRect.height() > NESTED_ARTBOARD_CACHE_MAX_SIZE) {
+        entry = Entry();
+        return false;
+    }
+
+    QQuickWindow *window = node->window();
+    QRhi *rhi = static_cast<QRhi *>(window->rendererInterface()->getResource(window, QSGRendererInterface::RhiResource));
+    if (!rhi) {
+        entry = Entry();
+        return false;
+    }
+
+    // the surface is kept as long as the size fits, a scale change alone mostly keeps it
+    if (!entry.target || entry.target->size != textureRect.size()) {
+        entry.target = std::make_shared<Target>(node, rhi, textureRect.size());
+    }
+
+    Target *target = entry.target.get();
+    target->renderer->setFillRenderMode(renderer->fillRenderMode());
+    target->renderer->setStrokeMode(renderer->strokeMode());
+    target->renderer->setAntialiasingMode(renderer->antialiasingMode());
+
+    // pixels of the texture, row 0 is the top of the nested artboard on every backend
+    QMatrix4x4 projection = rhi->clipSpaceCorrMatrix();
+    const float height = textureRect.height();
+    projection.ortho(0.0f, textureRect.width(), rhi->isYUpInFramebuffer() ? 0.0f : height, rhi->isYUpInFramebuffer() ? height : 0.0f,
+                     -1.0f, 1.0f);
+    target->renderer->setProjectionMatrix(&projection, &projection);
+
+    target->renderer->recycleRiveNodes();
+    target->renderer->save();
+    target->renderer->transform(rive::Mat2D(scale, 0.0f, 0.0f, scale, -textureRect.x(), -textureRect.y()));
+    displayList.replay(target->renderer, block.begin, block.end + 1);
+    target->renderer->restore();
+    target->renderer->flush();
+
+    target->contentVersion = nextContentVersion();
+    target->dirty = true;
+
+    entry.fingerprint = fingerprint;
+    entry.scale = scale;
+    entry.origin = QPointF(textureRect.topLeft()) / scale;
+    return true;
+}
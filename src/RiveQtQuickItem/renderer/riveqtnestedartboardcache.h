@@ -0,0 +1,73 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#pragma once
+
+#include <QHash>
+#include <QPointF>
+#include <QSize>
+#include <QTransform>
+#include <QVector>
+
+#include <memory>
+
+class QRhiCommandBuffer;
+class RiveQtDisplayList;
+class RiveQtRhiRenderer;
+class RiveQSGRHIRenderNode;
+
+namespace rive {
+class Artboard;
+class RenderPath;
+}
+
+// draws nested artboards from a texture instead of path by path, as long as they look the same
+// the texture is rendered with a rhi renderer of its own, at the next power of two of the scale the nested artboard is drawn at
+class RiveQtNestedArtboardCache
+{
+public:
+    // collects which paths belong to which nested artboard, the render paths exist after the first update of the artboard
+    void setArtboard(rive::Artboard *artboard);
+    void clear();
+
+    // replays the display list, pixelScale converts artboard units into pixels of the render target
+    // nested artboards that changed are recorded into the renderers of their textures, render() draws them
+    void replay(const RiveQtDisplayList &displayList, RiveQSGRHIRenderNode *node, RiveQtRhiRenderer *renderer, float pixelScale);
+    // renders the textures recorded since the last call, before the renderer that draws them renders into the same command buffer
+    void render(RiveQSGRHIRenderNode *node, QRhiCommandBuffer *commandBuffer);
+
+private:
+    // the save ... restore range of the display list a nested artboard is drawn in
+    struct Block
+    {
+        int owner { -1 };
+        int begin { 0 };
+        int end { 0 };
+        // at the save, without the pixel scale
+        QTransform transform;
+    };
+
+    // the texture of a nested artboard, with the surface and renderer that draw it
+    struct Target;
+
+    struct Entry
+    {
+        size_t fingerprint { 0 };
+        qreal scale { 0.0 };
+        // top left of the texture in the coordinates of the block
+        QPointF origin;
+        std::shared_ptr<Target> target;
+    };
+
+    QVector<Block> findBlocks(const RiveQtDisplayList &displayList) const;
+    // false in case the block can not be drawn from a texture, then it is replayed as it is
+    bool updateEntry(const RiveQtDisplayList &displayList, const Block &block, qreal scale, Entry &entry, RiveQSGRHIRenderNode *node,
+                     const RiveQtRhiRenderer *renderer) const;
+
+    rive::Artboard *m_artboard { nullptr };
+    // the index of the nested artboard a path belongs to, nested artboards inside of them count to the outer one
+    QHash<const rive::RenderPath *, int> m_pathOwners;
+    QVector<Entry> m_entries;
+};
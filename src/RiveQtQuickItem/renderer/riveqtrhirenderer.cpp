@@ -5,14 +5,125 @@
 
 #include "renderer/riveqtrhirenderer.h"
 #include "rhi/texturetargetnode.h"
+#include "riveqsgrhirendernode.h"
 #include "rqqplogging.h"
 #include "riveqtpath.h"
 
+#include <QHash>
 #include <QVector4D>
 #include <QSGRenderNode>
 #include <QQuickWindow>
+#include <private/qrhi_p.h>
 #include <private/qtriangulator_p.h>
 
+// below this number of independent paths the thread handover costs more than it saves
+#define PARALLEL_TESSELLATION_THRESHOLD 4
+
+// paths reaching this close (in item pixels) to the viewport are still drawn, which covers the antialiasing fringe
+#define CULLING_MARGIN 2.0
+
+// paths with at least this many segments are drawn stencil then cover in automatic fill mode
+// below it the triangulation is cheap and saves the extra stencil pass and the overdraw of the cover
+#define STENCIL_FILL_SEGMENT_THRESHOLD 32
+
+// how many draws back a draw looks for one it can be merged into
+#define INSTANCE_MERGE_WINDOW 64
+
+// how many draws back a draw looks for one with the same pipelines to be grouped with
+#define REORDER_WINDOW 64
+
+// unlike QRectF::intersects this also works for the bounds of horizontal or vertical lines
+static bool overlaps(const QRectF &a, const QRectF &b)
+{
+    return a.left() <= b.right() && b.left() <= a.right() && a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+
+static size_t transformFingerprint(const QMatrix4x4 &transform)
+{
+    return qHashBits(transform.constData(), 16 * sizeof(float));
+}
+
+static void destroyRetainedGeometry(RhiRetainedGeometry *retained)
+{
+    retained->vertexBuffer->destroy();
+    retained->indexBuffer->destroy();
+    delete retained->vertexBuffer;
+    delete retained->indexBuffer;
+    delete retained;
+}
+
+static RiveQtPathInstance pathInstance(const QMatrix4x4 &transform, float opacity)
+{
+    RiveQtPathInstance instance;
+    instance.xAxis = QVector2D(transform(0, 0), transform(1, 0));
+    instance.yAxis = QVector2D(transform(0, 1), transform(1, 1));
+    instance.translation = QVector2D(transform(0, 3), transform(1, 3));
+    instance.opacity = opacity;
+    return instance;
+}
+
+// two triangles covering the rectangle
+static RiveQtPathGeometry rectGeometry(const QRectF &rect)
+{
+    RiveQtPathGeometry geometry;
+    geometry.vertices = { QVector2D(rect.topLeft()), QVector2D(rect.topRight()), QVector2D(rect.bottomRight()),
+                          QVector2D(rect.bottomLeft()) };
+    const quint16 indices[] = { 0, 1, 2, 0, 2, 3 };
+    geometry.indices = QByteArray(reinterpret_cast<const char *>(indices), sizeof(indices));
+    return geometry;
+}
+
+static RiveQtPathGeometry clippingGeometry(const QVector<QPair<QPainterPath, QMatrix4x4>> &clipPathes)
+{
+    if (clipPathes.isEmpty()) {
+        return {};
+    }
+
+    RiveQtPath clipResult;
+    const QPair<QPainterPath, QMatrix4x4> &firstLevel = clipPathes.first();
+
+    clipResult.setQPainterPath(firstLevel.first);
+    clipResult.applyMatrix(firstLevel.second);
+
+    for (int i = 1; i < clipPathes.count(); ++i) {
+        RiveQtPath a;
+        const auto &entry = clipPathes[i];
+        a.setQPainterPath(entry.first);
+        a.applyMatrix(entry.second);
+        clipResult.intersectWith(a.toQPainterPath());
+    }
+
+    return clipResult.fillGeometry();
+}
+
+// runs on the tessellation pool, all draws of one path are handled by the same call
+static void tessellate(RhiPendingGeometry &pendingGeometry)
+{
+    if (pendingGeometry.path) {
+        if (pendingGeometry.stroke && pendingGeometry.strokeMode == RiveRenderSettings::GpuStroking) {
+            pendingGeometry.strokeCenterline = pendingGeometry.path->strokeCenterline();
+        } else if (pendingGeometry.stroke) {
+            pendingGeometry.geometry = pendingGeometry.path->strokeGeometry(pendingGeometry.pen, pendingGeometry.strokeMode);
+        } else if (pendingGeometry.gpuTessellation) {
+            pendingGeometry.curveWedges = pendingGeometry.path->curveWedges();
+            pendingGeometry.geometry = pendingGeometry.curveWedges.coverGeometry;
+        } else if (pendingGeometry.stencilFill) {
+            pendingGeometry.geometry = pendingGeometry.path->coverGeometry();
+            pendingGeometry.stencilGeometry = pendingGeometry.path->stencilFanGeometry();
+        } else {
+            pendingGeometry.geometry = pendingGeometry.path->fillGeometry();
+        }
+    }
+
+    if (pendingGeometry.path && pendingGeometry.antialiasingFringe) {
+        // strokes get their fringe from the centre line with the stroke pen, fills from their closed outline
+        pendingGeometry.fringeOutline =
+            pendingGeometry.stroke ? pendingGeometry.path->strokeCenterline() : pendingGeometry.path->fillOutline();
+    }
+
+    pendingGeometry.clippingGeometry = clippingGeometry(pendingGeometry.clipPathes);
+}
+
 RiveQtRhiRenderer::RiveQtRhiRenderer(QQuickWindow *window, RiveQSGRHIRenderNode *node)
     : rive::Renderer()
     , m_window(window)
@@ -26,6 +137,47 @@ RiveQtRhiRenderer::~RiveQtRhiRenderer()
     for (TextureTargetNode *textureTargetNode : std::as_const(m_renderNodes)) {
         delete textureTargetNode;
     }
+    delete m_damageClearNode;
+
+    for (const RetainedArtboard &retainedArtboard : std::as_const(m_retainedArtboards)) {
+        for (RhiRetainedGeometry *retained : retainedArtboard.geometry) {
+            destroyRetainedGeometry(retained);
+        }
+    }
+}
+
+void RiveQtRhiRenderer::setArtboardInstance(const std::shared_ptr<rive::ArtboardInstance> &artboardInstance)
+{
+    m_artboardInstance = artboardInstance.get();
+
+    // an instance created where a dropped one was must not find its geometry
+    RetainedArtboard &retainedArtboard = m_retainedArtboards[m_artboardInstance];
+    if (retainedArtboard.artboardInstance.expired()) {
+        for (RhiRetainedGeometry *retained : std::as_const(retainedArtboard.geometry)) {
+            destroyRetainedGeometry(retained);
+        }
+        retainedArtboard.geometry.clear();
+        retainedArtboard.artboardInstance = artboardInstance;
+    }
+}
+
+void RiveQtRhiRenderer::releaseExpiredRetainedGeometry()
+{
+    for (auto it = m_retainedArtboards.begin(); it != m_retainedArtboards.end();) {
+        if (!it->artboardInstance.expired()) {
+            ++it;
+            continue;
+        }
+
+        qCDebug(rqqpRendering) << "Releasing" << it->geometry.count() << "retained geometries of a dropped artboard instance";
+        for (RhiRetainedGeometry *retained : std::as_const(it->geometry)) {
+            destroyRetainedGeometry(retained);
+        }
+        if (it.key() == m_artboardInstance) {
+            m_artboardInstance = nullptr;
+        }
+        it = m_retainedArtboards.erase(it);
+    }
 }
 
 void RiveQtRhiRenderer::setRiveRect(const QRectF &bounds)
@@ -68,21 +220,22 @@ void RiveQtRhiRenderer::drawPath(rive::RenderPath *path, rive::RenderPaint *pain
     RiveQtPath *qtPath = static_cast<RiveQtPath *>(path);
     RiveQtPaint *qtPaint = static_cast<RiveQtPaint *>(paint);
 
-    QVector<QVector<QVector2D>> pathData;
-
-    if (qtPaint->paintStyle() == rive::RenderPaintStyle::fill) {
-        pathData = qtPath->toVertices();
-    }
+    QColor color = qtPaint->color();
 
-    if (qtPaint->paintStyle() == rive::RenderPaintStyle::stroke) {
-        pathData = qtPath->toVerticesLine(qtPaint->pen());
+    // a static shape outside of the viewport keeps its buffers until it comes back
+    if (qtPath->isRetained()) {
+        m_retainedPaths.insert(qtPath);
     }
 
-    QColor color = qtPaint->color();
+    m_rhiRenderStack.back().opacity = qtPaint->opacity();
 
-    TextureTargetNode *node = getRiveDrawTargetNode();
+    // rejected before anything is tessellated or a node is taken
+    const QRectF bounds = drawBounds(qtPath, qtPaint);
+    if (isCulled(qtPath, qtPaint, bounds)) {
+        return;
+    }
 
-    m_rhiRenderStack.back().opacity = qtPaint->opacity();
+    TextureTargetNode *node = getRiveDrawTargetNode(qtPath, qtPaint);
 
     // opacity is used to apply the strength of the blending effect/layer, though
     // for some reason it looks like it failes in case gradients are used
@@ -96,32 +249,50 @@ void RiveQtRhiRenderer::drawPath(rive::RenderPath *path, rive::RenderPaint *pain
         node->setGradient(qtPaint->brush().gradient());
     }
 
-    RiveQtPath clipResult;
-    if (!m_rhiRenderStack.back().m_allClipPainterPathesApplied.empty()) {
-        QPair<QPainterPath, QMatrix4x4> firstLevel = m_rhiRenderStack.back().m_allClipPainterPathesApplied.first();
-
-        clipResult.setQPainterPath(firstLevel.first);
-        clipResult.applyMatrix(firstLevel.second);
-
-        for (int i = 1; i < m_rhiRenderStack.back().m_allClipPainterPathesApplied.count(); ++i) {
-            RiveQtPath a;
-            const auto &entry = m_rhiRenderStack.back().m_allClipPainterPathesApplied[i];
-            a.setQPainterPath(entry.first);
-            a.applyMatrix(entry.second);
-            clipResult.intersectWith(a.toQPainterPath());
-        }
-
-        // #if 0 // this allows to draw the clipping area which it useful for debugging :)
-        //    TextureTargetNode *drawClipping = getRiveDrawTargetNode();
-        //    drawClipping->setOpacity(currentOpacity()); // inherit the opacity from the parent
-        //    drawClipping->setColor(QColor(255, 0, 0, 29));
-        //    drawClipping->updateGeometry(clipResult.toVertices(), QMatrix4x4());
-        //  #endif
-
-        node->updateClippingGeometry(clipResult.toVertices());
+    // the geometry is tessellated in flush(), together with all other paths of this frame
+    RhiPendingGeometry pendingGeometry;
+    pendingGeometry.node = node;
+    pendingGeometry.path = rive::ref_rcp(qtPath);
+    pendingGeometry.stroke = qtPaint->paintStyle() == rive::RenderPaintStyle::stroke;
+    if (pendingGeometry.stroke) {
+        pendingGeometry.pen = qtPaint->pen();
+        pendingGeometry.strokeMode = m_strokeMode;
+    } else {
+        pendingGeometry.stencilFill = useStencilFill(qtPath);
+        pendingGeometry.gpuTessellation = m_fillRenderMode == RiveRenderSettings::GpuTessellatedFill;
     }
-
-    node->updateGeometry(pathData, transformMatrix());
+    pendingGeometry.antialiasingFringe = m_antialiasingMode == RiveRenderSettings::AnalyticAntialiasing;
+    pendingGeometry.retained = qtPath->isRetained();
+    pendingGeometry.transform = transformMatrix();
+    pendingGeometry.opacity = currentOpacity();
+
+    const RhiRenderState &renderState = m_rhiRenderStack.back();
+    pendingGeometry.clipPathes = renderState.m_allClipPainterPathesApplied;
+
+    const QPen pen = qtPaint->pen();
+
+    // instances share the plain draw pipeline, the stencil based draws and the blend shader need a node each
+    if (pendingGeometry.clipPathes.isEmpty() && !pendingGeometry.stencilFill && !pendingGeometry.gpuTessellation
+        && !pendingGeometry.antialiasingFringe && !node->isShaderBlending()
+        && !(pendingGeometry.stroke && pendingGeometry.strokeMode == RiveRenderSettings::GpuStroking)) {
+        const QRectF clipRect = renderState.hasClipRect ? renderState.clipRect : QRectF();
+        // plain colors can be shared between paints, gradients only within the same version of a paint
+        const quint64 gradientVersion = qtPaint->brush().gradient() ? qtPaint->contentVersion() : 0;
+        pendingGeometry.instanceKey =
+            qHashMulti(0, quintptr(qtPath), color.rgba(), gradientVersion, int(qtPaint->blendMode()),
+                       int(pendingGeometry.stroke), pendingGeometry.stroke ? pen.widthF() : 0.0, int(pen.joinStyle()), int(pen.capStyle()),
+                       pen.miterLimit(), int(renderState.hasClipRect), clipRect.x(), clipRect.y(), clipRect.width(), clipRect.height(),
+                       int(pendingGeometry.retained));
+    }
+    pendingGeometry.record.fingerprint =
+        qHashMulti(renderState.clipFingerprint, quintptr(qtPath), qtPath->contentVersion(), color.rgba(),
+                   qtPaint->contentVersion(), int(qtPaint->blendMode()), currentOpacity(), int(pendingGeometry.stroke),
+                   pen.widthF(), int(pen.joinStyle()), int(pen.capStyle()), pen.miterLimit(), transformFingerprint(transformMatrix()),
+                   int(m_fillRenderMode), int(m_strokeMode), int(m_antialiasingMode));
+    pendingGeometry.record.bounds = renderState.hasClipRect ? bounds.intersected(renderState.clipRect) : bounds;
+    pendingGeometry.record.bounded = true;
+    pendingGeometry.record.shaderBlending = node->isShaderBlending();
+    m_pendingGeometry.append(pendingGeometry);
 }
 
 void RiveQtRhiRenderer::clipPath(rive::RenderPath *path)
@@ -132,13 +303,24 @@ void RiveQtRhiRenderer::clipPath(rive::RenderPath *path)
     RiveQtPath *qtPath = static_cast<RiveQtPath *>(path);
     assert(qtPath != nullptr);
 
+    m_rhiRenderStack.back().clipFingerprint = qHashMulti(m_rhiRenderStack.back().clipFingerprint, quintptr(qtPath),
+                                                         qtPath->contentVersion(), transformFingerprint(transformMatrix()));
+
+    QRectF rect;
+    if (qtPath->isAxisAlignedRect(transformMatrix(), rect)) {
+        RhiRenderState &renderState = m_rhiRenderStack.back();
+        renderState.clipRect = renderState.hasClipRect ? renderState.clipRect.intersected(rect) : rect;
+        renderState.hasClipRect = true;
+        return;
+    }
+
     m_rhiRenderStack.back().m_allClipPainterPathesApplied.push_back(
         QPair<QPainterPath, QMatrix4x4>(qtPath->toQPainterPath(), transformMatrix()));
 }
 
 void RiveQtRhiRenderer::drawImage(const rive::RenderImage *image, rive::BlendMode blendMode, float opacity)
 {
-    TextureTargetNode *node = getRiveDrawTargetNode();
+    TextureTargetNode *node = getRiveDrawTargetNode(image);
 
     m_rhiRenderStack.back().opacity = opacity;
     node->setOpacity(currentOpacity()); // inherit the opacity from the parent
@@ -149,28 +331,15 @@ void RiveQtRhiRenderer::drawImage(const rive::RenderImage *image, rive::BlendMod
                      /* recreate= */ true,
                      transformMatrix()); //
 
-    RiveQtPath clipResult;
-    QPair<QPainterPath, QMatrix4x4> firstLevel = m_rhiRenderStack.back().m_allClipPainterPathesApplied.first();
-
-    clipResult.setQPainterPath(firstLevel.first);
-    clipResult.applyMatrix(firstLevel.second);
-
-    for (int i = 1; i < m_rhiRenderStack.back().m_allClipPainterPathesApplied.count(); ++i) {
-        RiveQtPath a;
-        const auto &entry = m_rhiRenderStack.back().m_allClipPainterPathesApplied[i];
-        a.setQPainterPath(entry.first);
-        a.applyMatrix(entry.second);
-        clipResult.intersectWith(a.toQPainterPath());
-    }
-
-    // #if 0 // this allows to draw the clipping area which it useful for debugging :)
-    //    TextureTargetNode *drawClipping = getRiveDrawTargetNode();
-    //    drawClipping->setOpacity(currentOpacity()); // inherit the opacity from the parent
-    //    drawClipping->setColor(QColor(255, 0, 0, 29));
-    //    drawClipping->updateGeometry(clipResult.toVertices(), QMatrix4x4());
-    //  #endif
-
-    node->updateClippingGeometry(clipResult.toVertices());
+    // images only need their clipping to be tessellated
+    RhiPendingGeometry pendingGeometry;
+    pendingGeometry.node = node;
+    pendingGeometry.clipPathes = m_rhiRenderStack.back().m_allClipPainterPathesApplied;
+    // the image itself never changes, but its bounds are unknown
+    pendingGeometry.record.fingerprint = qHashMulti(m_rhiRenderStack.back().clipFingerprint, quintptr(image), int(blendMode),
+                                                    currentOpacity(), transformFingerprint(transformMatrix()));
+    pendingGeometry.record.shaderBlending = node->isShaderBlending();
+    m_pendingGeometry.append(pendingGeometry);
 }
 
 void RiveQtRhiRenderer::drawImageMesh(const rive::RenderImage *image, rive::rcp<rive::RenderBuffer> vertices_f32,
@@ -178,7 +347,7 @@ void RiveQtRhiRenderer::drawImageMesh(const rive::RenderImage *image, rive::rcp<
                                       uint32_t vertexCount, uint32_t indexCount, rive::BlendMode blendMode, float opacity)
 {
 
-    TextureTargetNode *node = getRiveDrawTargetNode();
+    TextureTargetNode *node = getRiveDrawTargetNode(image);
 
     m_rhiRenderStack.back().opacity = opacity;
 
@@ -190,55 +359,278 @@ void RiveQtRhiRenderer::drawImageMesh(const rive::RenderImage *image, rive::rcp<
                      /* recreate= */ false,
                      transformMatrix()); //
 
-    RiveQtPath clipResult;
-    QPair<QPainterPath, QMatrix4x4> firstLevel = m_rhiRenderStack.back().m_allClipPainterPathesApplied.first();
+    // images only need their clipping to be tessellated
+    RhiPendingGeometry pendingGeometry;
+    pendingGeometry.node = node;
+    pendingGeometry.clipPathes = m_rhiRenderStack.back().m_allClipPainterPathesApplied;
+    // the mesh is deformed in place, so the draw is never compared (fingerprint 0)
+    pendingGeometry.record.shaderBlending = node->isShaderBlending();
+    m_pendingGeometry.append(pendingGeometry);
+}
 
-    clipResult.setQPainterPath(firstLevel.first);
-    clipResult.applyMatrix(firstLevel.second);
+void RiveQtRhiRenderer::drawTexture(QRhiTexture *texture, const QSize &size, quint64 contentVersion)
+{
+    TextureTargetNode *node = getRiveDrawTargetNode(texture);
+
+    node->setOpacity(currentOpacity());
+    node->setBlendMode(rive::BlendMode::srcOver);
+    node->setTexture(texture, size, transformMatrix());
+
+    // textures only need their clipping to be tessellated
+    RhiPendingGeometry pendingGeometry;
+    pendingGeometry.node = node;
+    pendingGeometry.clipPathes = m_rhiRenderStack.back().m_allClipPainterPathesApplied;
+    // the texture stays the same for as long as its content version does
+    pendingGeometry.record.fingerprint = qHashMulti(m_rhiRenderStack.back().clipFingerprint, quintptr(texture), contentVersion,
+                                                    currentOpacity(), transformFingerprint(transformMatrix()));
+    pendingGeometry.record.bounds = transformMatrix().mapRect(QRectF(QPointF(0, 0), QSizeF(size)));
+    pendingGeometry.record.bounded = true;
+    pendingGeometry.record.shaderBlending = node->isShaderBlending();
+    m_pendingGeometry.append(pendingGeometry);
+}
 
-    for (int i = 1; i < m_rhiRenderStack.back().m_allClipPainterPathesApplied.count(); ++i) {
-        RiveQtPath a;
-        const auto &entry = m_rhiRenderStack.back().m_allClipPainterPathesApplied[i];
-        a.setQPainterPath(entry.first);
-        a.applyMatrix(entry.second);
-        clipResult.intersectWith(a.toQPainterPath());
+bool RiveQtRhiRenderer::keepFrame(size_t displayListFingerprint)
+{
+    const size_t fingerprint = displayListFingerprint == 0
+        ? 0
+        : qHashMulti(displayListFingerprint, transformFingerprint(m_combinedMatrix), int(m_fillRenderMode), int(m_strokeMode),
+                     int(m_antialiasingMode), m_viewportRect.width(), m_viewportRect.height());
+    const bool keep = fingerprint != 0 && m_hasPreviousFrame && fingerprint == m_previousDisplayListFingerprint;
+    m_previousDisplayListFingerprint = fingerprint;
+    if (!keep) {
+        return false;
+    }
+
+    // the draws of the last frame keep their nodes for the next one
+    m_drawNodes = m_previousDrawNodes;
+    m_keepRetainedGeometry = true;
+    m_frameUnchanged = true;
+    return true;
+}
+
+void RiveQtRhiRenderer::flush()
+{
+    updateDamage();
+
+    m_drawOrder.clear();
+
+    if (m_frameUnchanged) {
+        for (const RhiPendingGeometry &pending : std::as_const(m_pendingGeometry)) {
+            pending.node->recycle();
+        }
+        m_pendingGeometry.clear();
+        return;
+    }
+
+    if (m_partialDamage) {
+        // draws outside of the damaged area keep what the surface already shows
+        m_pendingGeometry.removeIf([this](const RhiPendingGeometry &pending) {
+            if (pending.record.bounded && !overlaps(pending.record.bounds, m_damageRect)) {
+                pending.node->recycle();
+                return true;
+            }
+            pending.node->intersectScissorRect(m_damageRect);
+            return false;
+        });
+
+        if (!m_damageRect.isEmpty()) {
+            clearRect(m_damageRect);
+        }
+    } else if (m_clearByDraw) {
+        // only the artboard is shown of the surface, what is drawn beyond it does not need to be cleared
+        clearRect(QRectF(QPointF(0, 0), QSizeF(m_artboardSize)));
+    }
+
+    if (m_pendingGeometry.isEmpty()) {
+        return;
+    }
+
+    // draws of the same path share its caches, so they have to end up in the same batch
+    QVector<QVector<int>> batches;
+    QHash<RiveQtPath *, int> pathBatches;
+    for (int i = 0; i < m_pendingGeometry.count(); ++i) {
+        RiveQtPath *path = m_pendingGeometry[i].path.get();
+        if (!path) {
+            batches.append({ i });
+            continue;
+        }
+
+        const auto it = pathBatches.constFind(path);
+        if (it == pathBatches.constEnd()) {
+            pathBatches.insert(path, batches.count());
+            batches.append({ i });
+        } else {
+            batches[it.value()].append(i);
+        }
+    }
+
+    RhiPendingGeometry *pendingGeometry = m_pendingGeometry.data();
+
+    if (batches.count() < PARALLEL_TESSELLATION_THRESHOLD || m_tessellationPool.maxThreadCount() < 2) {
+        for (const auto &batch : std::as_const(batches)) {
+            for (const int index : batch) {
+                tessellate(pendingGeometry[index]);
+            }
+        }
+    } else {
+        for (const auto &batch : std::as_const(batches)) {
+            m_tessellationPool.start([pendingGeometry, &batch]() {
+                for (const int index : batch) {
+                    tessellate(pendingGeometry[index]);
+                }
+            });
+        }
+        m_tessellationPool.waitForDone();
+    }
+
+    mergeInstances();
+
+    // hand over in the order rive issued the draws, render() may draw them in another one
+    for (const RhiPendingGeometry &pending : std::as_const(m_pendingGeometry)) {
+        if (!pending.clipPathes.isEmpty()) {
+            pending.node->updateClippingGeometry(pending.clippingGeometry);
+        }
+
+        if (pending.stroke && pending.strokeMode == RiveRenderSettings::GpuStroking) {
+            pending.node->updateStrokeCenterline(pending.strokeCenterline, pending.pen, pending.transform);
+        } else if (pending.path && pending.retained && !pending.geometry.indices.isEmpty()) {
+            pending.node->updateGeometry(pending.geometry, pending.transform, retainedGeometry(pending.path.get(), pending.geometry));
+        } else if (pending.path) {
+            pending.node->updateGeometry(pending.geometry, pending.transform);
+        }
+
+        if (!pending.instances.isEmpty()) {
+            pending.node->updatePathInstances(pending.instances);
+        }
+
+        if (pending.gpuTessellation) {
+            pending.node->updateCurveWedges(pending.curveWedges, pending.path->isEvenOddFill());
+        } else if (pending.stencilFill) {
+            pending.node->updateStencilFillGeometry(pending.stencilGeometry, pending.path->isEvenOddFill());
+        }
+
+        if (pending.antialiasingFringe) {
+            // a fill only needs the fringe itself, bevel joins close it at the corners
+            QPen outlinePen(Qt::NoBrush, 0.0, Qt::SolidLine, Qt::FlatCap, Qt::BevelJoin);
+            pending.node->updateAntialiasingFringe(pending.fringeOutline, pending.stroke ? pending.pen : outlinePen);
+        }
+    }
+
+    updateDrawOrder();
+
+    m_pendingGeometry.clear();
+}
+
+void RiveQtRhiRenderer::clearRect(const QRectF &rect)
+{
+    if (!m_damageClearNode) {
+        m_damageClearNode = new TextureTargetNode(m_window, m_node, m_viewportRect, &m_combinedMatrix, &m_projectionMatrix);
     }
+    m_damageClearNode->take();
+    m_damageClearNode->setOverwrite(true);
+    m_damageClearNode->setColor(QColor(0, 0, 0, 0));
+    m_damageClearNode->setScissorRect(rect);
+    m_damageClearNode->updateGeometry(rectGeometry(rect), QMatrix4x4());
+}
 
-    // #if 0 // this allows to draw the clipping area which it useful for debugging :)
-    //    TextureTargetNode *drawClipping = getRiveDrawTargetNode();
-    //    drawClipping->setOpacity(currentOpacity()); // inherit the opacity from the parent
-    //    drawClipping->setColor(QColor(255, 0, 0, 29));
-    //    drawClipping->updateGeometry(clipResult.toVertices(), QMatrix4x4());
-    //  #endif
+template<typename Function>
+void RiveQtRhiRenderer::forEachNode(const Function &function) const
+{
+    // recycled unless this frame only redraws the damaged area
+    if (m_damageClearNode && !m_damageClearNode->isRecycled()) {
+        function(m_damageClearNode);
+    }
+    for (TextureTargetNode *textureTargetNode : std::as_const(m_drawOrder)) {
+        if (!textureTargetNode->isRecycled()) {
+            function(textureTargetNode);
+        }
+    }
+}
 
-    node->updateClippingGeometry(clipResult.toVertices());
+void RiveQtRhiRenderer::uploadResources(QRhiCommandBuffer *cb) const
+{
+    forEachNode([cb](TextureTargetNode *textureTargetNode) {
+        if (!textureTargetNode->isShaderBlending()) {
+            textureTargetNode->uploadResources(cb);
+        }
+    });
+}
+
+void RiveQtRhiRenderer::recordDraws(QRhiCommandBuffer *cb, RhiPassState &passState) const
+{
+    // consecutive nodes share one pass, a new pass only begins to clear stencil bits the next node would test
+    forEachNode([&](TextureTargetNode *textureTargetNode) {
+        const bool stencilDirty = passState.clipStencil || (passState.fillStencil && textureTargetNode->usesFillStencil());
+        const bool otherTarget = passState.target != m_node->currentRenderTarget(false);
+        if (passState.target && (textureTargetNode->isShaderBlending() || stencilDirty || otherTarget)) {
+            cb->endPass();
+            passState.target = nullptr;
+        }
+
+        // shader blending draws to its own surface and swaps the render surfaces in a pass of its own
+        if (textureTargetNode->isShaderBlending()) {
+            textureTargetNode->render(cb);
+            return;
+        }
+
+        if (!passState.target) {
+            passState.target = m_node->currentRenderTarget(false);
+            passState.clipStencil = false;
+            passState.fillStencil = false;
+            cb->beginPass(passState.target, QColor(0, 0, 0, 0), { 1.0f, 0 });
+        }
+
+        textureTargetNode->recordDraws(cb);
+        passState.clipStencil = passState.clipStencil || textureTargetNode->writesClipStencil();
+        passState.fillStencil = passState.fillStencil || textureTargetNode->usesFillStencil();
+    });
 }
 
 void RiveQtRhiRenderer::render(QRhiCommandBuffer *cb) const
 {
-    for (TextureTargetNode *textureTargetNode : std::as_const(m_renderNodes)) {
-        textureTargetNode->render(cb);
+    // nothing can be uploaded while a pass is recorded, so the uploads of all nodes go first
+    uploadResources(cb);
+
+    RhiPassState passState;
+    recordDraws(cb, passState);
+    if (passState.target) {
+        cb->endPass();
     }
 }
 
-TextureTargetNode *RiveQtRhiRenderer::getRiveDrawTargetNode()
+TextureTargetNode *RiveQtRhiRenderer::getRiveDrawTargetNode(const void *drawable, const void *paint)
 {
-    TextureTargetNode *pathNode = nullptr;
+    // culled, merged or hidden draws do not shift the later draws to other nodes
+    const size_t drawableKey = qHashMulti(0, quintptr(drawable), quintptr(paint));
+    const size_t drawKey = qHashMulti(drawableKey, m_drawOccurrences[drawableKey]++);
 
-    for (TextureTargetNode *textureTargetNode : std::as_const(m_renderNodes)) {
-        if (textureTargetNode->isRecycled()) {
+    TextureTargetNode *pathNode = m_previousDrawNodes.value(drawKey);
+    if (pathNode && !pathNode->isRecycled()) {
+        pathNode = nullptr;
+    }
+
+    for (int i = 0; !pathNode && i < m_renderNodes.count(); ++i) {
+        TextureTargetNode *textureTargetNode = m_renderNodes[i];
+        if (textureTargetNode->isRecycled() && !m_reservedNodes.contains(textureTargetNode)) {
             pathNode = textureTargetNode;
-            pathNode->take();
-            break;
         }
     }
 
     if (!pathNode) {
         pathNode = new TextureTargetNode(m_window, m_node, m_viewportRect, &m_combinedMatrix, &m_projectionMatrix);
-        pathNode->take();
         m_renderNodes.append(pathNode);
     }
 
+    pathNode->take();
+    m_reservedNodes.remove(pathNode);
+    m_drawNodes.insert(drawKey, pathNode);
+
+    // every draw inherits the rectangle clip of the current state
+    const RhiRenderState &renderState = m_rhiRenderStack.back();
+    if (renderState.hasClipRect) {
+        pathNode->setScissorRect(renderState.clipRect);
+    }
+
     return pathNode;
 }
 
@@ -250,20 +642,368 @@ void RiveQtRhiRenderer::setProjectionMatrix(const QMatrix4x4 *projectionMatrix,
 
 void RiveQtRhiRenderer::updateViewPort(const QRectF &viewportRect)
 {
+    m_pendingGeometry.clear();
+    m_drawOrder.clear();
+
     while (!m_renderNodes.empty()) {
         auto *textureTargetNode = m_renderNodes.last();
         m_renderNodes.removeAll(textureTargetNode);
         delete textureTargetNode;
     }
 
+    delete m_damageClearNode;
+    m_damageClearNode = nullptr;
+
+    m_drawNodes.clear();
+    m_previousDrawNodes.clear();
+    m_drawOccurrences.clear();
+    m_reservedNodes.clear();
+
+    // the new surface starts empty
+    m_hasPreviousFrame = false;
+    m_previousDrawRecords.clear();
+
     m_viewportRect = viewportRect;
 }
 
 void RiveQtRhiRenderer::recycleRiveNodes()
 {
+    releaseUnusedRetainedGeometry();
+
+    m_pendingGeometry.clear();
+    m_drawOrder.clear();
+    m_partialDamage = false;
+    m_frameUnchanged = false;
+
     for (TextureTargetNode *textureTargetNode : std::as_const(m_renderNodes)) {
         textureTargetNode->recycle();
     }
+
+    // a node stays with its draw as long as the draw happens every frame
+    m_previousDrawNodes = std::move(m_drawNodes);
+    m_drawNodes.clear();
+    m_drawOccurrences.clear();
+    m_reservedNodes.clear();
+    for (TextureTargetNode *textureTargetNode : std::as_const(m_previousDrawNodes)) {
+        m_reservedNodes.insert(textureTargetNode);
+    }
+
+    if (m_damageClearNode) {
+        m_damageClearNode->recycle();
+    }
+}
+
+bool RiveQtRhiRenderer::useStencilFill(const RiveQtPath *path) const
+{
+    switch (m_fillRenderMode) {
+    case RiveRenderSettings::TriangulatedFill:
+        return false;
+    case RiveRenderSettings::StencilCoverFill:
+    case RiveRenderSettings::GpuTessellatedFill:
+        return true;
+    case RiveRenderSettings::AutomaticFill:
+    default:
+        return path->segmentCount() >= STENCIL_FILL_SEGMENT_THRESHOLD;
+    }
+}
+
+QRectF RiveQtRhiRenderer::drawBounds(const RiveQtPath *path, const RiveQtPaint *paint) const
+{
+    QRectF bounds = path->controlPointBounds();
+    if (paint->paintStyle() == rive::RenderPaintStyle::stroke) {
+        // miter joins reach out up to the miter limit, square caps and all other joins less than the pen width
+        const QPen pen = paint->pen();
+        const qreal margin = pen.widthF() * (pen.joinStyle() == Qt::MiterJoin ? qMax(pen.miterLimit(), 1.0) : 1.0);
+        bounds.adjust(-margin, -margin, margin, margin);
+    }
+    return transformMatrix().mapRect(bounds);
+}
+
+bool RiveQtRhiRenderer::isCulled(const RiveQtPath *path, const RiveQtPaint *paint, const QRectF &bounds) const
+{
+    if (path->isEmpty()) {
+        return true;
+    }
+
+    const QColor color = paint->color();
+    if ((color.isValid() && color.alpha() == 0) || qFuzzyIsNull(currentOpacity())) {
+        return true;
+    }
+
+    const RhiRenderState &renderState = m_rhiRenderStack.back();
+    if (renderState.hasClipRect && (renderState.clipRect.isEmpty() || !overlaps(renderState.clipRect, bounds))) {
+        return true;
+    }
+
+    for (const auto &clip : renderState.m_allClipPainterPathesApplied) {
+        if (!overlaps(clip.second.mapRect(clip.first.controlPointRect()), bounds)) {
+            return true;
+        }
+    }
+
+    if (m_viewportRect.isEmpty()) {
+        return false;
+    }
+
+    // the viewport in normalized device coordinates, widened by the margin
+    const QRectF deviceBounds = m_combinedMatrix.mapRect(bounds);
+    const qreal marginX = 2.0 * CULLING_MARGIN / m_viewportRect.width();
+    const qreal marginY = 2.0 * CULLING_MARGIN / m_viewportRect.height();
+    const QRectF visibleArea(-1.0 - marginX, -1.0 - marginY, 2.0 + 2.0 * marginX, 2.0 + 2.0 * marginY);
+    return !overlaps(visibleArea, deviceBounds);
+}
+
+void RiveQtRhiRenderer::updateDamage()
+{
+    QVector<RhiDrawRecord> drawRecords;
+    drawRecords.reserve(m_pendingGeometry.count());
+    size_t frameFingerprint = qHashMulti(0, m_pendingGeometry.count(), transformFingerprint(m_combinedMatrix));
+    bool comparableFrame = true;
+    for (const RhiPendingGeometry &pending : std::as_const(m_pendingGeometry)) {
+        drawRecords.append(pending.record);
+        frameFingerprint = qHashMulti(frameFingerprint, pending.record.fingerprint);
+        comparableFrame = comparableFrame && pending.record.fingerprint != 0;
+    }
+
+    // independent of the damage tracking, an unchanged frame does not even need the surface to be touched
+    m_frameUnchanged = comparableFrame && m_hasPreviousFrame && frameFingerprint == m_previousFrameFingerprint;
+    m_previousFrameFingerprint = frameFingerprint;
+
+    // the margin covers the antialiasing fringe and the rounding to pixels
+    QSizeF margin;
+    bool partialDamage =
+        m_damageTrackingEnabled && m_hasPreviousFrame && m_previousCombinedMatrix == m_combinedMatrix && artboardMargin(margin);
+    QRectF damageRect;
+
+    // draws are compared by their position, an inserted draw damages everything behind it
+    const int count = qMax(drawRecords.count(), m_previousDrawRecords.count());
+    for (int i = 0; partialDamage && i < count; ++i) {
+        const RhiDrawRecord *current = i < drawRecords.count() ? &drawRecords[i] : nullptr;
+        const RhiDrawRecord *previous = i < m_previousDrawRecords.count() ? &m_previousDrawRecords[i] : nullptr;
+
+        // shader blending ends on either surface, the other one is not complete
+        if ((current && current->shaderBlending) || (previous && previous->shaderBlending)) {
+            partialDamage = false;
+            break;
+        }
+
+        if (current && previous && current->fingerprint != 0 && current->fingerprint == previous->fingerprint) {
+            continue;
+        }
+
+        // where the draw was and where it is now
+        for (const RhiDrawRecord *record : { current, previous }) {
+            if (!record) {
+                continue;
+            }
+            if (!record->bounded) {
+                partialDamage = false;
+                break;
+            }
+            damageRect = damageRect.isEmpty() ? record->bounds : damageRect.united(record->bounds);
+        }
+    }
+
+    if (partialDamage && !damageRect.isEmpty()) {
+        damageRect.adjust(-margin.width(), -margin.height(), margin.width(), margin.height());
+    }
+
+    m_partialDamage = partialDamage;
+    m_damageRect = damageRect;
+
+    m_previousDrawRecords = drawRecords;
+    m_previousCombinedMatrix = m_combinedMatrix;
+    m_hasPreviousFrame = true;
+}
+
+bool RiveQtRhiRenderer::artboardMargin(QSizeF &margin) const
+{
+    const QRectF unitRect = m_combinedMatrix.mapRect(QRectF(0, 0, 1, 1));
+    const qreal pixelsPerUnitX = unitRect.width() * m_viewportRect.width() / 2.0;
+    const qreal pixelsPerUnitY = unitRect.height() * m_viewportRect.height() / 2.0;
+    if (pixelsPerUnitX <= 0.0 || pixelsPerUnitY <= 0.0) {
+        return false;
+    }
+
+    margin = QSizeF(CULLING_MARGIN / pixelsPerUnitX, CULLING_MARGIN / pixelsPerUnitY);
+    return true;
+}
+
+void RiveQtRhiRenderer::updateDrawOrder()
+{
+    const int count = m_pendingGeometry.count();
+    m_drawOrder.reserve(count);
+
+    QSizeF margin;
+    const bool reorder = artboardMargin(margin);
+
+    QVector<size_t> keys(count);
+    QVector<QRectF> bounds(count);
+    for (int i = 0; reorder && i < count; ++i) {
+        const RhiPendingGeometry &pending = m_pendingGeometry[i];
+        keys[i] = pending.node->stateKey();
+        // the margin keeps antialiased edges that touch from being treated as independent
+        bounds[i] = pending.record.bounds.adjusted(-margin.width(), -margin.height(), margin.width(), margin.height());
+    }
+
+    // images have no bounds and shader blending reads the whole surface, neither moves nor is jumped over
+    const auto isBarrier = [this](int index) {
+        const RhiDrawRecord &record = m_pendingGeometry[index].record;
+        return !record.bounded || record.shaderBlending;
+    };
+
+    // a draw moves up behind the last draw with the same pipelines, but only past draws it does not overlap,
+    // so the result is the same as in painter order
+    QVector<int> order;
+    order.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        int position = order.count();
+        if (reorder && !isBarrier(i)) {
+            const int windowStart = qMax(0, order.count() - REORDER_WINDOW);
+            for (int j = order.count() - 1; j >= windowStart; --j) {
+                const int other = order[j];
+                if (keys[other] == keys[i]) {
+                    position = j + 1;
+                    break;
+                }
+                if (isBarrier(other) || overlaps(bounds[other], bounds[i])) {
+                    break;
+                }
+            }
+        }
+        order.insert(position, i);
+    }
+
+    for (const int index : std::as_const(order)) {
+        m_drawOrder.append(m_pendingGeometry[index].node);
+    }
+}
+
+void RiveQtRhiRenderer::mergeInstances()
+{
+    QSizeF margin;
+    if (!m_node->pathInstancePipeline() || !artboardMargin(margin)) {
+        return;
+    }
+
+    const int count = m_pendingGeometry.count();
+    // the index of the draw a draw was merged into, -1 for draws that stay
+    QVector<int> mergedInto(count, -1);
+    QHash<size_t, int> firstDraws;
+    int mergedCount = 0;
+
+    for (int i = 0; i < count; ++i) {
+        RhiPendingGeometry &pending = m_pendingGeometry[i];
+        // overlapping triangles are drawn once by the stencil, which would also hide overlapping instances
+        if (pending.instanceKey == 0 || pending.geometry.isEmpty() || pending.geometry.overlappingTriangles) {
+            continue;
+        }
+
+        const auto it = firstDraws.constFind(pending.instanceKey);
+        if (it == firstDraws.constEnd() || i - it.value() > INSTANCE_MERGE_WINDOW) {
+            firstDraws.insert(pending.instanceKey, i);
+            continue;
+        }
+
+        // the instance is drawn together with the first draw, so it must not overlap anything drawn in between
+        const int first = it.value();
+        const QRectF bounds = pending.record.bounds.adjusted(-2.0 * margin.width(), -2.0 * margin.height(), 2.0 * margin.width(),
+                                                             2.0 * margin.height());
+        bool independent = true;
+        for (int j = first + 1; j < i && independent; ++j) {
+            const RhiDrawRecord &record = m_pendingGeometry[j].record;
+            independent = mergedInto[j] == first || (record.bounded && !record.shaderBlending && !overlaps(record.bounds, bounds));
+        }
+
+        if (!independent) {
+            firstDraws.insert(pending.instanceKey, i);
+            continue;
+        }
+
+        RhiPendingGeometry &firstDraw = m_pendingGeometry[first];
+        if (firstDraw.instances.isEmpty()) {
+            firstDraw.instances.append(pathInstance(firstDraw.transform, firstDraw.opacity));
+        }
+        firstDraw.instances.append(pathInstance(pending.transform, pending.opacity));
+        firstDraw.record.bounds = firstDraw.record.bounds.united(pending.record.bounds);
+        mergedInto[i] = first;
+        ++mergedCount;
+    }
+
+    if (mergedCount == 0) {
+        return;
+    }
+
+    int kept = 0;
+    for (int i = 0; i < count; ++i) {
+        if (mergedInto[i] >= 0) {
+            m_pendingGeometry[i].node->recycle();
+            continue;
+        }
+        if (kept != i) {
+            m_pendingGeometry[kept] = std::move(m_pendingGeometry[i]);
+        }
+        ++kept;
+    }
+    m_pendingGeometry.resize(kept);
+}
+
+RhiRetainedGeometry *RiveQtRhiRenderer::retainedGeometry(const RiveQtPath *path, const RiveQtPathGeometry &geometry)
+{
+    m_tessellatedRetainedPaths.insert(path);
+
+    RhiRetainedGeometry *&retained = m_retainedArtboards[m_artboardInstance].geometry[qMakePair(path, geometry.version)];
+    if (!retained) {
+        auto *renderInterface = m_window->rendererInterface();
+        auto *rhi = static_cast<QRhi *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiResource));
+
+        retained = new RhiRetainedGeometry;
+        retained->vertexData =
+            QByteArray(reinterpret_cast<const char *>(geometry.vertices.constData()), geometry.vertices.count() * sizeof(QVector2D));
+        retained->indexData = geometry.indices;
+        retained->vertexBuffer = rhi->newBuffer(QRhiBuffer::Immutable, QRhiBuffer::VertexBuffer, retained->vertexData.size());
+        retained->vertexBuffer->create();
+        retained->indexBuffer = rhi->newBuffer(QRhiBuffer::Immutable, QRhiBuffer::IndexBuffer, retained->indexData.size());
+        retained->indexBuffer->create();
+    }
+
+    retained->used = true;
+    return retained;
+}
+
+void RiveQtRhiRenderer::releaseUnusedRetainedGeometry()
+{
+    if (m_keepRetainedGeometry) {
+        m_keepRetainedGeometry = false;
+        return;
+    }
+
+    const auto retainedArtboard = m_retainedArtboards.find(m_artboardInstance);
+    if (retainedArtboard == m_retainedArtboards.end()) {
+        m_retainedPaths.clear();
+        m_tessellatedRetainedPaths.clear();
+        return;
+    }
+
+    RetainedGeometryHash &retainedGeometry = retainedArtboard->geometry;
+    for (auto it = retainedGeometry.begin(); it != retainedGeometry.end();) {
+        RhiRetainedGeometry *retained = it.value();
+        const RiveQtPath *path = it.key().first;
+
+        // a path that was drawn without being tessellated, e.g. outside of the damaged area, still has this geometry
+        const bool replaced = !retained->used && m_tessellatedRetainedPaths.contains(path);
+        if (!m_retainedPaths.contains(path) || replaced) {
+            destroyRetainedGeometry(retained);
+            it = retainedGeometry.erase(it);
+            continue;
+        }
+
+        retained->used = false;
+        ++it;
+    }
+
+    m_retainedPaths.clear();
+    m_tessellatedRetainedPaths.clear();
 }
 
 const QMatrix4x4 &RiveQtRhiRenderer::transformMatrix() const
@@ -271,7 +1011,7 @@ const QMatrix4x4 &RiveQtRhiRenderer::transformMatrix() const
     return m_rhiRenderStack.back().transform;
 }
 
-float RiveQtRhiRenderer::currentOpacity()
+float RiveQtRhiRenderer::currentOpacity() const
 {
     float opacity = 1.0;
     for (const auto &renderState : std::as_const(m_rhiRenderStack)) {
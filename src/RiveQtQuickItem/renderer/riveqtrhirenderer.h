@@ -5,17 +5,31 @@
 
 #pragma once
 
+#include <QHash>
 #include <QPainterPath>
 #include <QMatrix4x4>
+#include <QPen>
+#include <QSet>
+#include <QThreadPool>
 
+#include <rive/artboard.hpp>
 #include <rive/renderer.hpp>
 #include <rive/math/raw_path.hpp>
 
+#include <memory>
+
+#include "riveqtpath.h"
+#include "datatypes.h"
+
 class QRhiCommandBuffer;
+class QRhiRenderTarget;
+class QRhiTexture;
 class QSGRenderNode;
 class QQuickWindow;
 class RhiSubPath;
 class TextureTargetNode;
+struct RhiRetainedGeometry;
+class RiveQtPaint;
 class RiveQSGRHIRenderNode;
 
 struct RhiRenderState
@@ -24,6 +38,69 @@ struct RhiRenderState
     float opacity { 1.0 };
 
     QVector<QPair<QPainterPath, QMatrix4x4>> m_allClipPainterPathesApplied;
+    // axis aligned rectangle clips are intersected here and applied as scissor, they never reach the stencil
+    QRectF clipRect;
+    bool hasClipRect { false };
+    // changes with every clip path, its transform and its content
+    size_t clipFingerprint { 0 };
+};
+
+// what a draw looked like, compared against the draw at the same position in the previous frame
+struct RhiDrawRecord
+{
+    // hash over everything that decides the pixels of the draw, 0 in case the draw can not be compared
+    size_t fingerprint { 0 };
+    // in artboard coordinates, including the stroke, images are not bounded
+    QRectF bounds;
+    bool bounded { false };
+    bool shaderBlending { false };
+};
+
+// a draw recorded while rive walks the artboard, its geometry is tessellated in flush()
+struct RhiPendingGeometry
+{
+    TextureTargetNode *node { nullptr };
+    // nullptr for images, they only need the clipping geometry
+    rive::rcp<RiveQtPath> path;
+    bool stroke { false };
+    // fills are either triangulated or drawn stencil then cover
+    bool stencilFill { false };
+    // stencil fills with the curves tessellated in the vertex shader
+    bool gpuTessellation { false };
+    QPen pen;
+    RiveRenderSettings::StrokeMode strokeMode { RiveRenderSettings::QtStroking };
+    // AnalyticAntialiasing: a fringe along the outline is drawn after the path
+    bool antialiasingFringe { false };
+    // the path belongs to a shape nothing animates, see RiveQtStaticShapes
+    bool retained { false };
+    QMatrix4x4 transform;
+    float opacity { 1.0 };
+    // equal for draws of the same path with the same paint and rectangle clip, 0 if the draw can not be instanced
+    size_t instanceKey { 0 };
+    // set on the first of several draws merged into one instanced draw, including the first one itself
+    QVector<RiveQtPathInstance> instances;
+    QVector<QPair<QPainterPath, QMatrix4x4>> clipPathes;
+
+    // for stencil fills geometry holds the cover quad
+    RiveQtPathGeometry geometry;
+    RiveQtPathGeometry stencilGeometry;
+    RiveQtPathGeometry clippingGeometry;
+    // GpuStroking strokes only upload their centre line
+    RiveQtStrokeCenterline strokeCenterline;
+    RiveQtCurveWedges curveWedges;
+    RiveQtStrokeCenterline fringeOutline;
+
+    RhiDrawRecord record;
+};
+
+// the pass draws are recorded into, renderers drawing to the same surfaces continue the pass of the one before
+struct RhiPassState
+{
+    // nullptr while no pass is open
+    QRhiRenderTarget *target { nullptr };
+    // stencil bits the draws of the pass left behind
+    bool clipStencil { false };
+    bool fillStencil { false };
 };
 
 class RiveQtRhiRenderer : public rive::Renderer
@@ -41,23 +118,127 @@ public:
     void drawImageMesh(const rive::RenderImage *image, rive::rcp<rive::RenderBuffer> vertices_f32,
                        rive::rcp<rive::RenderBuffer> uvCoords_f32, rive::rcp<rive::RenderBuffer> indices_u16, uint32_t vertexCount,
                        uint32_t indexCount, rive::BlendMode blendMode, float opacity) override;
+    // draws a premultiplied texture rendered by the rhi at its pixel size, contentVersion changes whenever it is rendered to
+    void drawTexture(QRhiTexture *texture, const QSize &size, quint64 contentVersion);
 
     void setProjectionMatrix(const QMatrix4x4 *projectionMatrix, const QMatrix4x4 *combinedMatrix);
     void updateArtboardSize(const QSize &artboardSize) { m_artboardSize = artboardSize; }
     void updateViewPort(const QRectF &viewportRect);
     void recycleRiveNodes();
     void setRiveRect(const QRectF &bounds);
-
+    void setFillRenderMode(RiveRenderSettings::FillRenderMode fillRenderMode) { m_fillRenderMode = fillRenderMode; }
+    void setStrokeMode(RiveRenderSettings::StrokeMode strokeMode) { m_strokeMode = strokeMode; }
+    void setAntialiasingMode(RiveRenderSettings::AntialiasingMode antialiasingMode) { m_antialiasingMode = antialiasingMode; }
+    RiveRenderSettings::FillRenderMode fillRenderMode() const { return m_fillRenderMode; }
+    RiveRenderSettings::StrokeMode strokeMode() const { return m_strokeMode; }
+    RiveRenderSettings::AntialiasingMode antialiasingMode() const { return m_antialiasingMode; }
+    // only redraw what changed since the last frame, the render surface has to keep its content for this
+    void setDamageTrackingEnabled(bool enabled) { m_damageTrackingEnabled = enabled; }
+    // true in case flush() limited this frame to the damaged area, the surface must not be cleared then
+    bool hasPartialDamage() const { return m_partialDamage; }
+    // the surface is shared with other items and cannot be cleared by a render pass, the artboard is overwritten instead
+    void setClearByDraw(bool clearByDraw) { m_clearByDraw = clearByDraw; }
+    // true in case flush() found the same draws as in the last frame, the surface already shows them
+    bool isFrameUnchanged() const { return m_frameUnchanged; }
+
+    // the artboard instance drawn from now on, its retained geometry is kept until the instance is gone
+    // so switching back to a cached instance finds the geometry again
+    void setArtboardInstance(const std::shared_ptr<rive::ArtboardInstance> &artboardInstance);
+    // releases the retained geometry of the artboard instances that are gone
+    void releaseExpiredRetainedGeometry();
+
+    // true in case the display list and everything else deciding the output are the same as in the last frame,
+    // the surface keeps showing it then, the display list does not need to be replayed and flush() must not be called
+    bool keepFrame(size_t displayListFingerprint);
+
+    // tessellates all draws recorded since the last flush, hands the geometry to the nodes and decides the draw order
+    void flush();
+
+    // uploads and records the draws in passes of its own
     void render(QRhiCommandBuffer *cb) const;
+    // the same in two steps, to share passes with other renderers: the uploads of all of them have to happen before
+    // the first pass begins, the draws are recorded into the pass of the state, which is left open for the next renderer
+    void uploadResources(QRhiCommandBuffer *cb) const;
+    void recordDraws(QRhiCommandBuffer *cb, RhiPassState &passState) const;
 
 private:
-    TextureTargetNode *getRiveDrawTargetNode();
+    // the damage clear node and the nodes of m_drawOrder that are not recycled
+    template<typename Function>
+    void forEachNode(const Function &function) const;
+    // the n-th draw of a drawable with a paint gets the node it had in the last frame, which still holds its geometry
+    TextureTargetNode *getRiveDrawTargetNode(const void *drawable, const void *paint = nullptr);
+    bool useStencilFill(const RiveQtPath *path) const;
+    // bounds of the path as drawn with the paint, in artboard coordinates
+    QRectF drawBounds(const RiveQtPath *path, const RiveQtPaint *paint) const;
+    // true for draws that cannot change a pixel: empty paths, transparent paints and paths outside of the viewport or the clip
+    bool isCulled(const RiveQtPath *path, const RiveQtPaint *paint, const QRectF &bounds) const;
+    // compares the draws of this frame with the last one and decides about the damaged area
+    void updateDamage();
+    // overwrites the rectangle with transparency before the draws
+    void clearRect(const QRectF &rect);
+    // CULLING_MARGIN in artboard units, false while the projection is not known yet
+    bool artboardMargin(QSizeF &margin) const;
+    // groups draws with the same pipelines, a draw only moves in front of draws it does not overlap
+    void updateDrawOrder();
+    // turns repeated draws of a path with the same paint into instances of its first draw
+    void mergeInstances();
+    // the immutable buffers holding the geometry, created on the first draw of this version of it
+    RhiRetainedGeometry *retainedGeometry(const RiveQtPath *path, const RiveQtPathGeometry &geometry);
+    // releases the buffers of paths the last frame did not draw and of geometry their paths replaced
+    // only the instance drawn in the last frame is looked at, the others keep theirs
+    void releaseUnusedRetainedGeometry();
 
     const QMatrix4x4 &transformMatrix() const;
-    float currentOpacity();
+    float currentOpacity() const;
 
     QVector<RhiRenderState> m_rhiRenderStack;
     QVector<TextureTargetNode *> m_renderNodes;
+    // the node of each draw, keyed by drawable, paint and how often the pair was drawn before in the frame
+    QHash<size_t, TextureTargetNode *> m_drawNodes;
+    QHash<size_t, TextureTargetNode *> m_previousDrawNodes;
+    QHash<size_t, int> m_drawOccurrences;
+    // nodes of the last frame whose draw did not come yet, they are not handed to other draws
+    QSet<TextureTargetNode *> m_reservedNodes;
+    // the nodes taken this frame in the order render() draws them
+    QVector<TextureTargetNode *> m_drawOrder;
+
+    QVector<RhiPendingGeometry> m_pendingGeometry;
+
+    // kept per path and geometry version, so a static shape keeps its buffers whatever node draws it
+    using RetainedGeometryHash = QHash<QPair<const RiveQtPath *, quint64>, RhiRetainedGeometry *>;
+    struct RetainedArtboard
+    {
+        std::weak_ptr<rive::ArtboardInstance> artboardInstance;
+        RetainedGeometryHash geometry;
+    };
+    // one group per artboard instance, released once the item dropped the instance
+    QHash<const rive::ArtboardInstance *, RetainedArtboard> m_retainedArtboards;
+    const rive::ArtboardInstance *m_artboardInstance { nullptr };
+    // static paths drawn this frame, and those of them that were tessellated, which replaces unused geometry
+    QSet<const RiveQtPath *> m_retainedPaths;
+    QSet<const RiveQtPath *> m_tessellatedRetainedPaths;
+    // set by keepFrame(), nothing was drawn, so the last draws tell which buffers are still used
+    bool m_keepRetainedGeometry { false };
+    QThreadPool m_tessellationPool;
+
+    RiveRenderSettings::FillRenderMode m_fillRenderMode { RiveRenderSettings::AutomaticFill };
+    RiveRenderSettings::StrokeMode m_strokeMode { RiveRenderSettings::QtStroking };
+    RiveRenderSettings::AntialiasingMode m_antialiasingMode { RiveRenderSettings::NoAntialiasing };
+
+    bool m_damageTrackingEnabled { false };
+    bool m_clearByDraw { false };
+    bool m_partialDamage { false };
+    QRectF m_damageRect;
+    bool m_frameUnchanged { false };
+    // hash over all draw fingerprints of a frame
+    size_t m_previousFrameFingerprint { 0 };
+    size_t m_previousDisplayListFingerprint { 0 };
+    // the previous frame has to be complete in the render surface to only redraw parts of it
+    bool m_hasPreviousFrame { false };
+    QVector<RhiDrawRecord> m_previousDrawRecords;
+    QMatrix4x4 m_previousCombinedMatrix;
+    // clears the damaged area, or the whole artboard when clearing by draw, before the draws, rendered first
+    TextureTargetNode *m_damageClearNode { nullptr };
 
     QQuickWindow *m_window;
 
@@ -9,6 +9,8 @@
 #include <QMatrix4x4>
 #include <QVector4D>
 
+#include <atomic>
+
 #include <rive/shapes/paint/color.hpp>
 #include <rive/renderer.hpp>
 #include <rive/command_path.hpp>
@@ -93,14 +95,26 @@ QPainter::CompositionMode RiveQtUtils::convert(rive::BlendMode blendMode)
     }
 }
 
+static quint64 nextPaintVersion()
+{
+    static std::atomic<quint64> version { 0 };
+    return ++version;
+}
+
 RiveQtPaint::RiveQtPaint()
     : rive::RenderPaint()
+    , m_contentVersion(nextPaintVersion())
 {
 }
 
 void RiveQtPaint::color(rive::ColorInt value)
 {
-    m_color = RiveQtUtils::convert(value);
+    const QColor color = RiveQtUtils::convert(value);
+    if (color != m_color) {
+        m_contentVersion = nextPaintVersion();
+    }
+
+    m_color = color;
     m_opacity = rive::colorOpacity(value);
 
     if (!m_color.isValid()) {
@@ -113,26 +127,41 @@ void RiveQtPaint::color(rive::ColorInt value)
 
 void RiveQtPaint::thickness(float value)
 {
+    if (m_pen.widthF() != value) {
+        m_contentVersion = nextPaintVersion();
+    }
     m_pen.setWidthF(value);
 }
 
 void RiveQtPaint::join(rive::StrokeJoin value)
 {
+    if (m_pen.joinStyle() != RiveQtUtils::convert(value)) {
+        m_contentVersion = nextPaintVersion();
+    }
     m_pen.setJoinStyle(RiveQtUtils::convert(value));
 }
 
 void RiveQtPaint::cap(rive::StrokeCap value)
 {
+    if (m_pen.capStyle() != RiveQtUtils::convert(value)) {
+        m_contentVersion = nextPaintVersion();
+    }
     m_pen.setCapStyle(RiveQtUtils::convert(value));
 }
 
 void RiveQtPaint::blendMode(rive::BlendMode value)
 {
+    if (m_blendMode != value) {
+        m_contentVersion = nextPaintVersion();
+    }
     m_blendMode = value;
 }
 
 void RiveQtPaint::style(rive::RenderPaintStyle value)
 {
+    if (m_paintStyle != value) {
+        m_contentVersion = nextPaintVersion();
+    }
     m_paintStyle = value;
 
     switch (value) {
@@ -154,6 +183,10 @@ void RiveQtPaint::style(rive::RenderPaintStyle value)
 
 void RiveQtPaint::shader(rive::rcp<rive::RenderShader> shader)
 {
+    // rive creates a new shader whenever a gradient changes
+    if (m_shader.get() != shader.get()) {
+        m_contentVersion = nextPaintVersion();
+    }
     m_shader = shader;
     if (shader) {
         RiveQtShader *qtShader = static_cast<RiveQtShader *>(shader.get());
@@ -100,10 +100,12 @@ public:
     QBrush brush() const { return m_brush; }
     QPen pen() const { return m_pen; }
     float opacity() const { return m_opacity; }
+    // changes whenever a setter changes the paint, unique over all paints, unlike the address of the gradient
+    quint64 contentVersion() const { return m_contentVersion; }
 
 private:
-    rive::RenderPaintStyle m_paintStyle;
-    rive::BlendMode m_blendMode;
+    rive::RenderPaintStyle m_paintStyle { rive::RenderPaintStyle::fill };
+    rive::BlendMode m_blendMode { rive::BlendMode::srcOver };
 
     QColor m_color;
     QBrush m_brush { Qt::NoBrush };
@@ -112,4 +114,6 @@ private:
 
     rive::rcp<rive::RenderShader> m_shader;
     QSharedPointer<QGradient> m_gradient;
+
+    quint64 m_contentVersion { 0 };
 };
@@ -0,0 +1,157 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "rhirenderatlas.h"
+#include "renderer/riveqtrhirenderer.h"
+#include "rqqplogging.h"
+
+#include <QQuickWindow>
+
+#include <algorithm>
+
+RhiRenderAtlas::RhiRenderAtlas(QRhi *rhi)
+{
+    const int size = qMin(RENDER_ATLAS_SIZE, rhi->resourceLimit(QRhi::TextureSizeMax));
+    m_size = QSize(size, size);
+    m_columns = size / RENDER_ATLAS_CELL_SIZE;
+    m_rows = size / RENDER_ATLAS_CELL_SIZE;
+    m_usedCells.resize(m_columns * m_rows);
+
+    m_stencilClippingBuffer = rhi->newRenderBuffer(QRhiRenderBuffer::DepthStencil, m_size, 1);
+    m_stencilClippingBuffer->create();
+
+    // the blend pass of one item must not clear the regions of the others either
+    m_surfaceA.create(rhi, 1, m_size, m_stencilClippingBuffer, QRhiTextureRenderTarget::PreserveColorContents,
+                      QRhiTextureRenderTarget::PreserveColorContents);
+    m_surfaceB.create(rhi, 1, m_size, m_stencilClippingBuffer, QRhiTextureRenderTarget::PreserveColorContents,
+                      QRhiTextureRenderTarget::PreserveColorContents);
+    // only used while an item draws a blended geometry, before the next item draws
+    m_surfaceIntern.create(rhi, 1, m_size, m_stencilClippingBuffer, {});
+
+    qCDebug(rqqpRendering) << "Created render atlas of" << m_size;
+}
+
+RhiRenderAtlas::~RhiRenderAtlas()
+{
+    for (const QMetaObject::Connection &connection : std::as_const(m_windowConnections)) {
+        QObject::disconnect(connection);
+    }
+
+    // the targets of the surfaces use the stencil buffer
+    m_surfaceA.cleanUp();
+    m_surfaceB.cleanUp();
+    m_surfaceIntern.cleanUp();
+
+    m_stencilClippingBuffer->destroy();
+    delete m_stencilClippingBuffer;
+}
+
+QRect RhiRenderAtlas::allocate(const QSize &size)
+{
+    if (size.isEmpty() || size.width() > RENDER_ATLAS_MAX_ITEM_SIZE || size.height() > RENDER_ATLAS_MAX_ITEM_SIZE) {
+        return {};
+    }
+
+    const QRect neededCells = cells(QRect(QPoint(0, 0), size));
+    // first fit, row by row
+    for (int row = 0; row + neededCells.height() <= m_rows; ++row) {
+        for (int column = 0; column + neededCells.width() <= m_columns; ++column) {
+            const QRect candidate = neededCells.translated(column, row);
+            if (isFree(candidate)) {
+                setUsed(candidate, true);
+                return QRect(QPoint(column, row) * RENDER_ATLAS_CELL_SIZE, size);
+            }
+        }
+    }
+
+    return {};
+}
+
+void RhiRenderAtlas::release(const QRect &region)
+{
+    if (!region.isEmpty()) {
+        setUsed(cells(region), false);
+    }
+}
+
+void RhiRenderAtlas::addItem(RiveQSGRHIRenderNode *item)
+{
+    m_items.append(item);
+
+    QQuickWindow *window = item->window();
+    if (!m_windowConnections.contains(window)) {
+        // emitted on the render thread with the command buffer of the frame recording, before the main pass begins
+        m_windowConnections.insert(window, QObject::connect(window, &QQuickWindow::beforeRendering, [this, window]() { render(window); }));
+    }
+}
+
+void RhiRenderAtlas::removeItem(RiveQSGRHIRenderNode *item)
+{
+    m_items.removeAll(item);
+
+    QQuickWindow *window = item->window();
+    const bool windowUsed =
+        std::any_of(m_items.cbegin(), m_items.cend(), [window](RiveQSGRHIRenderNode *other) { return other->window() == window; });
+    if (!windowUsed) {
+        QObject::disconnect(m_windowConnections.take(window));
+    }
+}
+
+void RhiRenderAtlas::render(QQuickWindow *window)
+{
+    QRhiCommandBuffer *commandBuffer = nullptr;
+    QVector<RiveQSGRHIRenderNode *> items;
+    for (RiveQSGRHIRenderNode *item : std::as_const(m_items)) {
+        if (item->window() != window) {
+            continue;
+        }
+        if (!commandBuffer) {
+            commandBuffer = item->frameCommandBuffer();
+        }
+        // nested artboards and uploads cannot be recorded while a pass is open, so all items do them first
+        if (item->prepareAtlasFrame(commandBuffer)) {
+            items.append(item);
+        }
+    }
+
+    // all items start on surface A, a new pass only begins where the draws of an item need one
+    RhiPassState passState;
+    for (RiveQSGRHIRenderNode *item : std::as_const(items)) {
+        item->recordAtlasFrame(commandBuffer, passState);
+    }
+    if (passState.target) {
+        commandBuffer->endPass();
+    }
+}
+
+QRect RhiRenderAtlas::cells(const QRect &region) const
+{
+    const int left = region.x() / RENDER_ATLAS_CELL_SIZE;
+    const int top = region.y() / RENDER_ATLAS_CELL_SIZE;
+    const int right = (region.x() + region.width() + RENDER_ATLAS_CELL_SIZE - 1) / RENDER_ATLAS_CELL_SIZE;
+    const int bottom = (region.y() + region.height() + RENDER_ATLAS_CELL_SIZE - 1) / RENDER_ATLAS_CELL_SIZE;
+    return QRect(left, top, right - left, bottom - top);
+}
+
+bool RhiRenderAtlas::isFree(const QRect &cells) const
+{
+    for (int row = cells.top(); row <= cells.bottom(); ++row) {
+        for (int column = cells.left(); column <= cells.right(); ++column) {
+            if (m_usedCells.testBit(row * m_columns + column)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void RhiRenderAtlas::setUsed(const QRect &cells, bool used)
+{
+    for (int row = cells.top(); row <= cells.bottom(); ++row) {
+        for (int column = cells.left(); column <= cells.right(); ++column) {
+            m_usedCells.setBit(row * m_columns + column, used);
+        }
+    }
+}
@@ -0,0 +1,69 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#pragma once
+
+#include "riveqsgrhirendernode.h"
+
+#include <QBitArray>
+#include <QHash>
+#include <QRect>
+#include <private/qrhi_p.h>
+
+class QQuickWindow;
+
+// edge length of the shared surfaces
+#define RENDER_ATLAS_SIZE 1024
+// regions are placed on a grid of cells of this size
+#define RENDER_ATLAS_CELL_SIZE 32
+// larger items keep their own surfaces
+#define RENDER_ATLAS_MAX_ITEM_SIZE 256
+
+// render surfaces shared by small rive items, each item draws into its own region of them
+// the surfaces are single sampled and keep their content between passes, so regions of other items stay untouched
+// before the items of a window are prepared, the draws of all of them are recorded into shared passes
+class RhiRenderAtlas
+{
+public:
+    explicit RhiRenderAtlas(QRhi *rhi);
+    ~RhiRenderAtlas();
+
+    // a free region of the size in pixels of the surfaces, empty in case the atlas is full
+    QRect allocate(const QSize &size);
+    void release(const QRect &region);
+
+    // items with a region, their frames are recorded by the atlas
+    void addItem(RiveQSGRHIRenderNode *item);
+    void removeItem(RiveQSGRHIRenderNode *item);
+
+    QSize size() const { return m_size; }
+
+    RiveQSGRHIRenderNode::RenderSurface *surfaceA() { return &m_surfaceA; }
+    RiveQSGRHIRenderNode::RenderSurface *surfaceB() { return &m_surfaceB; }
+    RiveQSGRHIRenderNode::RenderSurface *surfaceIntern() { return &m_surfaceIntern; }
+
+private:
+    // records the frames of the items of the window, runs before the scene graph prepares its nodes
+    void render(QQuickWindow *window);
+
+    // the cells covered by the region
+    QRect cells(const QRect &region) const;
+    bool isFree(const QRect &cells) const;
+    void setUsed(const QRect &cells, bool used);
+
+    QSize m_size;
+    int m_columns { 0 };
+    int m_rows { 0 };
+    // one bit per cell, row by row
+    QBitArray m_usedCells;
+
+    QVector<RiveQSGRHIRenderNode *> m_items;
+    QHash<QQuickWindow *, QMetaObject::Connection> m_windowConnections;
+
+    RiveQSGRHIRenderNode::RenderSurface m_surfaceA;
+    RiveQSGRHIRenderNode::RenderSurface m_surfaceB;
+    RiveQSGRHIRenderNode::RenderSurface m_surfaceIntern;
+    QRhiRenderBuffer *m_stencilClippingBuffer { nullptr };
+};
@@ -0,0 +1,536 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "rhiresourceregistry.h"
+#include "rhirenderatlas.h"
+#include "riveqtpath.h"
+#include "rqqplogging.h"
+
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector2D>
+
+namespace {
+    // each window may render in its own thread, the registries and the shaders are shared between them
+    QMutex registryMutex;
+    QHash<QRhi *, RhiResourceRegistry *> registries;
+
+    QMutex shaderMutex;
+    QHash<QString, QShader> shaders;
+
+    QRhiShaderStage shaderStage(QRhiShaderStage::Type type, const QString &fileName)
+    {
+        return QRhiShaderStage(type, RhiResourceRegistry::shader(fileName));
+    }
+}
+
+RhiResourceRegistry *RhiResourceRegistry::instance(QRhi *rhi)
+{
+    Q_ASSERT(rhi);
+
+    QMutexLocker locker(&registryMutex);
+    auto *registry = registries.value(rhi);
+    if (!registry) {
+        registry = new RhiResourceRegistry(rhi);
+        registries.insert(rhi, registry);
+        // all resources belong to the rhi, they have to go before it
+        rhi->addCleanupCallback([](QRhi *rhi) {
+            QMutexLocker locker(&registryMutex);
+            delete registries.take(rhi);
+        });
+    }
+    return registry;
+}
+
+QShader RhiResourceRegistry::shader(const QString &fileName)
+{
+    QMutexLocker locker(&shaderMutex);
+    const auto it = shaders.constFind(fileName);
+    if (it != shaders.cend()) {
+        return it.value();
+    }
+
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly)) {
+        qCWarning(rqqpRendering) << "Failed to open shader" << fileName;
+        return {};
+    }
+
+    const QShader shader = QShader::fromSerialized(file.readAll());
+    shaders.insert(fileName, shader);
+    return shader;
+}
+
+RhiResourceRegistry::RhiResourceRegistry(QRhi *rhi)
+    : m_rhi(rhi)
+{
+    m_finalDrawShader = { shaderStage(QRhiShaderStage::Vertex, ":/shaders/qt6/finalDraw.vert.qsb"),
+                          shaderStage(QRhiShaderStage::Fragment, ":/shaders/qt6/finalDraw.frag.qsb") };
+    m_pathShader = { shaderStage(QRhiShaderStage::Vertex, ":/shaders/qt6/drawRiveTextureNode.vert.qsb"),
+                     shaderStage(QRhiShaderStage::Fragment, ":/shaders/qt6/drawRiveTextureNode.frag.qsb") };
+    // the expanded stroke is colored like any other path
+    m_strokeShader = { shaderStage(QRhiShaderStage::Vertex, ":/shaders/qt6/strokeRiveTextureNode.vert.qsb"), m_pathShader.last() };
+    m_clipShader = { shaderStage(QRhiShaderStage::Vertex, ":/shaders/qt6/clipRiveTextureNode.vert.qsb"),
+                     shaderStage(QRhiShaderStage::Fragment, ":/shaders/qt6/clipRiveTextureNode.frag.qsb") };
+    // like the stencil fan, the wedges only write to the stencil buffer
+    m_wedgeShader = { shaderStage(QRhiShaderStage::Vertex, ":/shaders/qt6/wedgeRiveTextureNode.vert.qsb"), m_clipShader.last() };
+    m_pathInstanceShader = { shaderStage(QRhiShaderStage::Vertex, ":/shaders/qt6/instancedRiveTextureNode.vert.qsb"),
+                             m_pathShader.last() };
+    m_blendShaders = { shaderStage(QRhiShaderStage::Vertex, ":/shaders/qt6/blendRiveTextureNode.vert.qsb"),
+                       shaderStage(QRhiShaderStage::Fragment, ":/shaders/qt6/blendRiveTextureNode.frag.qsb") };
+
+    // in the order of PaintType
+    m_paintFragmentShaders = { shader(":/shaders/qt6/solidRiveTextureNode.frag.qsb"),
+                               shader(":/shaders/qt6/linearGradientRiveTextureNode.frag.qsb"),
+                               shader(":/shaders/qt6/radialGradientRiveTextureNode.frag.qsb"),
+                               shader(":/shaders/qt6/textureRiveTextureNode.frag.qsb") };
+
+    m_nearestSampler = own(m_rhi->newSampler(QRhiSampler::Nearest, QRhiSampler::Nearest, QRhiSampler::None, QRhiSampler::ClampToEdge,
+                                             QRhiSampler::ClampToEdge));
+    m_nearestSampler->create();
+
+    m_linearSampler = own(m_rhi->newSampler(QRhiSampler::Linear, QRhiSampler::Linear, QRhiSampler::None, QRhiSampler::ClampToEdge,
+                                            QRhiSampler::ClampToEdge));
+    m_linearSampler->create();
+
+    m_dummyTexture = own(m_rhi->newTexture(QRhiTexture::BGRA8, QSize(1, 1), 1));
+    m_dummyTexture->create();
+
+    m_drawUniformBuffer = own(m_rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 880));
+    m_drawUniformBuffer->create();
+
+    m_clippingUniformBuffer = own(m_rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 128));
+    m_clippingUniformBuffer->create();
+
+    m_blendUniformBuffer = own(m_rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 80));
+    m_blendUniformBuffer->create();
+
+    m_drawResourceBindings = own(m_rhi->newShaderResourceBindings());
+    m_drawResourceBindings->setBindings({
+        QRhiShaderResourceBinding::uniformBuffer(0, QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage,
+                                                 m_drawUniformBuffer),
+        QRhiShaderResourceBinding::sampledTexture(1, QRhiShaderResourceBinding::FragmentStage, m_dummyTexture, m_nearestSampler) //
+    });
+    m_drawResourceBindings->create();
+
+    m_paintResourceBindings = own(m_rhi->newShaderResourceBindings());
+    m_paintResourceBindings->setBindings({ QRhiShaderResourceBinding::uniformBuffer(
+        0, QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage, m_drawUniformBuffer) });
+    m_paintResourceBindings->create();
+
+    m_clippingResourceBindings = own(m_rhi->newShaderResourceBindings());
+    m_clippingResourceBindings->setBindings({ QRhiShaderResourceBinding::uniformBuffer(
+        0, QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage, m_clippingUniformBuffer) });
+    m_clippingResourceBindings->create();
+
+    m_blendResourceBindings = own(m_rhi->newShaderResourceBindings());
+    m_blendResourceBindings->setBindings({
+        QRhiShaderResourceBinding::uniformBuffer(0, QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage,
+                                                 m_blendUniformBuffer),
+        QRhiShaderResourceBinding::sampledTexture(1, QRhiShaderResourceBinding::FragmentStage, m_dummyTexture, m_linearSampler),
+        QRhiShaderResourceBinding::sampledTexture(2, QRhiShaderResourceBinding::FragmentStage, m_dummyTexture, m_linearSampler),
+    });
+    m_blendResourceBindings->create();
+}
+
+RhiResourceRegistry::~RhiResourceRegistry()
+{
+    delete m_renderAtlas;
+    qDeleteAll(m_pipelines);
+
+    for (auto *resource : std::as_const(m_resources)) {
+        resource->destroy();
+        delete resource;
+    }
+}
+
+RhiRenderAtlas *RhiResourceRegistry::renderAtlas()
+{
+    if (!m_renderAtlas) {
+        m_renderAtlas = new RhiRenderAtlas(m_rhi);
+    }
+    return m_renderAtlas;
+}
+
+RhiResourceRegistry::Pipelines *RhiResourceRegistry::pipelines(QRhiTexture::Format format, int sampleCount,
+                                                               QRhiTextureRenderTarget *target, QRhiTextureRenderTarget *blendTarget)
+{
+    const auto key = qMakePair(static_cast<int>(format), sampleCount);
+    if (auto *pipelines = m_pipelines.value(key)) {
+        return pipelines;
+    }
+
+    if (!target || !blendTarget) {
+        return nullptr;
+    }
+
+    auto *pipelines = new Pipelines;
+    // own descriptors, the pipelines outlive the surfaces of the node that happened to create them
+    pipelines->renderPassDescriptor = own(target->newCompatibleRenderPassDescriptor());
+    pipelines->blendPassDescriptor = own(blendTarget->newCompatibleRenderPassDescriptor());
+
+    auto *renderPass = pipelines->renderPassDescriptor;
+    const bool instancing = m_rhi->isFeatureSupported(QRhi::Instancing);
+
+    pipelines->clip = createClipPipeline(renderPass, m_clippingResourceBindings);
+    pipelines->draw =
+        own(createDrawPipeline(true, true, renderPass, QRhiGraphicsPipeline::Triangles, m_pathShader, m_drawResourceBindings));
+    pipelines->drawIntern =
+        own(createDrawPipeline(false, true, renderPass, QRhiGraphicsPipeline::Triangles, m_pathShader, m_drawResourceBindings));
+    pipelines->stencilFill =
+        createStencilFillPipeline(renderPass, m_clippingResourceBindings, false, m_clipShader, positionInputLayout());
+    pipelines->stencilFillEvenOdd =
+        createStencilFillPipeline(renderPass, m_clippingResourceBindings, true, m_clipShader, positionInputLayout());
+    if (instancing) {
+        pipelines->wedgeFill =
+            createStencilFillPipeline(renderPass, m_clippingResourceBindings, false, m_wedgeShader, wedgeInstanceInputLayout());
+        pipelines->wedgeFillEvenOdd =
+            createStencilFillPipeline(renderPass, m_clippingResourceBindings, true, m_wedgeShader, wedgeInstanceInputLayout());
+    }
+    pipelines->cover = own(createDrawPipeline(true, true, renderPass, QRhiGraphicsPipeline::Triangles, m_pathShader,
+                                              m_drawResourceBindings, StencilMode::Cover));
+    pipelines->coverIntern = own(createDrawPipeline(false, true, renderPass, QRhiGraphicsPipeline::Triangles, m_pathShader,
+                                                    m_drawResourceBindings, StencilMode::Cover));
+    pipelines->writeOnce = own(createDrawPipeline(true, true, renderPass, QRhiGraphicsPipeline::Triangles, m_pathShader,
+                                                  m_drawResourceBindings, StencilMode::WriteOnce));
+    pipelines->writeOnceIntern = own(createDrawPipeline(false, true, renderPass, QRhiGraphicsPipeline::Triangles, m_pathShader,
+                                                        m_drawResourceBindings, StencilMode::WriteOnce));
+    if (instancing) {
+        pipelines->stroke = own(createDrawPipeline(true, true, renderPass, QRhiGraphicsPipeline::Triangles, m_strokeShader,
+                                                   m_drawResourceBindings, StencilMode::WriteOnce, strokeInstanceInputLayout()));
+        pipelines->strokeIntern = own(createDrawPipeline(false, true, renderPass, QRhiGraphicsPipeline::Triangles, m_strokeShader,
+                                                         m_drawResourceBindings, StencilMode::WriteOnce, strokeInstanceInputLayout()));
+    }
+    pipelines->overwrite =
+        own(createDrawPipeline(false, true, renderPass, QRhiGraphicsPipeline::Triangles, m_pathShader, m_drawResourceBindings));
+    if (instancing) {
+        pipelines->pathInstance = own(createDrawPipeline(true, true, renderPass, QRhiGraphicsPipeline::Triangles, m_pathInstanceShader,
+                                                         m_drawResourceBindings, StencilMode::Clip, pathInstanceInputLayout()));
+    }
+    pipelines->blend = createBlendPipeline(pipelines->blendPassDescriptor, m_blendResourceBindings);
+
+    m_pipelines.insert(key, pipelines);
+    return pipelines;
+}
+
+QRhiGraphicsPipeline *RhiResourceRegistry::paintPipeline(Pipelines *pipelines, QRhiGraphicsPipeline *pipeline, PaintType paintType)
+{
+    if (!pipelines || !pipeline) {
+        return pipeline;
+    }
+
+    const auto key = qMakePair(pipeline, static_cast<int>(paintType));
+    if (auto *paintPipeline = pipelines->paintPipelines.value(key)) {
+        return paintPipeline;
+    }
+
+    // same states as the generic pipeline, only the fragment shader and its bindings differ
+    QRhiGraphicsPipeline *paintPipeline = m_rhi->newGraphicsPipeline();
+    paintPipeline->setFlags(pipeline->flags());
+    paintPipeline->setTopology(pipeline->topology());
+    paintPipeline->setCullMode(pipeline->cullMode());
+    paintPipeline->setFrontFace(pipeline->frontFace());
+    paintPipeline->setTargetBlends(pipeline->cbeginTargetBlends(), pipeline->cendTargetBlends());
+    paintPipeline->setDepthTest(pipeline->hasDepthTest());
+    paintPipeline->setDepthWrite(pipeline->hasDepthWrite());
+    paintPipeline->setDepthOp(pipeline->depthOp());
+    paintPipeline->setStencilTest(pipeline->hasStencilTest());
+    paintPipeline->setStencilFront(pipeline->stencilFront());
+    paintPipeline->setStencilBack(pipeline->stencilBack());
+    paintPipeline->setStencilReadMask(pipeline->stencilReadMask());
+    paintPipeline->setStencilWriteMask(pipeline->stencilWriteMask());
+    paintPipeline->setSampleCount(pipeline->sampleCount());
+    paintPipeline->setVertexInputLayout(pipeline->vertexInputLayout());
+    paintPipeline->setRenderPassDescriptor(pipelines->renderPassDescriptor);
+
+    QList<QRhiShaderStage> shader(pipeline->cbeginShaderStages(), pipeline->cendShaderStages());
+    for (QRhiShaderStage &stage : shader) {
+        if (stage.type() == QRhiShaderStage::Fragment) {
+            stage.setShader(m_paintFragmentShaders.at(static_cast<int>(paintType)));
+        }
+    }
+    paintPipeline->setShaderStages(shader.cbegin(), shader.cend());
+    paintPipeline->setShaderResourceBindings(paintType == PaintType::Texture ? m_drawResourceBindings : m_paintResourceBindings);
+
+    if (!paintPipeline->create()) {
+        qCWarning(rqqpRendering) << "Failed to create the pipeline for paint type" << static_cast<int>(paintType);
+        delete paintPipeline;
+        return pipeline;
+    }
+
+    m_resources.append(paintPipeline);
+    pipelines->paintPipelines.insert(key, paintPipeline);
+    return paintPipeline;
+}
+
+QRhiGraphicsPipeline *RhiResourceRegistry::createClipPipeline(QRhiRenderPassDescriptor *renderPassDescriptor,
+                                                              QRhiShaderResourceBindings *bindings)
+{
+    QRhiGraphicsPipeline *clipPipeLine = m_rhi->newGraphicsPipeline();
+
+    clipPipeLine->setShaderStages(m_clipShader.cbegin(), m_clipShader.cend());
+    clipPipeLine->setFlags(QRhiGraphicsPipeline::UsesStencilRef | QRhiGraphicsPipeline::UsesScissor);
+    clipPipeLine->setDepthTest(true);
+    clipPipeLine->setDepthWrite(true);
+
+    QRhiGraphicsPipeline::TargetBlend disabledColorWrite;
+    disabledColorWrite.colorWrite = QRhiGraphicsPipeline::ColorMask(0);
+    clipPipeLine->setTargetBlends({ disabledColorWrite });
+
+    QRhiVertexInputLayout inputLayout;
+    inputLayout.setBindings({
+        { sizeof(QVector2D) }
+    });
+    inputLayout.setAttributes({
+        { 0, 0, QRhiVertexInputAttribute::Float2, 0 }
+    });
+
+    // Configure stencil operations for writing stencil values
+    QRhiGraphicsPipeline::StencilOpState stencilOpState = { QRhiGraphicsPipeline::Keep, QRhiGraphicsPipeline::Keep,
+                                                            QRhiGraphicsPipeline::Replace, QRhiGraphicsPipeline::Always };
+    clipPipeLine->setStencilFront(stencilOpState);
+    clipPipeLine->setStencilBack(stencilOpState);
+    clipPipeLine->setStencilTest(true);
+    // only the clip bit is touched, the lower bits are left to stencil filled paths
+    clipPipeLine->setStencilWriteMask(CLIP_STENCIL_BIT);
+    clipPipeLine->setCullMode(QRhiGraphicsPipeline::None);
+    clipPipeLine->setTopology(QRhiGraphicsPipeline::Triangles);
+    clipPipeLine->setVertexInputLayout(inputLayout);
+    clipPipeLine->setRenderPassDescriptor(renderPassDescriptor);
+
+    clipPipeLine->setShaderResourceBindings(bindings);
+    clipPipeLine->create();
+    m_resources.append(clipPipeLine);
+
+    return clipPipeLine;
+}
+
+QRhiGraphicsPipeline *RhiResourceRegistry::createStencilFillPipeline(QRhiRenderPassDescriptor *renderPassDescriptor,
+                                                                     QRhiShaderResourceBindings *bindings, bool evenOdd,
+                                                                     const QList<QRhiShaderStage> &shader,
+                                                                     const QRhiVertexInputLayout &inputLayout)
+{
+    QRhiGraphicsPipeline *stencilFillPipeLine = m_rhi->newGraphicsPipeline();
+
+    stencilFillPipeLine->setShaderStages(shader.cbegin(), shader.cend());
+    stencilFillPipeLine->setFlags(QRhiGraphicsPipeline::UsesStencilRef | QRhiGraphicsPipeline::UsesScissor);
+
+    QRhiGraphicsPipeline::TargetBlend disabledColorWrite;
+    disabledColorWrite.colorWrite = QRhiGraphicsPipeline::ColorMask(0);
+    stencilFillPipeLine->setTargetBlends({ disabledColorWrite });
+
+    // fan triangles only count where the clip bit matches the stencil ref, so clipped areas are never covered
+    // nonzero: front faces increment and back faces decrement the winding bits
+    // evenodd: every triangle flips the lowest bit
+    if (evenOdd) {
+        QRhiGraphicsPipeline::StencilOpState stencilOpState = { QRhiGraphicsPipeline::Keep, QRhiGraphicsPipeline::Keep,
+                                                                QRhiGraphicsPipeline::Invert, QRhiGraphicsPipeline::Equal };
+        stencilFillPipeLine->setStencilFront(stencilOpState);
+        stencilFillPipeLine->setStencilBack(stencilOpState);
+        stencilFillPipeLine->setStencilWriteMask(0x01);
+    } else {
+        QRhiGraphicsPipeline::StencilOpState frontStencilOpState = { QRhiGraphicsPipeline::Keep, QRhiGraphicsPipeline::Keep,
+                                                                     QRhiGraphicsPipeline::IncrementAndWrap, QRhiGraphicsPipeline::Equal };
+        QRhiGraphicsPipeline::StencilOpState backStencilOpState = { QRhiGraphicsPipeline::Keep, QRhiGraphicsPipeline::Keep,
+                                                                    QRhiGraphicsPipeline::DecrementAndWrap, QRhiGraphicsPipeline::Equal };
+        stencilFillPipeLine->setStencilFront(frontStencilOpState);
+        stencilFillPipeLine->setStencilBack(backStencilOpState);
+        stencilFillPipeLine->setStencilWriteMask(FILL_STENCIL_MASK);
+    }
+
+    stencilFillPipeLine->setStencilReadMask(CLIP_STENCIL_BIT);
+    stencilFillPipeLine->setStencilTest(true);
+    stencilFillPipeLine->setDepthTest(false);
+    stencilFillPipeLine->setDepthWrite(false);
+    stencilFillPipeLine->setFrontFace(m_rhi->isYUpInFramebuffer() ? QRhiGraphicsPipeline::CW : QRhiGraphicsPipeline::CCW);
+    stencilFillPipeLine->setCullMode(QRhiGraphicsPipeline::None);
+    stencilFillPipeLine->setTopology(QRhiGraphicsPipeline::Triangles);
+    stencilFillPipeLine->setVertexInputLayout(inputLayout);
+    stencilFillPipeLine->setRenderPassDescriptor(renderPassDescriptor);
+
+    stencilFillPipeLine->setShaderResourceBindings(bindings);
+    stencilFillPipeLine->create();
+    m_resources.append(stencilFillPipeLine);
+
+    return stencilFillPipeLine;
+}
+
+QRhiGraphicsPipeline *RhiResourceRegistry::createDrawPipeline(bool srcOverBlend, bool stencilBuffer,
+                                                              QRhiRenderPassDescriptor *renderPassDescriptor,
+                                                              QRhiGraphicsPipeline::Topology t, const QList<QRhiShaderStage> &shader,
+                                                              QRhiShaderResourceBindings *bindings, StencilMode stencilMode,
+                                                              const QRhiVertexInputLayout &inputLayout)
+{
+    QRhiGraphicsPipeline *drawPipeLine = m_rhi->newGraphicsPipeline();
+
+    //
+    // If layer.enabled == true on our QQuickItem, the rendering face is flipped for
+    // backends with isYUpInFrameBuffer == true (OpenGL). This does not happen with
+    // RHI backends with isYUpInFrameBuffer == false. We swap the triangle winding
+    // order to work around this.
+    //
+    drawPipeLine->setFrontFace(m_rhi->isYUpInFramebuffer() ? QRhiGraphicsPipeline::CW : QRhiGraphicsPipeline::CCW);
+    drawPipeLine->setCullMode(QRhiGraphicsPipeline::None);
+    drawPipeLine->setTopology(t);
+
+    if (srcOverBlend) {
+        QRhiGraphicsPipeline::TargetBlend blend;
+        blend.enable = true;
+        blend.srcColor = QRhiGraphicsPipeline::SrcAlpha;
+        blend.dstColor = QRhiGraphicsPipeline::OneMinusSrcAlpha;
+        blend.srcAlpha = QRhiGraphicsPipeline::One;
+        blend.dstAlpha = QRhiGraphicsPipeline::OneMinusSrcAlpha;
+        drawPipeLine->setTargetBlends({ blend });
+    }
+
+    drawPipeLine->setShaderResourceBindings(bindings);
+    drawPipeLine->setShaderStages(shader.cbegin(), shader.cend());
+
+    drawPipeLine->setVertexInputLayout(inputLayout);
+    drawPipeLine->setRenderPassDescriptor(renderPassDescriptor);
+
+    if (stencilBuffer) {
+        QRhiGraphicsPipeline::StencilOpState stencilOpState = { QRhiGraphicsPipeline::Keep, QRhiGraphicsPipeline::Keep,
+                                                                QRhiGraphicsPipeline::Replace, QRhiGraphicsPipeline::Equal };
+        drawPipeLine->setDepthTest(false);
+        drawPipeLine->setDepthWrite(false);
+
+        switch (stencilMode) {
+        case StencilMode::Cover:
+            // draws where the winding bits are not zero (stencil ref 0), they already respect the clip
+            stencilOpState.compareOp = QRhiGraphicsPipeline::NotEqual;
+            drawPipeLine->setStencilReadMask(FILL_STENCIL_MASK);
+            drawPipeLine->setStencilWriteMask(0);
+            break;
+        case StencilMode::WriteOnce:
+            // the first fragment marks the pixel in the winding bits, later ones fail the test
+            stencilOpState.passOp = QRhiGraphicsPipeline::IncrementAndClamp;
+            drawPipeLine->setStencilReadMask(CLIP_STENCIL_BIT | FILL_STENCIL_MASK);
+            drawPipeLine->setStencilWriteMask(FILL_STENCIL_MASK);
+            break;
+        case StencilMode::Clip:
+        default:
+            drawPipeLine->setStencilReadMask(CLIP_STENCIL_BIT);
+            drawPipeLine->setStencilWriteMask(0);
+            break;
+        }
+
+        drawPipeLine->setStencilFront(stencilOpState);
+        drawPipeLine->setStencilBack(stencilOpState);
+        drawPipeLine->setStencilTest(true);
+        // the pipelines with stencil draw the paths, they are scissored by rectangle clips
+        drawPipeLine->setFlags(QRhiGraphicsPipeline::UsesStencilRef | QRhiGraphicsPipeline::UsesScissor);
+    }
+
+    drawPipeLine->create();
+    return drawPipeLine;
+}
+
+QRhiVertexInputLayout RhiResourceRegistry::pathInputLayout()
+{
+    QRhiVertexInputLayout inputLayout;
+    inputLayout.setBindings({
+        { sizeof(QVector2D) }, // Stride for position buffer
+        { sizeof(QVector2D) }, // Stride for texture coordinate buffer
+    });
+    inputLayout.setAttributes({
+        { 0, 0, QRhiVertexInputAttribute::Float2, 0 }, // Position1
+        { 1, 1, QRhiVertexInputAttribute::Float2, 0 } // Texture coordinate
+    });
+    return inputLayout;
+}
+
+QRhiVertexInputLayout RhiResourceRegistry::strokeInstanceInputLayout()
+{
+    QRhiVertexInputLayout inputLayout;
+    inputLayout.setBindings({
+        { sizeof(RiveQtStrokeInstance), QRhiVertexInputBinding::PerInstance },
+    });
+    inputLayout.setAttributes({
+        { 0, 0, QRhiVertexInputAttribute::Float4, 0 }, // a and b
+        { 0, 1, QRhiVertexInputAttribute::Float4, 4 * sizeof(float) } // c, kind and padding
+    });
+    return inputLayout;
+}
+
+QRhiVertexInputLayout RhiResourceRegistry::positionInputLayout()
+{
+    QRhiVertexInputLayout inputLayout;
+    inputLayout.setBindings({
+        { sizeof(QVector2D) }
+    });
+    inputLayout.setAttributes({
+        { 0, 0, QRhiVertexInputAttribute::Float2, 0 }
+    });
+    return inputLayout;
+}
+
+QRhiVertexInputLayout RhiResourceRegistry::wedgeInstanceInputLayout()
+{
+    QRhiVertexInputLayout inputLayout;
+    inputLayout.setBindings({
+        { sizeof(RiveQtCurveWedge), QRhiVertexInputBinding::PerInstance },
+    });
+    inputLayout.setAttributes({
+        { 0, 0, QRhiVertexInputAttribute::Float4, 0 }, // anchor and p0
+        { 0, 1, QRhiVertexInputAttribute::Float4, 4 * sizeof(float) }, // p1 and p2
+        { 0, 2, QRhiVertexInputAttribute::Float4, 8 * sizeof(float) } // p3 and padding
+    });
+    return inputLayout;
+}
+
+QRhiVertexInputLayout RhiResourceRegistry::pathInstanceInputLayout()
+{
+    QRhiVertexInputLayout inputLayout;
+    inputLayout.setBindings({
+        { sizeof(QVector2D) }, // Stride for position buffer
+        { sizeof(QVector2D) }, // Stride for texture coordinate buffer
+        { sizeof(RiveQtPathInstance), QRhiVertexInputBinding::PerInstance },
+    });
+    inputLayout.setAttributes({
+        { 0, 0, QRhiVertexInputAttribute::Float2, 0 }, // Position1
+        { 1, 1, QRhiVertexInputAttribute::Float2, 0 }, // Texture coordinate
+        { 2, 2, QRhiVertexInputAttribute::Float4, 0 }, // x and y axis
+        { 2, 3, QRhiVertexInputAttribute::Float4, 4 * sizeof(float) } // translation, opacity and padding
+    });
+    return inputLayout;
+}
+
+QRhiGraphicsPipeline *RhiResourceRegistry::createBlendPipeline(QRhiRenderPassDescriptor *renderPass,
+                                                               QRhiShaderResourceBindings *bindings)
+{
+    auto *blendPipeLine = m_rhi->newGraphicsPipeline();
+    m_resources.append(blendPipeLine);
+    //
+    // If layer.enabled == true on our QQuickItem, the rendering face is flipped for
+    // backends with isYUpInFrameBuffer == true (OpenGL). This does not happen with
+    // RHI backends with isYUpInFrameBuffer == false. We swap the triangle winding
+    // order to work around this.
+    //
+    blendPipeLine->setFrontFace(m_rhi->isYUpInFramebuffer() ? QRhiGraphicsPipeline::CW : QRhiGraphicsPipeline::CCW);
+    blendPipeLine->setCullMode(QRhiGraphicsPipeline::None);
+    blendPipeLine->setTopology(QRhiGraphicsPipeline::TriangleStrip);
+
+    blendPipeLine->setStencilTest(false);
+    blendPipeLine->setShaderResourceBindings(bindings);
+    blendPipeLine->setShaderStages(m_blendShaders.cbegin(), m_blendShaders.cend());
+
+    QRhiVertexInputLayout inputLayout;
+    inputLayout.setBindings({
+        { sizeof(QVector2D) },
+        { sizeof(QVector2D) },
+    });
+    inputLayout.setAttributes({
+        { 0, 0, QRhiVertexInputAttribute::Float2, 0 }, // Position1
+        { 1, 1, QRhiVertexInputAttribute::Float2, 0 } // Texture coordinate
+    });
+
+    blendPipeLine->setVertexInputLayout(inputLayout);
+    blendPipeLine->setRenderPassDescriptor(renderPass);
+
+    blendPipeLine->create();
+    return blendPipeLine;
+}
@@ -0,0 +1,170 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <private/qrhi_p.h>
+
+// stencil layout: the highest bit marks the clip area, the lower bits count the winding of stencil filled paths
+#define CLIP_STENCIL_BIT 0x80
+#define FILL_STENCIL_MASK 0x7F
+
+class RhiRenderAtlas;
+
+// shaders, samplers, the dummy texture and the draw pipelines shared by all rive items rendering with the same QRhi
+// the shaders are deserialized once per process, everything else lives as long as the QRhi
+class RhiResourceRegistry
+{
+public:
+    // how a draw pipeline tests the stencil buffer
+    enum class StencilMode
+    {
+        Clip, // draw inside the clip bit
+        Cover, // draw where the winding bits of a stencil fill are set
+        WriteOnce // draw inside the clip bit, but each pixel only once
+    };
+
+    // the fragment shader variants, each one only handles one kind of paint
+    enum class PaintType
+    {
+        Solid,
+        LinearGradient,
+        RadialGradient,
+        Texture
+    };
+
+    // the pipelines for render surfaces of one format and sample count
+    // the nodes set their own render pass descriptor before each use, all of them are compatible
+    struct Pipelines
+    {
+        QRhiRenderPassDescriptor *renderPassDescriptor { nullptr };
+        QRhiRenderPassDescriptor *blendPassDescriptor { nullptr };
+
+        // used in the main draw call to paint directly to the renderSurface texture
+        QRhiGraphicsPipeline *draw { nullptr };
+        // used in the main draw call in case we need to draw a to-be-blend geometry
+        QRhiGraphicsPipeline *drawIntern { nullptr };
+        // used to shader-blend the to-be-blend geomentry texture to the current renderSurface
+        QRhiGraphicsPipeline *blend { nullptr };
+        // used to draw into the stencil buffer during the main draw call
+        QRhiGraphicsPipeline *clip { nullptr };
+        // used to count the winding of stencil filled paths into the stencil buffer, one per fill rule
+        QRhiGraphicsPipeline *stencilFill { nullptr };
+        QRhiGraphicsPipeline *stencilFillEvenOdd { nullptr };
+        // the same for GpuTessellatedFill, the wedges are tessellated in the vertex shader
+        // only created if the rhi supports instancing
+        QRhiGraphicsPipeline *wedgeFill { nullptr };
+        QRhiGraphicsPipeline *wedgeFillEvenOdd { nullptr };
+        // used to cover stencil filled paths, the same as the draw pipelines but testing the winding bits
+        QRhiGraphicsPipeline *cover { nullptr };
+        QRhiGraphicsPipeline *coverIntern { nullptr };
+        // used for geometry with overlapping triangles, like native strokes, to avoid blending twice
+        QRhiGraphicsPipeline *writeOnce { nullptr };
+        QRhiGraphicsPipeline *writeOnceIntern { nullptr };
+        // used for GpuStroking, expands instanced segments, joins and caps, each pixel is drawn once like native strokes
+        // only created if the rhi supports instancing
+        QRhiGraphicsPipeline *stroke { nullptr };
+        QRhiGraphicsPipeline *strokeIntern { nullptr };
+        // draws without blending, used to clear the damaged area when only parts of the surface are redrawn
+        QRhiGraphicsPipeline *overwrite { nullptr };
+        // draws one path geometry with many transforms, only created if the rhi supports instancing
+        QRhiGraphicsPipeline *pathInstance { nullptr };
+
+        // the variants of the pipelines above per paint type, the generic ones are still used for the antialiasing fringe
+        QHash<QPair<QRhiGraphicsPipeline *, int>, QRhiGraphicsPipeline *> paintPipelines;
+    };
+
+    // created on first use, destroyed together with the rhi
+    static RhiResourceRegistry *instance(QRhi *rhi);
+    // the deserialized shader of a qsb resource, read only once per process
+    static QShader shader(const QString &fileName);
+
+    QRhiSampler *nearestSampler() const { return m_nearestSampler; }
+    QRhiSampler *linearSampler() const { return m_linearSampler; }
+    // dummy texture to make the shader binding happy
+    QRhiTexture *dummyTexture() const { return m_dummyTexture; }
+    const QList<QRhiShaderStage> &finalDrawShader() const { return m_finalDrawShader; }
+    // the surfaces shared by small items, created on first use
+    RhiRenderAtlas *renderAtlas();
+
+    // the targets are only used to derive the render pass descriptors when the pipelines do not exist yet
+    Pipelines *pipelines(QRhiTexture::Format format, int sampleCount, QRhiTextureRenderTarget *target,
+                         QRhiTextureRenderTarget *blendTarget);
+    // the draw pipeline with the fragment shader of the paint type, created on first use
+    // only texture paints bind a sampler, the others use the uniform buffer alone
+    QRhiGraphicsPipeline *paintPipeline(Pipelines *pipelines, QRhiGraphicsPipeline *pipeline, PaintType paintType);
+
+    // the caller owns the pipeline
+    QRhiGraphicsPipeline *createDrawPipeline(bool srcOverBlend, bool stencilBuffer, QRhiRenderPassDescriptor *renderPassDescriptor,
+                                             QRhiGraphicsPipeline::Topology t, const QList<QRhiShaderStage> &shader,
+                                             QRhiShaderResourceBindings *bindings, StencilMode stencilMode = StencilMode::Clip,
+                                             const QRhiVertexInputLayout &inputLayout = pathInputLayout());
+
+private:
+    explicit RhiResourceRegistry(QRhi *rhi);
+    ~RhiResourceRegistry();
+
+    QRhiGraphicsPipeline *createBlendPipeline(QRhiRenderPassDescriptor *renderPass, QRhiShaderResourceBindings *bindings);
+    QRhiGraphicsPipeline *createClipPipeline(QRhiRenderPassDescriptor *renderPassDescriptor, QRhiShaderResourceBindings *bindings);
+    QRhiGraphicsPipeline *createStencilFillPipeline(QRhiRenderPassDescriptor *renderPassDescriptor, QRhiShaderResourceBindings *bindings,
+                                                    bool evenOdd, const QList<QRhiShaderStage> &shader,
+                                                    const QRhiVertexInputLayout &inputLayout);
+    // takes ownership, the resource is destroyed together with the registry
+    template<typename T>
+    T *own(T *resource)
+    {
+        if (resource) {
+            m_resources.append(resource);
+        }
+        return resource;
+    }
+
+    // vertex position and texture coordinate, each in their own buffer
+    static QRhiVertexInputLayout pathInputLayout();
+    // one RiveQtStrokeInstance per instance
+    static QRhiVertexInputLayout strokeInstanceInputLayout();
+    // a single vertex position
+    static QRhiVertexInputLayout positionInputLayout();
+    // one RiveQtCurveWedge per instance
+    static QRhiVertexInputLayout wedgeInstanceInputLayout();
+    // like pathInputLayout, with one RiveQtPathInstance per instance
+    static QRhiVertexInputLayout pathInstanceInputLayout();
+
+    QRhi *m_rhi { nullptr };
+
+    QRhiSampler *m_nearestSampler { nullptr };
+    QRhiSampler *m_linearSampler { nullptr };
+    QRhiTexture *m_dummyTexture { nullptr };
+
+    // the pipelines are created against these bindings, the nodes bind their own compatible ones
+    QRhiBuffer *m_drawUniformBuffer { nullptr };
+    QRhiBuffer *m_clippingUniformBuffer { nullptr };
+    QRhiBuffer *m_blendUniformBuffer { nullptr };
+    QRhiShaderResourceBindings *m_drawResourceBindings { nullptr };
+    // layout of the draws without a texture
+    QRhiShaderResourceBindings *m_paintResourceBindings { nullptr };
+    QRhiShaderResourceBindings *m_clippingResourceBindings { nullptr };
+    QRhiShaderResourceBindings *m_blendResourceBindings { nullptr };
+
+    QList<QRhiShaderStage> m_finalDrawShader;
+    QList<QRhiShaderStage> m_blendShaders;
+    QList<QRhiShaderStage> m_pathShader;
+    QList<QRhiShaderStage> m_clipShader;
+    QList<QRhiShaderStage> m_strokeShader;
+    QList<QRhiShaderStage> m_wedgeShader;
+    QList<QRhiShaderStage> m_pathInstanceShader;
+    // indexed by PaintType, they replace the generic path fragment shader
+    QList<QShader> m_paintFragmentShaders;
+
+    // keyed by surface format and sample count
+    QHash<QPair<int, int>, Pipelines *> m_pipelines;
+
+    QVector<QRhiResource *> m_resources;
+
+    RhiRenderAtlas *m_renderAtlas { nullptr };
+};
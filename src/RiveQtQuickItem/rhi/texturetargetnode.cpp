@@ -8,9 +8,89 @@
 
 #include <QQuickWindow>
 #include <QSGRendererInterface>
+#include <QtMath>
 #include <private/qrhi_p.h>
 #include <private/qsgrendernode_p.h>
 
+// triangles of a round join or cap in the stroke shader, has to match roundSegments in strokeRiveTextureNode.vert
+#define GPU_STROKE_ROUND_SEGMENTS 16
+// segments and square caps are two quads split along the centre line, so the coverage can fall off to both sides
+#define GPU_STROKE_SEGMENT_VERTICES 12
+#define GPU_STROKE_MITER_VERTICES 6
+
+// width in pixels over which the analytic antialiasing fades out the edges of a path
+#define ANTIALIASING_FRINGE_WIDTH 1.0f
+
+// upper bound for the triangles of a cubic wedge, has to match maxSegments in wedgeRiveTextureNode.vert
+#define GPU_TESSELLATION_MAX_SEGMENTS 32
+// maximum distance in pixels between a curve and its tessellation in the vertex shader
+#define GPU_TESSELLATION_TOLERANCE 0.25f
+
+// recreates the dynamic buffer in case it is too small to hold size bytes
+static void ensureDynamicBufferSize(QRhi *rhi, QRhiBuffer *&buffer, QRhiBuffer::UsageFlag usage, quint32 size,
+                                    QVector<QRhiResource *> &cleanupList)
+{
+    if (buffer && buffer->size() >= size) {
+        return;
+    }
+
+    if (buffer) {
+        // Destroy old buffer and remove from cleanup list
+        cleanupList.removeAll(buffer);
+        buffer->destroy();
+        delete buffer;
+    }
+
+    buffer = rhi->newBuffer(QRhiBuffer::Dynamic, usage, size);
+    cleanupList.append(buffer);
+    buffer->create();
+}
+
+// the pixels of the viewport whose centres are inside of the rectangle, QRhi expects the origin bottom left
+static QRhiScissor scissorFor(const QRectF &rect, const QMatrix4x4 &matrix, const QRhiViewport &viewport)
+{
+    // the same mapping the vertex shader applies, so the scissor ends exactly where the geometry would be clipped
+    const QVector3D topLeft = matrix.map(QVector3D(rect.left(), rect.top(), 0.0f));
+    const QVector3D bottomRight = matrix.map(QVector3D(rect.right(), rect.bottom(), 0.0f));
+
+    const auto [viewportX, viewportY, viewportWidth, viewportHeight] = viewport.viewport();
+    const auto toPixels = [](float ndc, float size) { return qBound(0.0f, (ndc + 1.0f) * 0.5f * size, size); };
+    const float left = viewportX + toPixels(qMin(topLeft.x(), bottomRight.x()), viewportWidth);
+    const float right = viewportX + toPixels(qMax(topLeft.x(), bottomRight.x()), viewportWidth);
+    const float bottom = viewportY + toPixels(qMin(topLeft.y(), bottomRight.y()), viewportHeight);
+    const float top = viewportY + toPixels(qMax(topLeft.y(), bottomRight.y()), viewportHeight);
+
+    const int x = qCeil(left - 0.5f);
+    const int y = qCeil(bottom - 0.5f);
+    return QRhiScissor(x, y, qMax(0, qCeil(right - 0.5f) - x), qMax(0, qCeil(top - 0.5f) - y));
+}
+
+// the texture coordinates of the blend quad, the region of the surfaces the item draws to
+static QVector<QVector2D> blendTexCoords(const QRectF &texCoordRect)
+{
+    return { QVector2D(texCoordRect.left(), texCoordRect.top()), QVector2D(texCoordRect.left(), texCoordRect.bottom()),
+             QVector2D(texCoordRect.right(), texCoordRect.top()), QVector2D(texCoordRect.right(), texCoordRect.bottom()) };
+}
+
+// true in case the buffer already holds this version of the geometry, the buffer is taken to hold it from now on
+static bool holdsGeometryVersion(quint64 &bufferVersion, quint64 version)
+{
+    const bool holds = version != 0 && version == bufferVersion;
+    bufferVersion = version;
+    return holds;
+}
+
+static RhiResourceRegistry::PaintType paintTypeOf(bool texture, const QGradient *gradient, int gradientType)
+{
+    if (texture) {
+        return RhiResourceRegistry::PaintType::Texture;
+    }
+    if (gradient) {
+        return gradientType == 0 ? RhiResourceRegistry::PaintType::LinearGradient : RhiResourceRegistry::PaintType::RadialGradient;
+    }
+    return RhiResourceRegistry::PaintType::Solid;
+}
+
 TextureTargetNode::TextureTargetNode(QQuickWindow *window, RiveQSGRHIRenderNode *node, const QRectF &viewPortRect,
                                      const QMatrix4x4 *combinedMatrix, const QMatrix4x4 *projectionMatrix)
     : m_combinedMatrix(combinedMatrix)
@@ -18,10 +98,7 @@ TextureTargetNode::TextureTargetNode(QQuickWindow *window, RiveQSGRHIRenderNode
     , m_window(window)
     , m_node(node)
 {
-    m_blendTexCoords.append(QVector2D(0.0f, 0.0f));
-    m_blendTexCoords.append(QVector2D(0.0f, 1.0f));
-    m_blendTexCoords.append(QVector2D(1.0f, 0.0f));
-    m_blendTexCoords.append(QVector2D(1.0f, 1.0f));
+    m_blendTexCoords = blendTexCoords(m_node->surfaceTexCoordRect());
 
     m_blendVertices.append(QVector2D(viewPortRect.x(), viewPortRect.y()));
     m_blendVertices.append(QVector2D(viewPortRect.x(), viewPortRect.y() + viewPortRect.height()));
@@ -52,9 +129,6 @@ TextureTargetNode::TextureTargetNode(QQuickWindow *window, RiveQSGRHIRenderNode
         m_cleanupList.append(m_clippingVertexBuffer);
         m_clippingVertexBuffer->create();
     }
-
-    m_clearData.resize(m_maximumVerticies * sizeof(QVector2D));
-    memset(m_clearData.data(), 0, m_maximumVerticies * sizeof(QVector2D));
 }
 
 TextureTargetNode::~TextureTargetNode()
@@ -73,6 +147,28 @@ void TextureTargetNode::recycle()
     m_clippingData.clear();
     m_texCoordData.clear();
     m_indicesData.clear();
+    m_geometryIndexData.clear();
+    m_clippingIndexData.clear();
+    m_geometryIndexCount = 0;
+    m_clippingIndexCount = 0;
+    m_stencilFillData.clear();
+    m_stencilFillIndexData.clear();
+    m_stencilFillIndexCount = 0;
+    m_stencilFill = false;
+    m_writeOnce = false;
+    m_gpuStroke = false;
+    m_strokeInstances = {};
+    m_antialiasingFringe = false;
+    m_fringeInstances = {};
+    m_retainedGeometry = nullptr;
+    m_scissor = false;
+    m_overwrite = false;
+    m_gpuTessellation = false;
+    m_wedgeInstanceData.clear();
+    m_wedgeLineCount = 0;
+    m_wedgeCubicCount = 0;
+    m_pathInstanceData.clear();
+    m_pathInstanceCount = 0;
     useGradient = 0;
     m_blendMode = rive::BlendMode::srcOver;
     m_opacity = 1.0f;
@@ -82,25 +178,26 @@ void TextureTargetNode::recycle()
     if (m_qImageTexture && m_useTexture) {
         m_useTexture = false;
 
-        if (m_sampler) {
-            m_cleanupList.removeAll(m_sampler);
-            m_sampler->destroy();
-            delete m_sampler;
-            m_sampler = nullptr;
-        }
-
-        if (m_qImageTexture) {
+        if (!m_externalTexture) {
             m_cleanupList.removeAll(m_qImageTexture);
             m_qImageTexture->destroy();
             delete m_qImageTexture;
-            m_qImageTexture = nullptr;
         }
+        m_qImageTexture = nullptr;
     }
+    m_externalTexture = false;
     m_recycled = true;
 }
 
 void TextureTargetNode::releaseResources()
 {
+    m_geometryVersion = 0;
+    m_stencilFillVersion = 0;
+    m_strokeInstanceVersion = 0;
+    m_fringeInstanceVersion = 0;
+    m_wedgeVersion = 0;
+    m_retainedGeometry = nullptr;
+
     while (!m_cleanupList.empty()) {
         auto *resource = m_cleanupList.first();
         m_cleanupList.removeAll(resource);
@@ -108,6 +205,13 @@ void TextureTargetNode::releaseResources()
         delete resource;
         resource = nullptr;
     }
+
+    // owned textures went with the cleanup list, the next draw sets its texture again
+    m_qImageTexture = nullptr;
+    m_useTexture = false;
+    m_externalTexture = false;
+    m_drawBindingsTexture = nullptr;
+    m_fringeBindingsTexture = nullptr;
 }
 
 void TextureTargetNode::updateViewport(const QRectF &rect)
@@ -121,6 +225,8 @@ void TextureTargetNode::updateViewport(const QRectF &rect)
     m_blendVertices.append(QVector2D(rect.x() + rect.width(), rect.y()));
     m_blendVertices.append(QVector2D(rect.x() + rect.width(), rect.y() + rect.height()));
 
+    m_blendTexCoords = blendTexCoords(m_node->surfaceTexCoordRect());
+
     m_rect = rect;
     m_blendVerticesDirty = true;
 }
@@ -133,27 +239,66 @@ void TextureTargetNode::prepareRender()
 
     m_resourceUpdates = rhi->nextResourceUpdateBatch();
 
-    if (m_oldBufferSize > m_geometryData.size()) {
-        m_resourceUpdates->updateDynamicBuffer(m_vertexBuffer, 0,
-                                               qMin((unsigned long long)m_clearData.size(), m_maximumVerticies * sizeof(QVector2D)),
-                                               m_clearData.constData());
-        m_resourceUpdates->updateDynamicBuffer(m_clippingVertexBuffer, 0,
-                                               qMin((unsigned long long)m_clearData.size(), m_maximumClippingVerticies * sizeof(QVector2D)),
-                                               m_clearData.constData());
-    } else {
+    // indexed draws only touch what the index data references, stale data behind it does not need to be cleared
+    if (!m_geometryData.isEmpty()) {
         m_resourceUpdates->updateDynamicBuffer(m_vertexBuffer, 0,
                                                qMin((unsigned long long)m_geometryData.size(), m_maximumVerticies * sizeof(QVector2D)),
                                                m_geometryData.constData());
+    }
+
+    if (m_geometryIndexBuffer && !m_geometryIndexData.isEmpty()) {
+        m_resourceUpdates->updateDynamicBuffer(m_geometryIndexBuffer, 0, m_geometryIndexData.size(), m_geometryIndexData.constData());
+    }
+
+    if (m_clip && !m_clippingData.isEmpty()) {
         m_resourceUpdates->updateDynamicBuffer(
             m_clippingVertexBuffer, 0, qMin((unsigned long long)m_clippingData.size(), m_maximumClippingVerticies * sizeof(QVector2D)),
             m_clippingData.constData());
     }
 
+    if (m_clip && m_clippingIndexBuffer && !m_clippingIndexData.isEmpty()) {
+        m_resourceUpdates->updateDynamicBuffer(m_clippingIndexBuffer, 0, m_clippingIndexData.size(), m_clippingIndexData.constData());
+    }
+
+    if (m_stencilFill && m_stencilFillIndexCount > 0 && !m_stencilFillIndexData.isEmpty()) {
+        m_resourceUpdates->updateDynamicBuffer(m_stencilFillVertexBuffer, 0, m_stencilFillData.size(), m_stencilFillData.constData());
+        m_resourceUpdates->updateDynamicBuffer(m_stencilFillIndexBuffer, 0, m_stencilFillIndexData.size(),
+                                               m_stencilFillIndexData.constData());
+    }
+
+    if (m_gpuTessellation && !m_wedgeInstanceData.isEmpty()) {
+        m_resourceUpdates->updateDynamicBuffer(m_wedgeInstanceBuffer, 0, m_wedgeInstanceData.size(), m_wedgeInstanceData.constData());
+    }
+
+    if (m_gpuStroke && !m_strokeInstances.data.isEmpty()) {
+        m_resourceUpdates->updateDynamicBuffer(m_strokeInstanceBuffer, 0, m_strokeInstances.data.size(),
+                                               m_strokeInstances.data.constData());
+    }
+
+    if (m_antialiasingFringe && !m_fringeInstances.data.isEmpty()) {
+        m_resourceUpdates->updateDynamicBuffer(m_fringeInstanceBuffer, 0, m_fringeInstances.data.size(),
+                                               m_fringeInstances.data.constData());
+    }
+
+    if (m_pathInstanceCount > 0) {
+        m_resourceUpdates->updateDynamicBuffer(m_pathInstanceBuffer, 0, m_pathInstanceData.size(), m_pathInstanceData.constData());
+    }
+
+    if (m_retainedGeometry && !m_retainedGeometry->vertexData.isEmpty()) {
+        m_resourceUpdates->uploadStaticBuffer(m_retainedGeometry->vertexBuffer, m_retainedGeometry->vertexData.constData());
+        m_retainedGeometry->vertexData.clear();
+    }
+
+    if (m_retainedGeometry && !m_retainedGeometry->indexData.isEmpty()) {
+        m_resourceUpdates->uploadStaticBuffer(m_retainedGeometry->indexBuffer, m_retainedGeometry->indexData.constData());
+        m_retainedGeometry->indexData.clear();
+    }
+
     if (!m_useTexture) {
         m_qImageTexture = m_node->getDummyTexture();
     }
 
-    if (m_useTexture && m_qImageTexture) {
+    if (m_useTexture && m_qImageTexture && !m_externalTexture) {
         m_resourceUpdates->uploadTexture(m_qImageTexture, m_texture);
     }
 
@@ -168,11 +313,18 @@ void TextureTargetNode::prepareRender()
     // shared buffers / bindings will transfer information into multiple passes
     // this is why each objects needs its own buffers
     if (!m_drawUniformBuffer) {
-        m_drawUniformBuffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 848);
+        m_drawUniformBuffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 880);
         m_drawUniformBuffer->create();
         m_cleanupList.append(m_drawUniformBuffer);
     }
 
+    // the fringe is drawn in the same pass as the path, but with other stroke parameters
+    if (m_antialiasingFringe && !m_fringeUniformBuffer) {
+        m_fringeUniformBuffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 880);
+        m_fringeUniformBuffer->create();
+        m_cleanupList.append(m_fringeUniformBuffer);
+    }
+
     if (!m_clippingUniformBuffer) {
         m_clippingUniformBuffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 128);
         m_clippingUniformBuffer->create();
@@ -187,23 +339,59 @@ void TextureTargetNode::prepareRender()
         m_cleanupList.append(m_clippingResourceBindings);
     }
 
-    if (!m_sampler) {
-        m_sampler = rhi->newSampler(QRhiSampler::Linear, QRhiSampler::Linear, QRhiSampler::None, QRhiSampler::ClampToEdge,
-                                    QRhiSampler::ClampToEdge);
-        m_sampler->create();
-        m_cleanupList.append(m_sampler);
+    if (m_stencilFill && !m_stencilFillUniformBuffer) {
+        m_stencilFillUniformBuffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 144);
+        m_stencilFillUniformBuffer->create();
+        m_cleanupList.append(m_stencilFillUniformBuffer);
     }
 
-    if (!m_drawPipelineResourceBindings) {
-        m_drawPipelineResourceBindings = rhi->newShaderResourceBindings();
+    if (m_stencilFill && !m_stencilFillResourceBindings) {
+        m_stencilFillResourceBindings = rhi->newShaderResourceBindings();
+        m_stencilFillResourceBindings->setBindings({ QRhiShaderResourceBinding::uniformBuffer(
+            0, QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage, m_stencilFillUniformBuffer) });
+        m_stencilFillResourceBindings->create();
+        m_cleanupList.append(m_stencilFillResourceBindings);
+    }
+
+    // the bindings follow the texture, images are recreated when their size changes and cached textures change per draw
+    if (!m_drawPipelineResourceBindings || m_drawBindingsTexture != m_qImageTexture) {
+        if (!m_drawPipelineResourceBindings) {
+            m_drawPipelineResourceBindings = rhi->newShaderResourceBindings();
+            m_cleanupList.append(m_drawPipelineResourceBindings);
+        }
 
         m_drawPipelineResourceBindings->setBindings({
             QRhiShaderResourceBinding::uniformBuffer(0, QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage,
                                                      m_drawUniformBuffer),
-            QRhiShaderResourceBinding::sampledTexture(1, QRhiShaderResourceBinding::FragmentStage, m_qImageTexture, m_sampler) //
+            QRhiShaderResourceBinding::sampledTexture(1, QRhiShaderResourceBinding::FragmentStage, m_qImageTexture,
+                                                      m_node->linearSampler()) //
         });
         m_drawPipelineResourceBindings->create();
-        m_cleanupList.append(m_drawPipelineResourceBindings);
+        m_drawBindingsTexture = m_qImageTexture;
+    }
+
+    if (!m_paintResourceBindings) {
+        m_paintResourceBindings = rhi->newShaderResourceBindings();
+        m_paintResourceBindings->setBindings({ QRhiShaderResourceBinding::uniformBuffer(
+            0, QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage, m_drawUniformBuffer) });
+        m_paintResourceBindings->create();
+        m_cleanupList.append(m_paintResourceBindings);
+    }
+
+    if (m_antialiasingFringe && (!m_fringeResourceBindings || m_fringeBindingsTexture != m_qImageTexture)) {
+        if (!m_fringeResourceBindings) {
+            m_fringeResourceBindings = rhi->newShaderResourceBindings();
+            m_cleanupList.append(m_fringeResourceBindings);
+        }
+
+        m_fringeResourceBindings->setBindings({
+            QRhiShaderResourceBinding::uniformBuffer(0, QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage,
+                                                     m_fringeUniformBuffer),
+            QRhiShaderResourceBinding::sampledTexture(1, QRhiShaderResourceBinding::FragmentStage, m_qImageTexture,
+                                                      m_node->linearSampler()) //
+        });
+        m_fringeResourceBindings->create();
+        m_fringeBindingsTexture = m_qImageTexture;
     }
 
     // note: the clipping path is provided in global coordinates, not local like the geometry
@@ -211,28 +399,67 @@ void TextureTargetNode::prepareRender()
     m_resourceUpdates->updateDynamicBuffer(m_clippingUniformBuffer, 0, 64, (*m_combinedMatrix).constData());
     m_resourceUpdates->updateDynamicBuffer(m_clippingUniformBuffer, 64, 64, QMatrix4x4().constData());
 
-    m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 0, 64, (*m_combinedMatrix).constData());
-    m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 784, 64, m_transform.constData());
+    // the stencil fan uses the clip shader, but it is in local coordinates like the geometry
+    if (m_stencilFill) {
+        m_resourceUpdates->updateDynamicBuffer(m_stencilFillUniformBuffer, 0, 64, (*m_combinedMatrix).constData());
+        m_resourceUpdates->updateDynamicBuffer(m_stencilFillUniformBuffer, 64, 64, m_transform.constData());
+    }
+
+    // the item may only draw to a region of the render target
+    const QSize renderTargetSize = m_node->surfaceRect().size();
+
+    // the wedge shader picks its segment counts in pixels of the render target
+    if (m_gpuTessellation) {
+        const QVector4D tessellationParams(renderTargetSize.width(), renderTargetSize.height(), GPU_TESSELLATION_TOLERANCE, 0.0f);
+        m_resourceUpdates->updateDynamicBuffer(m_stencilFillUniformBuffer, 128, 16, &tessellationParams);
+    }
+
+    // the material of the fringe is the one of the path
+    const auto updateDrawUniforms = [this](quint32 offset, quint32 size, const void *data) {
+        m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, offset, size, data);
+        if (m_antialiasingFringe) {
+            m_resourceUpdates->updateDynamicBuffer(m_fringeUniformBuffer, offset, size, data);
+        }
+    };
+
+    updateDrawUniforms(0, 64, (*m_combinedMatrix).constData());
+    updateDrawUniforms(784, 64, m_transform.constData());
+
+    if (m_gpuStroke) {
+        m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 848, 16, &m_strokeInstances.params);
+    }
 
-    float opacity = m_opacity;
-    m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 64, 4, &opacity);
+    // the path itself is drawn without fringe, the stroke shader measures the fringe in pixels of the render target
+    const QVector4D antialiasingParams(renderTargetSize.width(), renderTargetSize.height(), 0.0f, 0.0f);
+    m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 864, 16, &antialiasingParams);
+
+    if (m_antialiasingFringe) {
+        const QVector4D fringeParams(renderTargetSize.width(), renderTargetSize.height(), ANTIALIASING_FRINGE_WIDTH, 0.0f);
+        m_resourceUpdates->updateDynamicBuffer(m_fringeUniformBuffer, 848, 16, &m_fringeInstances.params);
+        m_resourceUpdates->updateDynamicBuffer(m_fringeUniformBuffer, 864, 16, &fringeParams);
+    }
+
+    // instances bring their own opacity
+    float opacity = m_pathInstanceCount > 0 ? 1.0f : m_opacity;
+    updateDrawUniforms(64, 4, &opacity);
     int useGradient = m_gradient != nullptr ? 1 : 0; // 72
-    m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 72, 4, &useGradient);
-    int useTexture = m_qImageTexture != nullptr && m_useTexture; // 76
-    m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 76, 4, &useTexture);
+    updateDrawUniforms(72, 4, &useGradient);
+    // 2 for premultiplied textures, the shaders divide by alpha then
+    int useTexture = m_qImageTexture != nullptr && m_useTexture ? (m_externalTexture ? 2 : 1) : 0; // 76
+    updateDrawUniforms(76, 4, &useTexture);
 
     if (m_gradient) {
-        m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 68, 4, &m_gradientData.gradientRadius);
-        m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 80, 4, &m_gradientData.gradientFocalPointX);
-        m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 84, 4, &m_gradientData.gradientFocalPointY);
-        m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 88, 4, &m_gradientData.gradientCenterX);
-        m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 92, 4, &m_gradientData.gradientCenterY);
-        m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 96, 4, &m_gradientData.startPointX);
-        m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 100, 4, &m_gradientData.startPointY);
-        m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 104, 4, &m_gradientData.endPointX);
-        m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 108, 4, &m_gradientData.endPointY);
-        m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 112, 4, &m_gradientData.numberOfStops);
-        m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 116, 4, &m_gradientData.gradientType);
+        updateDrawUniforms(68, 4, &m_gradientData.gradientRadius);
+        updateDrawUniforms(80, 4, &m_gradientData.gradientFocalPointX);
+        updateDrawUniforms(84, 4, &m_gradientData.gradientFocalPointY);
+        updateDrawUniforms(88, 4, &m_gradientData.gradientCenterX);
+        updateDrawUniforms(92, 4, &m_gradientData.gradientCenterY);
+        updateDrawUniforms(96, 4, &m_gradientData.startPointX);
+        updateDrawUniforms(100, 4, &m_gradientData.startPointY);
+        updateDrawUniforms(104, 4, &m_gradientData.endPointX);
+        updateDrawUniforms(108, 4, &m_gradientData.endPointY);
+        updateDrawUniforms(112, 4, &m_gradientData.numberOfStops);
+        updateDrawUniforms(116, 4, &m_gradientData.gradientType);
 
         int startStopColorsOffset = 144;
         int gradientPositionsOffset = 464;
@@ -241,16 +468,16 @@ void TextureTargetNode::prepareRender()
             float g = m_gradientData.gradientColors[i].greenF();
             float b = m_gradientData.gradientColors[i].blueF();
             float a = m_gradientData.gradientColors[i].alphaF();
-            m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, startStopColorsOffset, 4, &r);
-            m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, startStopColorsOffset + 4, 4, &g);
-            m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, startStopColorsOffset + 8, 4, &b);
-            m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, startStopColorsOffset + 12, 4, &a);
+            updateDrawUniforms(startStopColorsOffset, 4, &r);
+            updateDrawUniforms(startStopColorsOffset + 4, 4, &g);
+            updateDrawUniforms(startStopColorsOffset + 8, 4, &b);
+            updateDrawUniforms(startStopColorsOffset + 12, 4, &a);
             startStopColorsOffset += 16;
 
             float x = m_gradientData.gradientPositions[i].x();
             float y = m_gradientData.gradientPositions[i].y();
-            m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, gradientPositionsOffset, 4, &x);
-            m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, gradientPositionsOffset + 4, 4, &y);
+            updateDrawUniforms(gradientPositionsOffset, 4, &x);
+            updateDrawUniforms(gradientPositionsOffset + 4, 4, &y);
             gradientPositionsOffset += 16;
         }
     } else {
@@ -258,10 +485,10 @@ void TextureTargetNode::prepareRender()
         float g = m_color.greenF();
         float b = m_color.blueF();
         float a = m_color.alphaF();
-        m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 128, 4, &r);
-        m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 132, 4, &g);
-        m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 136, 4, &b);
-        m_resourceUpdates->updateDynamicBuffer(m_drawUniformBuffer, 140, 4, &a);
+        updateDrawUniforms(128, 4, &r);
+        updateDrawUniforms(132, 4, &g);
+        updateDrawUniforms(136, 4, &b);
+        updateDrawUniforms(140, 4, &a);
     }
 }
 
@@ -277,62 +504,173 @@ void TextureTargetNode::render(QRhiCommandBuffer *commandBuffer)
 
     prepareRender();
 
-    auto *currentDisplayBufferTarget = m_node->currentRenderTarget(m_shaderBlending);
+    commandBuffer->beginPass(m_node->currentRenderTarget(m_shaderBlending), QColor(0, 0, 0, 0), { 1.0f, 0 }, m_resourceUpdates);
+    recordDraws(commandBuffer);
+    commandBuffer->endPass();
+
+    if (m_shaderBlending) {
+        renderBlend(commandBuffer);
+    }
+}
+
+void TextureTargetNode::uploadResources(QRhiCommandBuffer *commandBuffer)
+{
+    Q_ASSERT(commandBuffer);
+
+    prepareRender();
+    commandBuffer->resourceUpdate(m_resourceUpdates);
+    m_resourceUpdates = nullptr;
+}
+
+size_t TextureTargetNode::stateKey() const
+{
+    // the texture is only known once prepareRender ran, a texture paint without one falls back to the solid pipeline
+    return qHashMulti(0, m_overwrite, m_pathInstanceCount > 0, m_stencilFill, m_gpuTessellation, m_stencilFillEvenOdd, m_gpuStroke,
+                      m_writeOnce, m_antialiasingFringe, m_clip, m_shaderBlending,
+                      static_cast<int>(paintTypeOf(m_useTexture, m_gradient, m_gradientData.gradientType)));
+}
+
+void TextureTargetNode::recordDraws(QRhiCommandBuffer *commandBuffer)
+{
     auto *clipPipeline = m_node->clippingPipeline();
+    auto *stencilFillPipeline = m_gpuTessellation ? m_node->wedgeFillPipeline(m_stencilFillEvenOdd)
+                                                   : m_node->stencilFillPipeline(m_stencilFillEvenOdd);
     auto *drawPipeline = m_node->renderPipeline(m_shaderBlending);
+    if (m_overwrite) {
+        drawPipeline = m_node->overwritePipeline();
+    } else if (m_pathInstanceCount > 0) {
+        drawPipeline = m_node->pathInstancePipeline();
+    } else if (m_stencilFill) {
+        drawPipeline = m_node->coverPipeline(m_shaderBlending);
+    } else if (m_gpuStroke) {
+        drawPipeline = m_node->strokePipeline(m_shaderBlending);
+    } else if (m_writeOnce || m_antialiasingFringe) {
+        // the fringe relies on the path marking the stencil where it was drawn
+        drawPipeline = m_node->writeOncePipeline(m_shaderBlending);
+    }
+    auto *fringePipeline = m_antialiasingFringe ? m_node->strokePipeline(m_shaderBlending) : nullptr;
+
+    // pick the fragment shader that only handles this paint instead of branching per fragment
+    const auto paintType = paintTypeOf(m_useTexture && m_qImageTexture, m_gradient, m_gradientData.gradientType);
+    auto *paintPipeline = m_node->paintPipeline(drawPipeline, paintType);
+    // the generic pipeline is the fallback, it expects the texture binding
+    auto *drawResourceBindings = paintType == RhiResourceRegistry::PaintType::Texture || paintPipeline == drawPipeline
+        ? m_drawPipelineResourceBindings
+        : m_paintResourceBindings;
+    drawPipeline = paintPipeline;
 
     // it seems we can alter the pass descriptor (we cant change blendmodes or such)
     drawPipeline->setRenderPassDescriptor(m_node->currentRenderPassDescriptor(m_shaderBlending));
     clipPipeline->setRenderPassDescriptor(m_node->currentRenderPassDescriptor(m_shaderBlending));
+    stencilFillPipeline->setRenderPassDescriptor(m_node->currentRenderPassDescriptor(m_shaderBlending));
+    if (fringePipeline) {
+        fringePipeline->setRenderPassDescriptor(m_node->currentRenderPassDescriptor(m_shaderBlending));
+    }
 
-    commandBuffer->beginPass(currentDisplayBufferTarget, QColor(0, 0, 0, 0), { 1.0f, 0 }, m_resourceUpdates);
     {
-        const QSize renderTargetSize = currentDisplayBufferTarget->pixelSize();
+        const QRhiViewport viewport = m_node->surfaceViewport();
+        const std::array<float, 4> area = viewport.viewport();
+        // all pipelines use the scissor, without a rectangle clip it covers the whole viewport
+        const QRhiScissor scissor = m_scissor ? scissorFor(m_scissorRect, *m_combinedMatrix, viewport)
+                                              : QRhiScissor(qRound(area[0]), qRound(area[1]), qRound(area[2]), qRound(area[3]));
 
         if (m_clip) {
             commandBuffer->setGraphicsPipeline(clipPipeline);
-            commandBuffer->setStencilRef(1);
-            commandBuffer->setViewport(QRhiViewport(0, 0, renderTargetSize.width(), renderTargetSize.height()));
+            commandBuffer->setStencilRef(CLIP_STENCIL_BIT);
+            commandBuffer->setViewport(viewport);
+            commandBuffer->setScissor(scissor);
             commandBuffer->setShaderResources(m_clippingResourceBindings);
-            QRhiCommandBuffer::VertexInput clipVertexBindings[] = { { m_clippingVertexBuffer, 0 } };
-            commandBuffer->setVertexInput(0, 1, clipVertexBindings);
-            commandBuffer->draw(m_clippingData.size() / sizeof(QVector2D));
+            if (m_clippingIndexBuffer && m_clippingIndexCount > 0) {
+                QRhiCommandBuffer::VertexInput clipVertexBindings[] = { { m_clippingVertexBuffer, 0 } };
+                commandBuffer->setVertexInput(0, 1, clipVertexBindings, m_clippingIndexBuffer, 0,
+                                              m_clippingUses32BitIndices ? QRhiCommandBuffer::IndexUInt32 : QRhiCommandBuffer::IndexUInt16);
+                commandBuffer->drawIndexed(m_clippingIndexCount);
+            }
+            commandBuffer->setStencilRef(0);
+        }
+
+        if (m_stencilFill && m_gpuTessellation && m_wedgeInstanceBuffer) {
+            commandBuffer->setGraphicsPipeline(stencilFillPipeline);
+            commandBuffer->setStencilRef(m_clip ? CLIP_STENCIL_BIT : 0);
+            commandBuffer->setViewport(viewport);
+            commandBuffer->setScissor(scissor);
+            commandBuffer->setShaderResources(m_stencilFillResourceBindings);
+            const int instanceCounts[] = { m_wedgeLineCount, m_wedgeCubicCount };
+            const int vertexCounts[] = { 3, 3 * GPU_TESSELLATION_MAX_SEGMENTS };
+            quint32 offset = 0;
+            for (int i = 0; i < 2; ++i) {
+                if (instanceCounts[i] > 0) {
+                    QRhiCommandBuffer::VertexInput instanceBindings[] = { { m_wedgeInstanceBuffer, offset } };
+                    commandBuffer->setVertexInput(0, 1, instanceBindings);
+                    commandBuffer->draw(vertexCounts[i], instanceCounts[i]);
+                }
+                offset += instanceCounts[i] * sizeof(RiveQtCurveWedge);
+            }
+            commandBuffer->setStencilRef(0);
+        } else if (m_stencilFill && m_stencilFillIndexCount > 0) {
+            commandBuffer->setGraphicsPipeline(stencilFillPipeline);
+            commandBuffer->setStencilRef(m_clip ? CLIP_STENCIL_BIT : 0);
+            commandBuffer->setViewport(viewport);
+            commandBuffer->setScissor(scissor);
+            commandBuffer->setShaderResources(m_stencilFillResourceBindings);
+            QRhiCommandBuffer::VertexInput stencilFillVertexBindings[] = { { m_stencilFillVertexBuffer, 0 } };
+            commandBuffer->setVertexInput(0, 1, stencilFillVertexBindings, m_stencilFillIndexBuffer, 0,
+                                          m_stencilFillUses32BitIndices ? QRhiCommandBuffer::IndexUInt32 : QRhiCommandBuffer::IndexUInt16);
+            commandBuffer->drawIndexed(m_stencilFillIndexCount);
             commandBuffer->setStencilRef(0);
         }
 
         commandBuffer->setGraphicsPipeline(drawPipeline);
-        commandBuffer->setViewport(QRhiViewport(0, 0, renderTargetSize.width(), renderTargetSize.height()));
-        commandBuffer->setShaderResources(m_drawPipelineResourceBindings);
+        commandBuffer->setViewport(viewport);
+        commandBuffer->setScissor(scissor);
+        commandBuffer->setShaderResources(drawResourceBindings);
 
-        if (m_qImageTexture && m_indicesBuffer && m_texCoordBuffer && m_useTexture) {
+        const bool drawTexture = m_qImageTexture && m_indicesBuffer && m_texCoordBuffer && m_useTexture;
+
+        if (drawTexture) {
             QRhiCommandBuffer::VertexInput vertexBindings[] = { { m_vertexBuffer, 0 }, { m_texCoordBuffer, 0 } };
             commandBuffer->setVertexInput(0, 2, vertexBindings, m_indicesBuffer, 0, QRhiCommandBuffer::IndexUInt16);
-        } else {
+        } else if (m_retainedGeometry && !m_gpuStroke) {
+            QRhiCommandBuffer::VertexInput vertexBindings[] = { { m_retainedGeometry->vertexBuffer, 0 },
+                                                                { m_retainedGeometry->vertexBuffer, 0 },
+                                                                { m_pathInstanceBuffer, 0 } };
+            commandBuffer->setVertexInput(0, m_pathInstanceCount > 0 ? 3 : 2, vertexBindings, m_retainedGeometry->indexBuffer, 0,
+                                          m_geometryUses32BitIndices ? QRhiCommandBuffer::IndexUInt32 : QRhiCommandBuffer::IndexUInt16);
+        } else if (m_geometryIndexBuffer && !m_gpuStroke) {
             // Some APIs, such as Metal, may raise complaints when a binding for a vertex attribute is missing;
             // in this specific code path, m_texCoordBuffer is nullptr, so if you attempt to bind this buffer,
             // the application will crash. As a workaround, we bind the texture coordinate attribute to the vertex
             // buffer as well. This way, Metal won't encounter any assertions, and the texture coordinates are
             // not needed in this context anyway.
-            QRhiCommandBuffer::VertexInput vertexBindings[] = { { m_vertexBuffer, 0 }, { m_vertexBuffer, 0 } };
-            commandBuffer->setVertexInput(0, 2, vertexBindings);
+            QRhiCommandBuffer::VertexInput vertexBindings[] = { { m_vertexBuffer, 0 }, { m_vertexBuffer, 0 }, { m_pathInstanceBuffer, 0 } };
+            commandBuffer->setVertexInput(0, m_pathInstanceCount > 0 ? 3 : 2, vertexBindings, m_geometryIndexBuffer, 0,
+                                          m_geometryUses32BitIndices ? QRhiCommandBuffer::IndexUInt32 : QRhiCommandBuffer::IndexUInt16);
         }
 
-        if (m_clip) {
-            commandBuffer->setStencilRef(1);
+        // the cover pass tests the winding bits against 0, regular draws test the clip bit
+        if (m_clip && !m_stencilFill) {
+            commandBuffer->setStencilRef(CLIP_STENCIL_BIT);
         } else {
             commandBuffer->setStencilRef(0);
         }
 
-        if (m_qImageTexture && m_indicesBuffer && m_useTexture) {
+        if (drawTexture) {
             commandBuffer->drawIndexed(m_indicesBuffer->size() / sizeof(uint16_t));
-        } else {
-            commandBuffer->draw(m_geometryData.size() / sizeof(QVector2D));
+        } else if (m_gpuStroke && m_strokeInstanceBuffer) {
+            drawStrokeInstances(commandBuffer, m_strokeInstanceBuffer, m_strokeInstances);
+        } else if ((m_retainedGeometry || m_geometryIndexBuffer) && m_geometryIndexCount > 0) {
+            commandBuffer->drawIndexed(m_geometryIndexCount, qMax(1, m_pathInstanceCount));
         }
-    }
-    commandBuffer->endPass();
 
-    if (m_shaderBlending) {
-        renderBlend(commandBuffer);
+        // the stencil test keeps the fringe outside of what the path has drawn
+        if (fringePipeline && m_fringeInstanceBuffer && !drawTexture) {
+            commandBuffer->setGraphicsPipeline(fringePipeline);
+            commandBuffer->setViewport(viewport);
+            commandBuffer->setScissor(scissor);
+            commandBuffer->setShaderResources(m_fringeResourceBindings);
+            commandBuffer->setStencilRef(m_clip ? CLIP_STENCIL_BIT : 0);
+            drawStrokeInstances(commandBuffer, m_fringeInstanceBuffer, m_fringeInstances);
+        }
     }
 }
 
@@ -380,13 +718,6 @@ void TextureTargetNode::renderBlend(QRhiCommandBuffer *cb)
         m_blendResourceUpdates->uploadStaticBuffer(m_blendTexCoordBuffer, blendTexCoordData);
     }
 
-    if (!m_blendSampler) {
-        m_blendSampler = rhi->newSampler(QRhiSampler::Linear, QRhiSampler::Linear, QRhiSampler::None, QRhiSampler::ClampToEdge,
-                                         QRhiSampler::ClampToEdge);
-        m_cleanupList.append(m_blendSampler);
-        m_blendSampler->create();
-    }
-
     if (m_blendResourceBindingsA) {
         m_cleanupList.removeAll(m_blendResourceBindingsA);
         m_blendResourceBindingsA->destroy();
@@ -413,9 +744,9 @@ void TextureTargetNode::renderBlend(QRhiCommandBuffer *cb)
             QRhiShaderResourceBinding::uniformBuffer(0, QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage,
                                                      m_blendUniformBuffer),
             QRhiShaderResourceBinding::sampledTexture(1, QRhiShaderResourceBinding::FragmentStage, m_node->getRenderBufferB(),
-                                                      m_blendSampler),
+                                                      m_node->linearSampler()),
             QRhiShaderResourceBinding::sampledTexture(2, QRhiShaderResourceBinding::FragmentStage, m_node->getRenderBufferIntern(),
-                                                      m_blendSampler),
+                                                      m_node->linearSampler()),
         });
 
         m_blendResourceBindingsA->create();
@@ -428,9 +759,9 @@ void TextureTargetNode::renderBlend(QRhiCommandBuffer *cb)
             QRhiShaderResourceBinding::uniformBuffer(0, QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage,
                                                      m_blendUniformBuffer),
             QRhiShaderResourceBinding::sampledTexture(1, QRhiShaderResourceBinding::FragmentStage, m_node->getRenderBufferA(),
-                                                      m_blendSampler),
+                                                      m_node->linearSampler()),
             QRhiShaderResourceBinding::sampledTexture(2, QRhiShaderResourceBinding::FragmentStage, m_node->getRenderBufferIntern(),
-                                                      m_blendSampler),
+                                                      m_node->linearSampler()),
         });
 
         m_blendResourceBindingsB->create();
@@ -457,10 +788,8 @@ void TextureTargetNode::renderBlend(QRhiCommandBuffer *cb)
 
     cb->beginPass(currentDisplayBufferTarget, QColor(0, 0, 0, 0), { 1.0f, 0 }, m_blendResourceUpdates);
     {
-        QSize blendRenderTargetSize = currentDisplayBufferTarget->pixelSize();
-
         cb->setGraphicsPipeline(blendPipeline);
-        cb->setViewport(QRhiViewport(0, 0, blendRenderTargetSize.width(), blendRenderTargetSize.height()));
+        cb->setViewport(m_node->surfaceViewport());
         cb->setShaderResources(blendResourceBindings);
         QRhiCommandBuffer::VertexInput blendVertexBindings[] = { { m_blendVertexBuffer, 0 }, { m_blendTexCoordBuffer, 0 } };
         cb->setVertexInput(0, 2, blendVertexBindings);
@@ -486,6 +815,17 @@ void TextureTargetNode::setClipping(const bool clip)
     m_clip = clip;
 }
 
+void TextureTargetNode::setScissorRect(const QRectF &rect)
+{
+    m_scissor = true;
+    m_scissorRect = rect;
+}
+
+void TextureTargetNode::intersectScissorRect(const QRectF &rect)
+{
+    setScissorRect(m_scissor ? m_scissorRect.intersected(rect) : rect);
+}
+
 void TextureTargetNode::setGradient(const QGradient *gradient)
 {
     m_gradient = gradient;
@@ -531,14 +871,14 @@ void TextureTargetNode::setTexture(const QImage &image,
     LITE_RTTI_CAST_OR_RETURN(cgVertices, rive::DataRenderBuffer*, vertices.get());
     LITE_RTTI_CAST_OR_RETURN(cgUvCoords, rive::DataRenderBuffer*, uvCoords.get());
 
-    if (m_texture.size() != image.size()) {
-        if (m_sampler) {
-            m_cleanupList.removeAll(m_sampler);
-            m_sampler->destroy();
-            delete m_sampler;
-            m_sampler = nullptr;
-        }
+    // the dummy texture and textures of the caller are not ours to upload to
+    if (!m_useTexture || m_externalTexture) {
+        m_qImageTexture = nullptr;
+        m_useTexture = false;
+        m_externalTexture = false;
+    }
 
+    if (m_texture.size() != image.size()) {
         if (m_qImageTexture) {
             m_cleanupList.removeAll(m_qImageTexture);
             m_qImageTexture->destroy();
@@ -556,18 +896,13 @@ void TextureTargetNode::setTexture(const QImage &image,
 
     m_texture = image;
     m_transform = transform;
+    // the quad or mesh replaces whatever path geometry the vertex buffer held
+    m_geometryVersion = 0;
 
     QSGRendererInterface *renderInterface = m_window->rendererInterface();
     QRhi *rhi = static_cast<QRhi *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiResource));
     Q_ASSERT(rhi);
 
-    if (!m_sampler) {
-        m_sampler = rhi->newSampler(QRhiSampler::Linear, QRhiSampler::Linear, QRhiSampler::None, QRhiSampler::ClampToEdge,
-                                    QRhiSampler::ClampToEdge);
-        m_cleanupList.append(m_sampler);
-        m_sampler->create();
-    }
-
     if (!m_qImageTexture) {
         m_qImageTexture = rhi->newTexture(QRhiTexture::BGRA8, image.size(), 1);
         m_cleanupList.append(m_qImageTexture);
@@ -575,62 +910,10 @@ void TextureTargetNode::setTexture(const QImage &image,
         m_qImageTexture->create();
     }
 
-    if (m_texCoordBuffer) {
-        m_cleanupList.removeAll(m_texCoordBuffer);
-        m_texCoordBuffer->destroy();
-        delete m_texCoordBuffer;
-        m_texCoordBuffer = nullptr;
-    }
-
-    if (m_indicesBuffer) {
-        m_cleanupList.removeAll(m_indicesBuffer);
-        m_indicesBuffer->destroy();
-        delete m_indicesBuffer;
-        m_indicesBuffer = nullptr;
-    }
+    releaseTextureBuffers();
 
     if (recreate) {
-
-        QVector<QVector2D> quadVertices = {
-            QVector2D(0.0f, 0.0f), // Bottom-left
-            QVector2D(0.0f, image.height()), // Bottom-right
-            QVector2D(image.width(), 0.0f), // Top-right
-            QVector2D(image.width(), image.height()) // Top-left
-        };
-
-        QVector<QVector2D> textureCoords = {
-            QVector2D(0.0f, 0.0f), // Bottom-left
-            QVector2D(0.0f, 1.0f), // Bottom-right
-            QVector2D(1.0f, 0.0f), // Top-right
-            QVector2D(1.0f, 1.0f) // Top-left
-        };
-
-        QVector<uint16_t> indexArray = {
-            0, 1, 2, // First triangle (top-right half of the quad)
-            1, 3, 2 // Second triangle (bottom-left half of the quad)
-        };
-
-        m_geometryData.resize(quadVertices.count() * sizeof(QVector2D));
-        memcpy(m_geometryData.data(), quadVertices.constData(), quadVertices.count() * sizeof(QVector2D));
-
-        m_texCoordData.resize(textureCoords.count() * sizeof(QVector2D));
-        memcpy(m_texCoordData.data(), textureCoords.constData(), textureCoords.count() * sizeof(QVector2D));
-
-        m_indicesData.resize(indexArray.count() * sizeof(uint16_t));
-        memcpy(m_indicesData.data(), indexArray.data(), indexArray.count() * sizeof(uint16_t));
-
-        if (!m_texCoordBuffer) {
-            m_texCoordBuffer = rhi->newBuffer(QRhiBuffer::Immutable, QRhiBuffer::VertexBuffer, textureCoords.count() * sizeof(QVector2D));
-            m_cleanupList.append(m_texCoordBuffer);
-            m_texCoordBuffer->create();
-        }
-
-        if (!m_indicesBuffer) {
-            m_indicesBuffer = rhi->newBuffer(QRhiBuffer::Immutable, QRhiBuffer::IndexBuffer, indexArray.count() * sizeof(uint16_t));
-            m_cleanupList.append(m_indicesBuffer);
-            m_indicesBuffer->create();
-        }
-
+        setTextureQuad(rhi, image.size());
     } else {
 
         assert(cgVertices->sizeInBytes() == vertexCount * 2 * sizeof(float));
@@ -664,6 +947,90 @@ void TextureTargetNode::setTexture(const QImage &image,
     }
 }
 
+void TextureTargetNode::setTexture(QRhiTexture *texture, const QSize &size, const QMatrix4x4 &transform)
+{
+    if (m_qImageTexture && m_useTexture && !m_externalTexture) {
+        m_cleanupList.removeAll(m_qImageTexture);
+        m_qImageTexture->destroy();
+        delete m_qImageTexture;
+    }
+
+    m_qImageTexture = texture;
+    m_useTexture = true;
+    m_externalTexture = true;
+    m_texture = QImage();
+    m_transform = transform;
+    // the quad replaces whatever path geometry the vertex buffer held
+    m_geometryVersion = 0;
+
+    QSGRendererInterface *renderInterface = m_window->rendererInterface();
+    QRhi *rhi = static_cast<QRhi *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiResource));
+    Q_ASSERT(rhi);
+
+    releaseTextureBuffers();
+    setTextureQuad(rhi, size);
+}
+
+void TextureTargetNode::releaseTextureBuffers()
+{
+    if (m_texCoordBuffer) {
+        m_cleanupList.removeAll(m_texCoordBuffer);
+        m_texCoordBuffer->destroy();
+        delete m_texCoordBuffer;
+        m_texCoordBuffer = nullptr;
+    }
+
+    if (m_indicesBuffer) {
+        m_cleanupList.removeAll(m_indicesBuffer);
+        m_indicesBuffer->destroy();
+        delete m_indicesBuffer;
+        m_indicesBuffer = nullptr;
+    }
+}
+
+void TextureTargetNode::setTextureQuad(QRhi *rhi, const QSize &size)
+{
+    QVector<QVector2D> quadVertices = {
+        QVector2D(0.0f, 0.0f), // Bottom-left
+        QVector2D(0.0f, size.height()), // Bottom-right
+        QVector2D(size.width(), 0.0f), // Top-right
+        QVector2D(size.width(), size.height()) // Top-left
+    };
+
+    QVector<QVector2D> textureCoords = {
+        QVector2D(0.0f, 0.0f), // Bottom-left
+        QVector2D(0.0f, 1.0f), // Bottom-right
+        QVector2D(1.0f, 0.0f), // Top-right
+        QVector2D(1.0f, 1.0f) // Top-left
+    };
+
+    QVector<uint16_t> indexArray = {
+        0, 1, 2, // First triangle (top-right half of the quad)
+        1, 3, 2 // Second triangle (bottom-left half of the quad)
+    };
+
+    m_geometryData.resize(quadVertices.count() * sizeof(QVector2D));
+    memcpy(m_geometryData.data(), quadVertices.constData(), quadVertices.count() * sizeof(QVector2D));
+
+    m_texCoordData.resize(textureCoords.count() * sizeof(QVector2D));
+    memcpy(m_texCoordData.data(), textureCoords.constData(), textureCoords.count() * sizeof(QVector2D));
+
+    m_indicesData.resize(indexArray.count() * sizeof(uint16_t));
+    memcpy(m_indicesData.data(), indexArray.data(), indexArray.count() * sizeof(uint16_t));
+
+    if (!m_texCoordBuffer) {
+        m_texCoordBuffer = rhi->newBuffer(QRhiBuffer::Immutable, QRhiBuffer::VertexBuffer, textureCoords.count() * sizeof(QVector2D));
+        m_cleanupList.append(m_texCoordBuffer);
+        m_texCoordBuffer->create();
+    }
+
+    if (!m_indicesBuffer) {
+        m_indicesBuffer = rhi->newBuffer(QRhiBuffer::Immutable, QRhiBuffer::IndexBuffer, indexArray.count() * sizeof(uint16_t));
+        m_cleanupList.append(m_indicesBuffer);
+        m_indicesBuffer->create();
+    }
+}
+
 void TextureTargetNode::setBlendMode(rive::BlendMode blendMode)
 {
     switch (blendMode) {
@@ -693,91 +1060,225 @@ void TextureTargetNode::setBlendMode(rive::BlendMode blendMode)
     }
 }
 
-void TextureTargetNode::updateGeometry(const QVector<QVector<QVector2D>> &geometry, const QMatrix4x4 &transform)
+void TextureTargetNode::updateGeometry(const RiveQtPathGeometry &geometry, const QMatrix4x4 &transform, RhiRetainedGeometry *retained)
 {
     m_transform = transform;
 
-    m_oldBufferSize = m_geometryData.size();
+    m_geometryUses32BitIndices = geometry.uses32BitIndices;
+    m_geometryIndexCount = geometry.indexCount();
+    m_writeOnce = geometry.overlappingTriangles;
+
+    // the transform is a uniform, so the geometry of a static shape stays the same over the whole animation
+    m_retainedGeometry = retained;
+    if (m_retainedGeometry) {
+        return;
+    }
+
+    auto *renderInterface = m_window->rendererInterface();
+    auto *rhi = static_cast<QRhi *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiResource));
 
-    int vertexCount = 0;
-    for (const auto &segment : qAsConst(geometry)) {
-        vertexCount += segment.count();
+    if (holdsGeometryVersion(m_geometryVersion, geometry.version)) {
+        return;
     }
 
+    const int vertexCount = geometry.vertices.count();
+
     // Check if we need to resize the vertex buffer
     if (vertexCount > m_maximumVerticies) {
-        auto *renderInterface = m_window->rendererInterface();
-        auto *rhi = static_cast<QRhi *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiResource));
         m_maximumVerticies = vertexCount;
-        if (m_vertexBuffer) {
-            // Destroy old buffer and remove from cleanup list
-            m_cleanupList.removeAll(m_vertexBuffer);
-            m_vertexBuffer->destroy();
-        }
-
-        // Create new buffer with updated size
-        m_vertexBuffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::VertexBuffer, vertexCount * sizeof(QVector2D));
-        m_cleanupList.append(m_vertexBuffer);
-        m_vertexBuffer->create();
+        ensureDynamicBufferSize(rhi, m_vertexBuffer, QRhiBuffer::VertexBuffer, vertexCount * sizeof(QVector2D), m_cleanupList);
+    }
 
-        // prepare clearing data, make as much as we need to share them
-        m_clearData.resize(std::max(m_maximumVerticies, m_maximumClippingVerticies) * sizeof(QVector2D));
-        memset(m_clearData.data(), 0, std::max(m_maximumVerticies, m_maximumClippingVerticies) * sizeof(QVector2D));
+    if (!geometry.indices.isEmpty()) {
+        ensureDynamicBufferSize(rhi, m_geometryIndexBuffer, QRhiBuffer::IndexBuffer, geometry.indices.size(), m_cleanupList);
     }
 
-    m_geometryData.clear();
     m_geometryData.resize(vertexCount * sizeof(QVector2D));
+    memcpy(m_geometryData.data(), geometry.vertices.constData(), vertexCount * sizeof(QVector2D));
 
-    int offset = 0;
-    for (const auto &segment : qAsConst(geometry)) {
-        if (segment.empty()) {
-            continue;
-        }
+    m_geometryIndexData = geometry.indices;
+}
+
+void TextureTargetNode::updateClippingGeometry(const RiveQtPathGeometry &clippingGeometry)
+{
+    setClipping(!clippingGeometry.isEmpty());
+
+    auto *renderInterface = m_window->rendererInterface();
+    auto *rhi = static_cast<QRhi *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiResource));
+
+    const int vertexCount = clippingGeometry.vertices.count();
 
-        memcpy(m_geometryData.data() + offset, segment.constData(), segment.count() * sizeof(QVector2D));
-        offset += (segment.count() * sizeof(QVector2D));
+    // Check if we need to resize the vertex buffer
+    if (vertexCount > m_maximumClippingVerticies) {
+        m_maximumClippingVerticies = vertexCount;
+        ensureDynamicBufferSize(rhi, m_clippingVertexBuffer, QRhiBuffer::VertexBuffer, vertexCount * sizeof(QVector2D), m_cleanupList);
+    }
+
+    if (!clippingGeometry.indices.isEmpty()) {
+        ensureDynamicBufferSize(rhi, m_clippingIndexBuffer, QRhiBuffer::IndexBuffer, clippingGeometry.indices.size(), m_cleanupList);
     }
+
+    m_clippingData.resize(vertexCount * sizeof(QVector2D));
+    memcpy(m_clippingData.data(), clippingGeometry.vertices.constData(), vertexCount * sizeof(QVector2D));
+
+    m_clippingIndexData = clippingGeometry.indices;
+    m_clippingUses32BitIndices = clippingGeometry.uses32BitIndices;
+    m_clippingIndexCount = clippingGeometry.indexCount();
 }
 
-void TextureTargetNode::updateClippingGeometry(const QVector<QVector<QVector2D>> &clippingGeometry)
+void TextureTargetNode::updateStencilFillGeometry(const RiveQtPathGeometry &stencilGeometry, bool evenOdd)
 {
-    setClipping(!clippingGeometry.empty());
+    m_stencilFill = true;
+    m_stencilFillEvenOdd = evenOdd;
+    m_stencilFillUses32BitIndices = stencilGeometry.uses32BitIndices;
+    m_stencilFillIndexCount = stencilGeometry.isEmpty() ? 0 : stencilGeometry.indexCount();
+
+    if (holdsGeometryVersion(m_stencilFillVersion, stencilGeometry.version)) {
+        return;
+    }
+
+    auto *renderInterface = m_window->rendererInterface();
+    auto *rhi = static_cast<QRhi *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiResource));
 
-    int vertexCount = 0;
-    for (const auto &segment : qAsConst(clippingGeometry)) {
-        vertexCount += segment.count();
+    const int vertexCount = stencilGeometry.vertices.count();
+
+    if (!stencilGeometry.isEmpty()) {
+        ensureDynamicBufferSize(rhi, m_stencilFillVertexBuffer, QRhiBuffer::VertexBuffer, vertexCount * sizeof(QVector2D), m_cleanupList);
+        ensureDynamicBufferSize(rhi, m_stencilFillIndexBuffer, QRhiBuffer::IndexBuffer, stencilGeometry.indices.size(), m_cleanupList);
     }
 
-    // Check if we need to resize the vertex buffer
-    if (vertexCount > m_maximumClippingVerticies) {
+    m_stencilFillData.resize(vertexCount * sizeof(QVector2D));
+    memcpy(m_stencilFillData.data(), stencilGeometry.vertices.constData(), vertexCount * sizeof(QVector2D));
+
+    m_stencilFillIndexData = stencilGeometry.indices;
+}
+
+void TextureTargetNode::updateStrokeCenterline(const RiveQtStrokeCenterline &centerline, const QPen &pen, const QMatrix4x4 &transform)
+{
+    m_gpuStroke = true;
+    m_transform = transform;
+
+    setStrokeInstances(m_strokeInstances, m_strokeInstanceBuffer, m_strokeInstanceVersion, centerline, pen);
+}
+
+void TextureTargetNode::updateAntialiasingFringe(const RiveQtStrokeCenterline &outline, const QPen &pen)
+{
+    m_antialiasingFringe = true;
+
+    setStrokeInstances(m_fringeInstances, m_fringeInstanceBuffer, m_fringeInstanceVersion, outline, pen);
+}
+
+void TextureTargetNode::setStrokeInstances(StrokeInstances &instances, QRhiBuffer *&buffer, quint64 &bufferVersion,
+                                           const RiveQtStrokeCenterline &centerline, const QPen &pen)
+{
+    // the pen only goes into the uniforms, the instances are the same for every pen
+    if (!holdsGeometryVersion(bufferVersion, centerline.version)) {
         auto *renderInterface = m_window->rendererInterface();
         auto *rhi = static_cast<QRhi *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiResource));
-        m_maximumClippingVerticies = vertexCount;
-        if (m_clippingVertexBuffer) {
-            // Destroy old buffer and remove from cleanup list
-            m_cleanupList.removeAll(m_clippingVertexBuffer);
-            m_clippingVertexBuffer->destroy();
+
+        const int dataSize = centerline.instances.size() * sizeof(RiveQtStrokeInstance);
+
+        if (!centerline.isEmpty()) {
+            ensureDynamicBufferSize(rhi, buffer, QRhiBuffer::VertexBuffer, dataSize, m_cleanupList);
         }
 
-        // Create new buffer with updated size
-        m_clippingVertexBuffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::VertexBuffer, vertexCount * sizeof(QVector2D));
-        m_cleanupList.append(m_clippingVertexBuffer);
-        m_clippingVertexBuffer->create();
+        instances.data.resize(dataSize);
+        memcpy(instances.data.data(), centerline.instances.constData(), dataSize);
+    }
 
-        // prepare clearing data, make as much as we need to share them
-        m_clearData.resize(std::max(m_maximumVerticies, m_maximumClippingVerticies) * sizeof(QVector2D));
-        memset(m_clearData.data(), 0, std::max(m_maximumVerticies, m_maximumClippingVerticies) * sizeof(QVector2D));
+    instances.segmentCount = centerline.segmentCount;
+    instances.joinCount = centerline.joinCount;
+    instances.capCount = centerline.capCount;
+
+    float joinStyle = 0.0f;
+    switch (pen.joinStyle()) {
+    case Qt::RoundJoin:
+        joinStyle = 2.0f;
+        instances.joinVertexCount = 3 * GPU_STROKE_ROUND_SEGMENTS;
+        break;
+    case Qt::MiterJoin:
+    case Qt::SvgMiterJoin:
+        joinStyle = 1.0f;
+        instances.joinVertexCount = GPU_STROKE_MITER_VERTICES;
+        break;
+    case Qt::BevelJoin:
+    default:
+        instances.joinVertexCount = 3;
+        break;
     }
 
-    m_clippingData.resize(vertexCount * sizeof(QVector2D));
+    float capStyle = 0.0f;
+    switch (pen.capStyle()) {
+    case Qt::RoundCap:
+        capStyle = 2.0f;
+        instances.capVertexCount = 3 * GPU_STROKE_ROUND_SEGMENTS;
+        break;
+    case Qt::SquareCap:
+        capStyle = 1.0f;
+        instances.capVertexCount = GPU_STROKE_SEGMENT_VERTICES;
+        break;
+    case Qt::FlatCap:
+    default:
+        instances.capVertexCount = 0;
+        break;
+    }
 
-    int offset = 0;
-    for (const auto &segment : qAsConst(clippingGeometry)) {
-        if (segment.empty()) {
-            continue;
+    instances.params = QVector4D(static_cast<float>(pen.widthF()) / 2.0f, static_cast<float>(pen.miterLimit()), joinStyle, capStyle);
+}
+
+void TextureTargetNode::drawStrokeInstances(QRhiCommandBuffer *commandBuffer, QRhiBuffer *buffer, const StrokeInstances &instances)
+{
+    // every group needs its own vertex count, the instance buffer offset selects the group
+    const int instanceCounts[] = { instances.segmentCount, instances.joinCount, instances.capCount };
+    const int vertexCounts[] = { GPU_STROKE_SEGMENT_VERTICES, instances.joinVertexCount, instances.capVertexCount };
+    quint32 offset = 0;
+    for (int i = 0; i < 3; ++i) {
+        if (instanceCounts[i] > 0 && vertexCounts[i] > 0) {
+            QRhiCommandBuffer::VertexInput instanceBindings[] = { { buffer, offset } };
+            commandBuffer->setVertexInput(0, 1, instanceBindings);
+            commandBuffer->draw(vertexCounts[i], instanceCounts[i]);
         }
+        offset += instanceCounts[i] * sizeof(RiveQtStrokeInstance);
+    }
+}
 
-        memcpy(m_clippingData.data() + offset, segment.constData(), segment.count() * sizeof(QVector2D));
-        offset += (segment.count() * sizeof(QVector2D));
+void TextureTargetNode::updatePathInstances(const QVector<RiveQtPathInstance> &instances)
+{
+    auto *renderInterface = m_window->rendererInterface();
+    auto *rhi = static_cast<QRhi *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiResource));
+
+    const int dataSize = instances.size() * sizeof(RiveQtPathInstance);
+
+    if (!instances.isEmpty()) {
+        ensureDynamicBufferSize(rhi, m_pathInstanceBuffer, QRhiBuffer::VertexBuffer, dataSize, m_cleanupList);
     }
+
+    m_pathInstanceData.resize(dataSize);
+    memcpy(m_pathInstanceData.data(), instances.constData(), dataSize);
+    m_pathInstanceCount = instances.size();
+}
+
+void TextureTargetNode::updateCurveWedges(const RiveQtCurveWedges &wedges, bool evenOdd)
+{
+    m_stencilFill = true;
+    m_gpuTessellation = true;
+    m_stencilFillEvenOdd = evenOdd;
+    m_wedgeLineCount = wedges.lineCount;
+    m_wedgeCubicCount = wedges.cubicCount;
+
+    if (holdsGeometryVersion(m_wedgeVersion, wedges.version)) {
+        return;
+    }
+
+    auto *renderInterface = m_window->rendererInterface();
+    auto *rhi = static_cast<QRhi *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiResource));
+
+    const int dataSize = wedges.wedges.size() * sizeof(RiveQtCurveWedge);
+
+    if (!wedges.isEmpty()) {
+        ensureDynamicBufferSize(rhi, m_wedgeInstanceBuffer, QRhiBuffer::VertexBuffer, dataSize, m_cleanupList);
+    }
+
+    m_wedgeInstanceData.resize(dataSize);
+    memcpy(m_wedgeInstanceData.data(), wedges.wedges.constData(), dataSize);
 }
@@ -12,8 +12,10 @@
 
 #include <QPainterPath>
 #include <QSGRenderNode>
+#include <QVector4D>
 
 #include "riveqtutils.h"
+#include "riveqtpath.h"
 
 class QRhiCommandBuffer;
 class QRhiResourceUpdateBatch;
@@ -35,6 +37,18 @@ class QQuickItem;
 
 class RiveQSGRHIRenderNode;
 
+// immutable buffers with the geometry of a static shape, owned by RiveQtRhiRenderer and shared by the nodes drawing it
+struct RhiRetainedGeometry
+{
+    QRhiBuffer *vertexBuffer { nullptr };
+    QRhiBuffer *indexBuffer { nullptr };
+    // only set until the first node drawing the geometry uploaded it
+    QByteArray vertexData;
+    QByteArray indexData;
+    // a node drew the geometry this frame
+    bool used { false };
+};
+
 class TextureTargetNode
 {
 public:
@@ -47,13 +61,28 @@ public:
     void recycle();
     void take() { m_recycled = false; }
 
+    // records the node in a pass of its own, followed by the blend pass for shader blending
     void render(QRhiCommandBuffer *cb);
     void renderBlend(QRhiCommandBuffer *cb);
+    // to share a pass with other nodes: the uploads have to happen before the pass begins, the draws are recorded into it
+    void uploadResources(QRhiCommandBuffer *cb);
+    void recordDraws(QRhiCommandBuffer *cb);
+    // nodes with the same key draw with the same pipelines
+    size_t stateKey() const;
+    // the stencil bits the node leaves behind, a draw after it needs them cleared by a new pass in case it tests them
+    bool writesClipStencil() const { return m_clip; }
+    bool usesFillStencil() const { return m_stencilFill || m_gpuStroke || m_writeOnce || m_antialiasingFringe; }
     void releaseResources();
     void updateViewport(const QRectF &rect);
 
     void setOpacity(const float opacity);
     void setClipping(const bool clip);
+    // clips to the rectangle, in the same coordinates as the geometry, with the GPU scissor
+    void setScissorRect(const QRectF &rect);
+    // the same, but keeps what a previous scissor rect already clipped away
+    void intersectScissorRect(const QRectF &rect);
+    // draws without blending, so the geometry replaces what was drawn before, used to clear damaged areas
+    void setOverwrite(bool overwrite) { m_overwrite = overwrite; }
 
     void setColor(const QColor &color);
     void setGradient(const QGradient *gradient);
@@ -64,24 +93,65 @@ public:
                     uint32_t vertexCount, uint32_t indexCount,
                     bool recreate,
                     const QMatrix4x4 &transform);
+    // draws a premultiplied texture owned by the caller as a quad of its size, it has to live until the node is recycled
+    void setTexture(QRhiTexture *texture, const QSize &size, const QMatrix4x4 &transform);
 
     void setBlendMode(rive::BlendMode blendMode);
-
-    void updateGeometry(const QVector<QVector<QVector2D>> &geometry, const QMatrix4x4 &transform);
-    void updateClippingGeometry(const QVector<QVector<QVector2D>> &clippingGeometry);
+    // blend modes other than srcOver are done in the blend shader, which swaps the render surfaces
+    bool isShaderBlending() const { return m_shaderBlending; }
+
+    // retained geometry belongs to a shape nothing animates, the node draws from its buffers instead of uploading the geometry
+    void updateGeometry(const RiveQtPathGeometry &geometry, const QMatrix4x4 &transform, RhiRetainedGeometry *retained = nullptr);
+    void updateClippingGeometry(const RiveQtPathGeometry &clippingGeometry);
+    // turns the node into a stencil then cover draw, the geometry set by updateGeometry is used as cover
+    void updateStencilFillGeometry(const RiveQtPathGeometry &stencilGeometry, bool evenOdd);
+    // turns the node into a stroke that is expanded from its centre line in the vertex shader
+    void updateStrokeCenterline(const RiveQtStrokeCenterline &centerline, const QPen &pen, const QMatrix4x4 &transform);
+    // stencil then cover like updateStencilFillGeometry, but the stencil pass tessellates the curves in the vertex shader
+    void updateCurveWedges(const RiveQtCurveWedges &wedges, bool evenOdd);
+    // analytic antialiasing: after the path a fringe is expanded from its outline, which fades out where the path ends
+    void updateAntialiasingFringe(const RiveQtStrokeCenterline &outline, const QPen &pen);
+    // draws the geometry once per instance, the transform passed to updateGeometry is not used then
+    void updatePathInstances(const QVector<RiveQtPathInstance> &instances);
 
 private:
+    // a centre line as the stroke shader expands it, segments, joins and caps each are one instanced draw
+    struct StrokeInstances
+    {
+        QByteArray data;
+        int segmentCount { 0 };
+        int joinCount { 0 };
+        int capCount { 0 };
+        int joinVertexCount { 0 };
+        int capVertexCount { 0 };
+        // half width, miter limit, join style, cap style as the stroke shader expects them
+        QVector4D params;
+    };
+
     void prepareRender();
+    void releaseTextureBuffers();
+    void setTextureQuad(QRhi *rhi, const QSize &size);
+    void setStrokeInstances(StrokeInstances &instances, QRhiBuffer *&buffer, quint64 &bufferVersion, const RiveQtStrokeCenterline &centerline,
+                            const QPen &pen);
+    void drawStrokeInstances(QRhiCommandBuffer *commandBuffer, QRhiBuffer *buffer, const StrokeInstances &instances);
 
     bool m_recycled { true };
     bool m_clip { false };
+    bool m_stencilFill { false };
+    bool m_writeOnce { false };
+    bool m_stencilFillEvenOdd { false };
+    bool m_gpuStroke { false };
+    bool m_gpuTessellation { false };
+    bool m_antialiasingFringe { false };
+    bool m_scissor { false };
+    bool m_overwrite { false };
+    QRectF m_scissorRect;
 
     bool m_blendVerticesDirty = true;
     bool m_shaderBlending = false;
 
     int m_maximumVerticies { INITIAL_VERTICES };
     int m_maximumClippingVerticies { INITIAL_VERTICES };
-    int m_oldBufferSize = 0;
 
     QSize m_textureSize;
 
@@ -97,13 +167,30 @@ private:
 
     QRhiBuffer *m_clippingUniformBuffer { nullptr };
     QRhiBuffer *m_drawUniformBuffer { nullptr };
+    QRhiBuffer *m_fringeUniformBuffer { nullptr };
 
     QRhiBuffer *m_clippingVertexBuffer { nullptr };
 
+    QRhiBuffer *m_geometryIndexBuffer { nullptr };
+    QRhiBuffer *m_clippingIndexBuffer { nullptr };
+
+    QRhiBuffer *m_stencilFillVertexBuffer { nullptr };
+    QRhiBuffer *m_stencilFillIndexBuffer { nullptr };
+    QRhiBuffer *m_stencilFillUniformBuffer { nullptr };
+
+    QRhiBuffer *m_strokeInstanceBuffer { nullptr };
+    QRhiBuffer *m_wedgeInstanceBuffer { nullptr };
+    QRhiBuffer *m_pathInstanceBuffer { nullptr };
+    QRhiBuffer *m_fringeInstanceBuffer { nullptr };
+
     QRhiShaderResourceBindings *m_blendResourceBindingsA { nullptr };
     QRhiShaderResourceBindings *m_blendResourceBindingsB { nullptr };
     QRhiShaderResourceBindings *m_drawPipelineResourceBindings { nullptr };
     QRhiShaderResourceBindings *m_clippingResourceBindings { nullptr };
+    QRhiShaderResourceBindings *m_stencilFillResourceBindings { nullptr };
+    QRhiShaderResourceBindings *m_fringeResourceBindings { nullptr };
+    // the same uniform buffer without the texture, for the solid and gradient shaders
+    QRhiShaderResourceBindings *m_paintResourceBindings { nullptr };
 
     QRhiTextureRenderTarget *m_blendTextureRenderTargetA { nullptr };
     QRhiTextureRenderTarget *m_blendTextureRenderTargetB { nullptr };
@@ -113,14 +200,16 @@ private:
 
     QRhiRenderBuffer *m_stencilClippingBuffer { nullptr };
 
-    QRhiSampler *m_sampler { nullptr };
-    QRhiSampler *m_blendSampler { nullptr };
-
     QList<QRhiShaderStage> m_pathShader;
     QList<QRhiShaderStage> m_textureShader;
     QList<QRhiShaderStage> m_blendShaders;
 
     QRhiTexture *m_qImageTexture { nullptr };
+    // m_qImageTexture belongs to the caller of setTexture, it is neither uploaded to nor destroyed
+    bool m_externalTexture { false };
+    // the texture the draw and fringe bindings were created with
+    QRhiTexture *m_drawBindingsTexture { nullptr };
+    QRhiTexture *m_fringeBindingsTexture { nullptr };
 
     RiveQSGRHIRenderNode *m_node { nullptr };
 
@@ -154,7 +243,41 @@ private:
     QByteArray m_clippingData;
     QByteArray m_texCoordData;
     QByteArray m_indicesData;
-    QByteArray m_clearData; // this is as large as it must and used in case we reduce the size of a geometry but not reducing the buffer
+
+    // path geometry is drawn indexed, with 16 or 32 bit indices as the tessellation decided
+    QByteArray m_geometryIndexData;
+    QByteArray m_clippingIndexData;
+    bool m_geometryUses32BitIndices { false };
+    bool m_clippingUses32BitIndices { false };
+    int m_geometryIndexCount { 0 };
+    int m_clippingIndexCount { 0 };
+
+    QByteArray m_stencilFillData;
+    QByteArray m_stencilFillIndexData;
+    bool m_stencilFillUses32BitIndices { false };
+    int m_stencilFillIndexCount { 0 };
+
+    StrokeInstances m_strokeInstances;
+    StrokeInstances m_fringeInstances;
+
+    // the geometry version each buffer holds, the buffers are kept over frames and only uploaded to when it changes
+    quint64 m_geometryVersion { 0 };
+    quint64 m_stencilFillVersion { 0 };
+    quint64 m_strokeInstanceVersion { 0 };
+    quint64 m_fringeInstanceVersion { 0 };
+    quint64 m_wedgeVersion { 0 };
+
+    // only set for this frame, the renderer releases the buffers once no draw uses them anymore
+    RhiRetainedGeometry *m_retainedGeometry { nullptr };
+
+    // lines need a single triangle, cubics as many as the shader decides to use
+    QByteArray m_wedgeInstanceData;
+    int m_wedgeLineCount { 0 };
+    int m_wedgeCubicCount { 0 };
+
+    // 0 for regular draws
+    QByteArray m_pathInstanceData;
+    int m_pathInstanceCount { 0 };
 
     struct GradientData
     {
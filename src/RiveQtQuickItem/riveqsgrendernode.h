@@ -13,6 +13,7 @@
 #include "datatypes.h"
 
 class QQuickWindow;
+class RiveQSGTextureProvider;
 
 class RiveQSGBaseNode
 {
@@ -29,6 +30,9 @@ public:
 
     virtual void setArtboardRect(const QRectF &bounds);
 
+    // receives the final texture, in case the render node has one
+    virtual void setTextureProvider(RiveQSGTextureProvider *) { }
+
 protected:
     std::weak_ptr<rive::ArtboardInstance> m_artboardInstance;
     QRectF m_rect;
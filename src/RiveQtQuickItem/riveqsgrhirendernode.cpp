@@ -7,10 +7,10 @@
 #include "riveqtquickitem.h"
 #include "renderer/riveqtrhirenderer.h"
 #include "rhi/postprocessingsmaa.h"
+#include "rhi/rhirenderatlas.h"
 #include "rqqplogging.h"
 
 #include <QQuickWindow>
-#include <QFile>
 #include <QOpenGLContext>
 #include <QOpenGLFunctions>
 #include <QOpenGLExtraFunctions>
@@ -20,49 +20,6 @@ RiveQSGRHIRenderNode::RiveQSGRHIRenderNode(QQuickWindow *window, std::weak_ptr<r
                                            const QRectF &geometry)
     : RiveQSGRenderNode(window, artboardInstance, geometry)
 {
-    QFile file;
-    file.setFileName(":/shaders/qt6/finalDraw.vert.qsb");
-    file.open(QFile::ReadOnly);
-    m_finalDrawShader.append(QRhiShaderStage(QRhiShaderStage::Vertex, QShader::fromSerialized(file.readAll())));
-
-    file.close();
-    file.setFileName(":/shaders/qt6/finalDraw.frag.qsb");
-    file.open(QFile::ReadOnly);
-
-    m_finalDrawShader.append(QRhiShaderStage(QRhiShaderStage::Fragment, QShader::fromSerialized(file.readAll())));
-
-    file.close();
-    file.setFileName(":/shaders/qt6/drawRiveTextureNode.vert.qsb");
-    file.open(QFile::ReadOnly);
-    m_pathShader.append(QRhiShaderStage(QRhiShaderStage::Vertex, QShader::fromSerialized(file.readAll())));
-
-    file.close();
-    file.setFileName(":/shaders/qt6/drawRiveTextureNode.frag.qsb");
-    file.open(QFile::ReadOnly);
-    m_pathShader.append(QRhiShaderStage(QRhiShaderStage::Fragment, QShader::fromSerialized(file.readAll())));
-    file.close();
-
-    file.setFileName(":/shaders/qt6/clipRiveTextureNode.vert.qsb");
-    file.open(QFile::ReadOnly);
-    m_clipShader.append(QRhiShaderStage(QRhiShaderStage::Vertex, QShader::fromSerialized(file.readAll())));
-
-    file.close();
-    file.setFileName(":/shaders/qt6/clipRiveTextureNode.frag.qsb");
-    file.open(QFile::ReadOnly);
-    m_clipShader.append(QRhiShaderStage(QRhiShaderStage::Fragment, QShader::fromSerialized(file.readAll())));
-    file.close();
-
-    file.setFileName(":/shaders/qt6/blendRiveTextureNode.vert.qsb");
-    file.open(QFile::ReadOnly);
-    m_blendShaders.append(QRhiShaderStage(QRhiShaderStage::Vertex, QShader::fromSerialized(file.readAll())));
-
-    file.close();
-    file.setFileName(":/shaders/qt6/blendRiveTextureNode.frag.qsb");
-    file.open(QFile::ReadOnly);
-
-    m_blendShaders.append(QRhiShaderStage(QRhiShaderStage::Fragment, QShader::fromSerialized(file.readAll())));
-    file.close();
-
     setRect(geometry);
 
     m_texCoords.append(QVector2D(0.0f, 0.0f));
@@ -88,6 +45,12 @@ RiveQSGRHIRenderNode::~RiveQSGRHIRenderNode()
         m_postprocessing = nullptr;
     }
 
+    // the surfaces go away with us
+    if (m_textureProvider) {
+        m_textureProvider->setTexture(nullptr, {}, false);
+    }
+
+    releaseAtlasRegion();
     releaseResources();
 }
 
@@ -106,6 +69,7 @@ void RiveQSGRHIRenderNode::setRect(const QRectF &bounds)
     m_renderSurfaceA.cleanUp();
     m_renderSurfaceB.cleanUp();
     m_renderSurfaceIntern.cleanUp();
+    releaseAtlasRegion();
 
     m_currentRenderSurface = nullptr;
 
@@ -145,6 +109,45 @@ void RiveQSGRHIRenderNode::setFillMode(const RiveRenderSettings::FillMode mode)
     m_fillMode = mode;
 }
 
+void RiveQSGRHIRenderNode::setFillRenderMode(const RiveRenderSettings::FillRenderMode fillRenderMode)
+{
+    m_renderer->setFillRenderMode(fillRenderMode);
+}
+
+void RiveQSGRHIRenderNode::setStrokeMode(const RiveRenderSettings::StrokeMode strokeMode)
+{
+    m_renderer->setStrokeMode(strokeMode);
+}
+
+void RiveQSGRHIRenderNode::setAntialiasingMode(const RiveRenderSettings::AntialiasingMode antialiasingMode)
+{
+    m_renderer->setAntialiasingMode(antialiasingMode);
+}
+
+void RiveQSGRHIRenderNode::updateArtboardInstance(std::weak_ptr<rive::ArtboardInstance> artboardInstance)
+{
+    RiveQSGRenderNode::updateArtboardInstance(artboardInstance);
+    // caches and retained geometry of instances that are gone are dropped, the others stay for switching back
+    for (auto it = m_nestedArtboardCaches.begin(); it != m_nestedArtboardCaches.end();) {
+        if (it->artboardInstance.expired()) {
+            it = m_nestedArtboardCaches.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_renderer->releaseExpiredRetainedGeometry();
+}
+
+void RiveQSGRHIRenderNode::setTextureProvider(RiveQSGTextureProvider *textureProvider)
+{
+    if (m_textureProvider == textureProvider) {
+        return;
+    }
+
+    m_textureProvider = textureProvider;
+    m_textureProviderDirty = true;
+}
+
 void RiveQSGRHIRenderNode::setPostprocessingMode(const RiveRenderSettings::PostprocessingMode postprocessingMode)
 {
 
@@ -157,12 +160,18 @@ void RiveQSGRHIRenderNode::setPostprocessingMode(const RiveRenderSettings::Postp
     } else { // if (postprocessingMode == RiveRenderSettings::SMAA) {
         if (!m_postprocessing) {
             m_postprocessing = new PostprocessingSMAA(m_window->rendererInterface()->graphicsApi());
+            m_surfaceChanged = true;
         }
     }
 }
 
 void RiveQSGRHIRenderNode::renderOffscreen()
 {
+    // atlas regions are drawn in prepare(), together with the frame
+    if (m_renderAtlas) {
+        return;
+    }
+
     if (!m_renderSurfaceA.valid() || !m_renderSurfaceB.valid() || !m_renderSurfaceIntern.valid() || m_rect.width() == 0
         || m_rect.height() == 0)
         return;
@@ -171,6 +180,13 @@ void RiveQSGRHIRenderNode::renderOffscreen()
         return;
     }
 
+    // the surface still shows the same frame, also on whichever surface it ended, only the composition in render() is needed
+    if (m_renderer->isFrameUnchanged()) {
+        return;
+    }
+    m_surfaceChanged = true;
+    m_textureProviderDirty = true;
+
     QSGRendererInterface *renderInterface = m_window->rendererInterface();
     QRhi *rhi = static_cast<QRhi *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiResource));
 
@@ -179,33 +195,32 @@ void RiveQSGRHIRenderNode::renderOffscreen()
     QRhiCommandBuffer *cb;
     rhi->beginOffscreenFrame(&cb);
     {
-        // clean our main texture
-        cb->beginPass(m_cleanUpTextureTarget, QColor(0, 0, 0, 0), { 1.0f, 0 });
-        cb->endPass();
-        // draw elements to our shared texture
+        // clean our main texture, unless only the damaged area is redrawn, which the renderer clears itself
+        if (!m_renderer->hasPartialDamage()) {
+            cb->beginPass(m_cleanUpTextureTarget, QColor(0, 0, 0, 0), { 1.0f, 0 });
+            cb->endPass();
+        }
+        // draw elements to our shared texture, after the textures of the nested artboards it draws from
+        renderNestedArtboards(cb);
         m_renderer->render(cb);
     }
     rhi->endOffscreenFrame();
 }
 
+void RiveQSGRHIRenderNode::renderNestedArtboards(QRhiCommandBuffer *commandBuffer)
+{
+    for (NestedArtboardCacheEntry &entry : m_nestedArtboardCaches) {
+        entry.cache.render(this, commandBuffer);
+    }
+}
+
 void RiveQSGRHIRenderNode::render(const RenderState *state)
 {
     if (m_artboardInstance.expired()) {
         return;
     }
 
-    QRhiCommandBuffer *commandBuffer = nullptr;
-    QSGRendererInterface *renderInterface = m_window->rendererInterface();
-    QRhiSwapChain *swapChain =
-        static_cast<QRhiSwapChain *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiSwapchainResource));
-
-    if (swapChain) {
-        commandBuffer = swapChain->currentFrameCommandBuffer();
-    } else {
-        commandBuffer =
-            static_cast<QRhiCommandBuffer *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiRedirectCommandBuffer));
-    }
-
+    QRhiCommandBuffer *commandBuffer = frameCommandBuffer();
     if (!commandBuffer) {
         qCCritical(rqqpFactory) << "Render: No command buffer available";
         return;
@@ -250,10 +265,10 @@ QSGRenderNode::StateFlags RiveQSGRHIRenderNode::changedStates() const
 
 void RiveQSGRHIRenderNode::switchCurrentRenderBuffer()
 {
-    if (m_currentRenderSurface == &m_renderSurfaceA) {
-        m_currentRenderSurface = &m_renderSurfaceB;
+    if (m_currentRenderSurface == m_surfaceA) {
+        m_currentRenderSurface = m_surfaceB;
     } else {
-        m_currentRenderSurface = &m_renderSurfaceA;
+        m_currentRenderSurface = m_surfaceA;
     }
 }
 
@@ -268,71 +283,223 @@ QRhiTexture *RiveQSGRHIRenderNode::getCurrentRenderBuffer()
 QRhiTextureRenderTarget *RiveQSGRHIRenderNode::currentRenderTarget(bool shaderBlending)
 {
     if (shaderBlending) {
-        return m_renderSurfaceIntern.target;
+        return m_surfaceIntern->target;
     }
-    return isCurrentRenderBufferA() ? m_renderSurfaceA.target : m_renderSurfaceB.target;
+    return isCurrentRenderBufferA() ? m_surfaceA->target : m_surfaceB->target;
 }
 
 QRhiTextureRenderTarget *RiveQSGRHIRenderNode::currentBlendTarget()
 {
-    return isCurrentRenderBufferA() ? m_renderSurfaceA.blendTarget : m_renderSurfaceB.blendTarget;
+    return isCurrentRenderBufferA() ? m_surfaceA->blendTarget : m_surfaceB->blendTarget;
 }
 
 QRhiGraphicsPipeline *RiveQSGRHIRenderNode::renderPipeline(bool shaderBlending)
 {
     if (shaderBlending) {
-        return m_drawPipelineIntern;
+        return m_pipelines->drawIntern;
     }
-    return m_drawPipeline;
+    return m_pipelines->draw;
 }
 
 QRhiGraphicsPipeline *RiveQSGRHIRenderNode::clippingPipeline()
 {
-    return m_clipPipeline;
+    return m_pipelines->clip;
+}
+
+QRhiGraphicsPipeline *RiveQSGRHIRenderNode::stencilFillPipeline(bool evenOdd)
+{
+    return evenOdd ? m_pipelines->stencilFillEvenOdd : m_pipelines->stencilFill;
+}
+
+QRhiGraphicsPipeline *RiveQSGRHIRenderNode::wedgeFillPipeline(bool evenOdd)
+{
+    return evenOdd ? m_pipelines->wedgeFillEvenOdd : m_pipelines->wedgeFill;
+}
+
+QRhiGraphicsPipeline *RiveQSGRHIRenderNode::coverPipeline(bool shaderBlending)
+{
+    if (shaderBlending) {
+        return m_pipelines->coverIntern;
+    }
+    return m_pipelines->cover;
+}
+
+QRhiGraphicsPipeline *RiveQSGRHIRenderNode::writeOncePipeline(bool shaderBlending)
+{
+    if (shaderBlending) {
+        return m_pipelines->writeOnceIntern;
+    }
+    return m_pipelines->writeOnce;
+}
+
+QRhiGraphicsPipeline *RiveQSGRHIRenderNode::strokePipeline(bool shaderBlending)
+{
+    if (shaderBlending) {
+        return m_pipelines->strokeIntern;
+    }
+    return m_pipelines->stroke;
+}
+
+QRhiGraphicsPipeline *RiveQSGRHIRenderNode::overwritePipeline()
+{
+    return m_pipelines->overwrite;
+}
+
+QRhiGraphicsPipeline *RiveQSGRHIRenderNode::pathInstancePipeline()
+{
+    // the renderer asks while merging draws, that can happen before the first prepare
+    return m_pipelines ? m_pipelines->pathInstance : nullptr;
+}
+
+QRhiGraphicsPipeline *RiveQSGRHIRenderNode::paintPipeline(QRhiGraphicsPipeline *pipeline, RhiResourceRegistry::PaintType paintType)
+{
+    return m_registry->paintPipeline(m_pipelines, pipeline, paintType);
 }
 
 QRhiGraphicsPipeline *RiveQSGRHIRenderNode::currentBlendPipeline()
 {
-    return m_blendPipeline;
+    return m_pipelines->blend;
 }
 
 QRhiRenderPassDescriptor *RiveQSGRHIRenderNode::currentRenderPassDescriptor(bool shaderBlending)
 {
     if (shaderBlending) {
-        return m_renderSurfaceIntern.desc;
+        return m_surfaceIntern->desc;
     }
 
-    return isCurrentRenderBufferA() ? m_renderSurfaceA.desc : m_renderSurfaceB.desc;
+    return isCurrentRenderBufferA() ? m_surfaceA->desc : m_surfaceB->desc;
 }
 
 QRhiRenderPassDescriptor *RiveQSGRHIRenderNode::currentBlendPassDescriptor()
 {
-    return isCurrentRenderBufferA() ? m_renderSurfaceA.blendDesc : m_renderSurfaceB.blendDesc;
+    return isCurrentRenderBufferA() ? m_surfaceA->blendDesc : m_surfaceB->blendDesc;
 }
 
 QRhiTexture *RiveQSGRHIRenderNode::getRenderBufferA()
 {
-    return m_renderSurfaceA.texture;
+    return m_surfaceA->texture;
 }
 
 QRhiTexture *RiveQSGRHIRenderNode::getRenderBufferB()
 {
-    return m_renderSurfaceB.texture;
+    return m_surfaceB->texture;
 }
 
 QRhiTexture *RiveQSGRHIRenderNode::getRenderBufferIntern()
 {
-    return m_renderSurfaceIntern.texture;
+    return m_surfaceIntern->texture;
 }
 
 QRhiTexture *RiveQSGRHIRenderNode::getDummyTexture()
 {
-    return m_dummyTexture;
+    return m_registry ? m_registry->dummyTexture() : nullptr;
+}
+
+QRhiSampler *RiveQSGRHIRenderNode::linearSampler()
+{
+    return m_registry ? m_registry->linearSampler() : nullptr;
 }
 
 bool RiveQSGRHIRenderNode::isCurrentRenderBufferA()
 {
-    return m_currentRenderSurface == &m_renderSurfaceA;
+    return m_currentRenderSurface == m_surfaceA;
+}
+
+QRect RiveQSGRHIRenderNode::surfaceRect() const
+{
+    if (m_redirectSurface) {
+        return QRect(QPoint(0, 0), m_redirectSurface->texture->pixelSize());
+    }
+    if (m_renderAtlas) {
+        return m_atlasRegion;
+    }
+    return QRect(0, 0, m_rect.width(), m_rect.height());
+}
+
+QRhiViewport RiveQSGRHIRenderNode::surfaceViewport() const
+{
+    const QRect rect = surfaceRect();
+    const int surfaceHeight = m_renderAtlas && !m_redirectSurface ? m_renderAtlas->size().height() : rect.height();
+    return QRhiViewport(rect.x(), surfaceHeight - rect.y() - rect.height(), rect.width(), rect.height());
+}
+
+QRectF RiveQSGRHIRenderNode::surfaceTexCoordRect() const
+{
+    if (!m_renderAtlas || m_redirectSurface) {
+        return QRectF(0, 0, 1, 1);
+    }
+
+    const QSizeF atlasSize = m_renderAtlas->size();
+    return QRectF(m_atlasRegion.x() / atlasSize.width(), m_atlasRegion.y() / atlasSize.height(),
+                  m_atlasRegion.width() / atlasSize.width(), m_atlasRegion.height() / atlasSize.height());
+}
+
+bool RiveQSGRHIRenderNode::allocateAtlasRegion()
+{
+    // multisampled surfaces are resolved as a whole, they would overwrite the regions of the other items
+    if (!m_registry || m_sampleCount != 1) {
+        return false;
+    }
+
+    // the postprocessing works on whole surfaces, in the atlas the item would silently lose it
+    if (m_postprocessing) {
+        qCDebug(rqqpRendering) << "Item uses SMAA postprocessing, using own render surfaces instead of the render atlas";
+        return false;
+    }
+
+    RhiRenderAtlas *renderAtlas = m_registry->renderAtlas();
+    const QRect region = renderAtlas->allocate(QSize(m_rect.width(), m_rect.height()));
+    if (region.isEmpty()) {
+        qCDebug(rqqpRendering) << "Item does not fit into the render atlas, using own render surfaces";
+        return false;
+    }
+
+    m_renderAtlas = renderAtlas;
+    m_atlasRegion = region;
+    m_renderAtlas->addItem(this);
+    m_surfaceA = renderAtlas->surfaceA();
+    m_surfaceB = renderAtlas->surfaceB();
+    m_surfaceIntern = renderAtlas->surfaceIntern();
+    return true;
+}
+
+void RiveQSGRHIRenderNode::redirectRenderSurfaces(RenderSurface *surface)
+{
+    Q_ASSERT(!m_redirectSurface);
+    m_redirectSurface = surface;
+    m_redirectedSurfaces[0] = m_surfaceA;
+    m_redirectedSurfaces[1] = m_surfaceB;
+    m_redirectedSurfaces[2] = m_surfaceIntern;
+    m_redirectedSurfaces[3] = m_currentRenderSurface;
+    m_surfaceA = surface;
+    m_surfaceB = surface;
+    m_surfaceIntern = surface;
+    m_currentRenderSurface = surface;
+}
+
+void RiveQSGRHIRenderNode::restoreRenderSurfaces()
+{
+    m_surfaceA = m_redirectedSurfaces[0];
+    m_surfaceB = m_redirectedSurfaces[1];
+    m_surfaceIntern = m_redirectedSurfaces[2];
+    m_currentRenderSurface = m_redirectedSurfaces[3];
+    m_redirectSurface = nullptr;
+}
+
+void RiveQSGRHIRenderNode::releaseAtlasRegion()
+{
+    if (m_renderAtlas) {
+        m_renderAtlas->removeItem(this);
+        m_renderAtlas->release(m_atlasRegion);
+    }
+
+    m_renderAtlas = nullptr;
+    m_atlasRegion = QRect();
+    m_atlasFrameRecorded = false;
+    m_atlasPrepared = false;
+    m_surfaceA = &m_renderSurfaceA;
+    m_surfaceB = &m_renderSurfaceB;
+    m_surfaceIntern = &m_renderSurfaceIntern;
 }
 
 RiveQSGRHIRenderNode *RiveQSGRHIRenderNode::create(const RiveRenderSettings &renderSettings,
@@ -371,6 +538,33 @@ RiveQSGRHIRenderNode *RiveQSGRHIRenderNode::create(const RiveRenderSettings &ren
         auto node = new RiveQSGRHIRenderNode(window, artboardInstance, geometry);
         node->setFillMode(renderSettings.fillMode);
         node->setPostprocessingMode(renderSettings.postprocessingMode);
+
+        RiveRenderSettings::FillRenderMode fillRenderMode = renderSettings.fillRenderMode;
+        if (fillRenderMode == RiveRenderSettings::GpuTessellatedFill && !rhi->isFeatureSupported(QRhi::Instancing)) {
+            qCWarning(rqqpFactory) << "GpuTessellatedFill requested, but instancing is not supported - falling back to StencilCoverFill";
+            fillRenderMode = RiveRenderSettings::StencilCoverFill;
+        }
+        node->setFillRenderMode(fillRenderMode);
+
+        RiveRenderSettings::StrokeMode strokeMode = renderSettings.strokeMode;
+        if (strokeMode == RiveRenderSettings::GpuStroking && !rhi->isFeatureSupported(QRhi::Instancing)) {
+            qCWarning(rqqpFactory) << "GpuStroking requested, but instancing is not supported - falling back to NativeStroking";
+            strokeMode = RiveRenderSettings::NativeStroking;
+        }
+        node->setStrokeMode(strokeMode);
+
+        // the fringe is expanded by the stroke shader, which needs instancing as well
+        RiveRenderSettings::AntialiasingMode antialiasingMode = renderSettings.antialiasingMode;
+        if (antialiasingMode == RiveRenderSettings::AnalyticAntialiasing && !rhi->isFeatureSupported(QRhi::Instancing)) {
+            qCWarning(rqqpFactory) << "AnalyticAntialiasing requested, but instancing is not supported - falling back to NoAntialiasing";
+            antialiasingMode = RiveRenderSettings::NoAntialiasing;
+        }
+        node->setAntialiasingMode(antialiasingMode);
+        node->setNestedArtboardCaching(renderSettings.nestedArtboardCaching);
+        if (renderSettings.renderAtlas && renderSettings.postprocessingMode == RiveRenderSettings::SMAA) {
+            qCInfo(rqqpFactory) << "renderAtlas requested together with SMAA postprocessing - the item keeps its own render surfaces";
+        }
+        node->setRenderAtlas(renderSettings.renderAtlas);
         return node;
     } else {
         qCCritical(rqqpFactory)
@@ -396,6 +590,147 @@ void GLAPIENTRY
 #endif
 
 
+void RiveQSGRHIRenderNode::updateFrame()
+{
+    auto artboardInstance = m_artboardInstance.lock();
+    if (!artboardInstance) {
+        return;
+    }
+
+    m_renderer->recycleRiveNodes();
+    m_renderer->setArtboardInstance(artboardInstance);
+
+    m_renderer->updateArtboardSize(QSize(artboardInstance->width(), artboardInstance->height()));
+
+    // value range of 0 to 1 to describe the edges of the artboard on the final render ("clip the final texture")
+    float left = 0; // 0-1
+    float right = 1; // 0-1
+    float top = 0; // 0-1
+    float bottom = 1; // 0-1
+
+    // artboard units to item pixels, the nested artboard cache picks the resolution of its images by it
+    float artboardScale = 1.0f;
+
+    { // update projection matrix
+        m_frameProjection = *projectionMatrix();
+        QMatrix4x4 projMatrix = m_frameProjection;
+
+        const auto window2itemScaleX = m_window->width() / m_rect.width();
+        const auto window2itemScaleY = m_window->height() / m_rect.height();
+
+        projMatrix.scale(window2itemScaleX, window2itemScaleY);
+
+        QMatrix4x4 combinedMatrix = projMatrix;
+
+        combinedMatrix.translate(m_topLeftRivePosition.x(), m_topLeftRivePosition.y());
+
+        const auto item2artboardScaleX = m_rect.width() / artboardInstance->width();
+        const auto item2artboardScaleY = m_rect.height() / artboardInstance->height();
+
+        switch (m_fillMode) {
+        case RiveRenderSettings::Stretch: {
+            combinedMatrix.scale(item2artboardScaleX, item2artboardScaleY);
+            artboardScale = qMax(item2artboardScaleX, item2artboardScaleY);
+            break;
+        }
+        case RiveRenderSettings::PreserveAspectCrop: {
+            const auto scaleFactor = qMax(item2artboardScaleX, item2artboardScaleY);
+            combinedMatrix.scale(scaleFactor, scaleFactor);
+            artboardScale = scaleFactor;
+            break;
+        }
+        default:
+        case RiveRenderSettings::PreserveAspectFit: {
+            const auto scaleFactor = qMin(item2artboardScaleX, item2artboardScaleY);
+
+            float widthFactor = m_rect.width() - artboardInstance->width() * scaleFactor;
+            float heightFactor = m_rect.height() - artboardInstance->height() * scaleFactor;
+
+            if (widthFactor > 0) {
+                // diff through 2 since its centered horizontal
+                widthFactor = (widthFactor / 2.0f) * 1.0f / m_rect.width();
+                left = widthFactor;
+                right = 1.0 - widthFactor;
+            }
+
+            if (heightFactor > 0) {
+                // diff through 2 since its centered vertical
+                heightFactor = (heightFactor / 2.0f) * 1.0f / m_rect.height();
+                top = heightFactor;
+                bottom = 1.0 - heightFactor;
+            }
+
+            combinedMatrix.scale(scaleFactor, scaleFactor);
+            artboardScale = scaleFactor;
+            break;
+        }
+        }
+
+        m_renderer->setProjectionMatrix(&projMatrix, &combinedMatrix);
+    }
+
+    m_displayList.clear();
+    artboardInstance->draw(&m_displayList);
+
+    // an artboard that draws the same as in the last frame is neither replayed nor tessellated
+    const float pixelScale = artboardScale * m_window->effectiveDevicePixelRatio();
+    size_t displayListFingerprint = m_displayList.fingerprint();
+    if (displayListFingerprint != 0) {
+        displayListFingerprint = qHashMulti(displayListFingerprint, int(m_nestedArtboardCaching), pixelScale);
+    }
+    if (!m_renderer->keepFrame(displayListFingerprint)) {
+        if (m_nestedArtboardCaching) {
+            NestedArtboardCacheEntry &entry = m_nestedArtboardCaches[artboardInstance.get()];
+            entry.artboardInstance = artboardInstance;
+            entry.cache.setArtboard(artboardInstance.get());
+            entry.cache.replay(m_displayList, this, m_renderer, pixelScale);
+        } else {
+            m_displayList.replay(m_renderer);
+        }
+        m_renderer->flush();
+    }
+
+    m_artboardEdges = QRectF(QPointF(left, top), QPointF(right, bottom));
+}
+
+bool RiveQSGRHIRenderNode::prepareAtlasFrame(QRhiCommandBuffer *commandBuffer)
+{
+    // items that were not prepared since the last atlas frame may be hidden, they draw themselves once they are prepared again
+    m_atlasFrameRecorded = commandBuffer && m_atlasPrepared && m_pipelines && m_renderer && !m_artboardInstance.expired();
+    m_atlasPrepared = false;
+    if (!m_atlasFrameRecorded) {
+        return false;
+    }
+
+    updateFrame();
+    if (m_renderer->isFrameUnchanged()) {
+        return false;
+    }
+
+    m_currentRenderSurface = m_surfaceA;
+    renderNestedArtboards(commandBuffer);
+    m_renderer->uploadResources(commandBuffer);
+    m_textureProviderDirty = true;
+    return true;
+}
+
+void RiveQSGRHIRenderNode::recordAtlasFrame(QRhiCommandBuffer *commandBuffer, RhiPassState &passState)
+{
+    m_renderer->recordDraws(commandBuffer, passState);
+}
+
+QRhiCommandBuffer *RiveQSGRHIRenderNode::frameCommandBuffer() const
+{
+    QSGRendererInterface *renderInterface = m_window->rendererInterface();
+    QRhiSwapChain *swapChain =
+        static_cast<QRhiSwapChain *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiSwapchainResource));
+
+    if (swapChain) {
+        return swapChain->currentFrameCommandBuffer();
+    }
+    return static_cast<QRhiCommandBuffer *>(renderInterface->getResource(m_window, QSGRendererInterface::RhiRedirectCommandBuffer));
+}
+
 void RiveQSGRHIRenderNode::prepare()
 {
     if (!m_window) {
@@ -443,206 +778,83 @@ void RiveQSGRHIRenderNode::prepare()
     }
 #endif
 
-    if (!m_stencilClippingBuffer) {
-        m_stencilClippingBuffer = rhi->newRenderBuffer(QRhiRenderBuffer::DepthStencil, QSize(m_rect.width(), m_rect.height()), m_sampleCount);
-        m_stencilClippingBuffer->create();
-        m_cleanupList.append(m_stencilClippingBuffer);
-    }
-
     m_sampleCount = sampleCount;
-    bool textureCreated = m_renderSurfaceA.create(rhi, m_sampleCount, QSize(m_rect.width(), m_rect.height()), m_stencilClippingBuffer);
-    m_renderSurfaceB.create(rhi, m_sampleCount, QSize(m_rect.width(), m_rect.height()), m_stencilClippingBuffer);
-    m_renderSurfaceIntern.create(rhi, m_sampleCount, QSize(m_rect.width(), m_rect.height()), m_stencilClippingBuffer, {});
-
-    // only set the renderSurface to A in case we created a new texture
-    if (textureCreated) {
-        m_currentRenderSurface = &m_renderSurfaceA;
-    }
-
-    if (!m_drawUniformBuffer) {
-        m_drawUniformBuffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 848);
-        m_drawUniformBuffer->create();
-        m_cleanupList.append(m_drawUniformBuffer);
-    }
-
-    if (!m_clippingUniformBuffer) {
-        m_clippingUniformBuffer = rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 128);
-        m_clippingUniformBuffer->create();
-        m_cleanupList.append(m_clippingUniformBuffer);
-    }
-
-    if (!m_clippingResourceBindings) {
-        m_clippingResourceBindings = rhi->newShaderResourceBindings();
-        m_clippingResourceBindings->setBindings({ QRhiShaderResourceBinding::uniformBuffer(
-            0, QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage, m_clippingUniformBuffer) });
-        m_clippingResourceBindings->create();
-        m_cleanupList.append(m_clippingResourceBindings);
-    }
+    m_registry = RhiResourceRegistry::instance(rhi);
 
-    if (!m_sampler) {
-        m_sampler = rhi->newSampler(QRhiSampler::Nearest, QRhiSampler::Nearest, QRhiSampler::None, QRhiSampler::ClampToEdge,
-                                    QRhiSampler::ClampToEdge);
-        m_sampler->create();
-        m_cleanupList.append(m_sampler);
-    }
-
-    if (!m_blendSampler) {
-        m_blendSampler = rhi->newSampler(QRhiSampler::Linear, QRhiSampler::Linear, QRhiSampler::None, QRhiSampler::ClampToEdge,
-                                         QRhiSampler::ClampToEdge);
-        m_cleanupList.append(m_blendSampler);
-        m_blendSampler->create();
-    }
-
-    // only for bindings
-    if (!m_dummyTexture) {
-        m_dummyTexture = rhi->newTexture(QRhiTexture::BGRA8, QSize(1, 1), 1);
-        m_cleanupList.append(m_dummyTexture);
-        m_dummyTexture->create();
-    }
-
-    if (!m_drawPipelineResourceBindings) {
-        m_drawPipelineResourceBindings = rhi->newShaderResourceBindings();
-
-        m_drawPipelineResourceBindings->setBindings({
-            QRhiShaderResourceBinding::uniformBuffer(0, QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage,
-                                                     m_drawUniformBuffer),
-            QRhiShaderResourceBinding::sampledTexture(1, QRhiShaderResourceBinding::FragmentStage, m_dummyTexture, m_sampler) //
-        });
-        m_drawPipelineResourceBindings->create();
-        m_cleanupList.append(m_drawPipelineResourceBindings);
-    }
-
-    if (!m_blendResourceBindingsA) {
-        m_blendResourceBindingsA = rhi->newShaderResourceBindings();
-        m_blendResourceBindingsA->setBindings({
-            QRhiShaderResourceBinding::uniformBuffer(0, QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage,
-                                                     m_blendUniformBuffer),
-            QRhiShaderResourceBinding::sampledTexture(1, QRhiShaderResourceBinding::FragmentStage, m_renderSurfaceB.texture,
-                                                      m_blendSampler),
-            QRhiShaderResourceBinding::sampledTexture(2, QRhiShaderResourceBinding::FragmentStage, m_renderSurfaceIntern.texture,
-                                                      m_blendSampler),
-        });
-
-        m_blendResourceBindingsA->create();
-        m_cleanupList.append(m_blendResourceBindingsA);
-    }
-
-    if (!m_blendResourceBindingsB) {
-        m_blendResourceBindingsB = rhi->newShaderResourceBindings();
-        m_blendResourceBindingsB->setBindings({
-            QRhiShaderResourceBinding::uniformBuffer(0, QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage,
-                                                     m_blendUniformBuffer),
-            QRhiShaderResourceBinding::sampledTexture(1, QRhiShaderResourceBinding::FragmentStage, m_renderSurfaceA.texture,
-                                                      m_blendSampler),
-            QRhiShaderResourceBinding::sampledTexture(2, QRhiShaderResourceBinding::FragmentStage, m_renderSurfaceIntern.texture,
-                                                      m_blendSampler),
-        });
-
-        m_blendResourceBindingsB->create();
-        m_cleanupList.append(m_blendResourceBindingsB);
+    bool textureCreated = false;
+    // small items take a region of the shared surfaces, until they are resized
+    if (m_renderAtlasEnabled && !m_renderAtlas && !m_renderSurfaceA.valid()) {
+        textureCreated = allocateAtlasRegion();
     }
 
-    if (!m_clipPipeline) {
-        m_clipPipeline = createClipPipeline(rhi, m_renderSurfaceA.desc, m_clippingResourceBindings);
-    }
+    if (!m_renderAtlas) {
+        if (!m_stencilClippingBuffer) {
+            m_stencilClippingBuffer =
+                rhi->newRenderBuffer(QRhiRenderBuffer::DepthStencil, QSize(m_rect.width(), m_rect.height()), m_sampleCount);
+            m_stencilClippingBuffer->create();
+            m_cleanupList.append(m_stencilClippingBuffer);
+        }
 
-    if (!m_drawPipeline) {
-        m_drawPipeline = createDrawPipeline(rhi, true, true, m_renderSurfaceA.desc, QRhiGraphicsPipeline::Triangles, m_pathShader,
-                                            m_drawPipelineResourceBindings);
+        textureCreated = m_renderSurfaceA.create(rhi, m_sampleCount, QSize(m_rect.width(), m_rect.height()), m_stencilClippingBuffer);
+        m_renderSurfaceB.create(rhi, m_sampleCount, QSize(m_rect.width(), m_rect.height()), m_stencilClippingBuffer);
+        m_renderSurfaceIntern.create(rhi, m_sampleCount, QSize(m_rect.width(), m_rect.height()), m_stencilClippingBuffer, {});
     }
 
-    if (!m_drawPipelineIntern) {
-        m_drawPipelineIntern = createDrawPipeline(rhi, false, true, m_renderSurfaceIntern.desc, QRhiGraphicsPipeline::Triangles,
-                                                  m_pathShader, m_drawPipelineResourceBindings);
+    // only set the renderSurface to A in case we created a new texture
+    if (textureCreated) {
+        m_currentRenderSurface = m_surfaceA;
     }
 
-    if (!m_blendPipeline) {
-        m_blendPipeline = createBlendPipeline(rhi, m_renderSurfaceA.blendDesc, m_blendResourceBindingsA);
+    // the surfaces are recreated on resize, their format stays the same
+    m_pipelines = m_registry->pipelines(QRhiTexture::RGBA8, m_sampleCount, m_surfaceA->target, m_surfaceA->blendTarget);
+    if (!m_pipelines) {
+        qCWarning(rqqpRendering) << "No pipelines for the render surfaces";
+        return;
     }
 
     if (m_renderer) {
-        m_renderer->updateViewPort(m_rect);
+        // the nodes bind the surface textures, as long as those stay they are kept with their buffers
+        if (textureCreated) {
+            m_renderer->updateViewPort(m_rect);
+        }
         m_renderer->setRiveRect({ m_topLeftRivePosition, m_riveSize });
+        // multisampled surfaces are resolved on every pass, only single sampled ones keep their content reliably
+        m_renderer->setDamageTrackingEnabled(m_sampleCount == 1);
+        // a clear pass would clear the regions of the other items as well
+        m_renderer->setClearByDraw(m_renderAtlas != nullptr);
     }
 
     if (m_artboardInstance.expired()) {
         return;
     }
 
-    auto artboardInstance = m_artboardInstance.lock();
-
     if (!m_renderer) {
         qCWarning(rqqpRendering) << "Renderer is null";
         return;
     }
 
-    m_renderer->recycleRiveNodes();
-
-    m_renderer->updateArtboardSize(QSize(artboardInstance->width(), artboardInstance->height()));
-
-    // value range of 0 to 1 to describe the edges of the artboard on the final render ("clip the final texture")
-    float left = 0; // 0-1
-    float right = 1; // 0-1
-    float top = 0; // 0-1
-    float bottom = 1; // 0-1
-
-    { // update projection matrix
-        QMatrix4x4 projMatrix = *projectionMatrix();
-
-        const auto window2itemScaleX = m_window->width() / m_rect.width();
-        const auto window2itemScaleY = m_window->height() / m_rect.height();
-
-        projMatrix.scale(window2itemScaleX, window2itemScaleY);
-
-        QMatrix4x4 combinedMatrix = projMatrix;
-
-        combinedMatrix.translate(m_topLeftRivePosition.x(), m_topLeftRivePosition.y());
-
-        const auto item2artboardScaleX = m_rect.width() / artboardInstance->width();
-        const auto item2artboardScaleY = m_rect.height() / artboardInstance->height();
-
-        switch (m_fillMode) {
-        case RiveRenderSettings::Stretch: {
-            combinedMatrix.scale(item2artboardScaleX, item2artboardScaleY);
-            break;
-        }
-        case RiveRenderSettings::PreserveAspectCrop: {
-            const auto scaleFactor = qMax(item2artboardScaleX, item2artboardScaleY);
-            combinedMatrix.scale(scaleFactor, scaleFactor);
-            break;
-        }
-        default:
-        case RiveRenderSettings::PreserveAspectFit: {
-            const auto scaleFactor = qMin(item2artboardScaleX, item2artboardScaleY);
-
-            float widthFactor = m_rect.width() - artboardInstance->width() * scaleFactor;
-            float heightFactor = m_rect.height() - artboardInstance->height() * scaleFactor;
-
-            if (widthFactor > 0) {
-                // diff through 2 since its centered horizontal
-                widthFactor = (widthFactor / 2.0f) * 1.0f / m_rect.width();
-                left = widthFactor;
-                right = 1.0 - widthFactor;
-            }
-
-            if (heightFactor > 0) {
-                // diff through 2 since its centered vertical
-                heightFactor = (heightFactor / 2.0f) * 1.0f / m_rect.height();
-                top = heightFactor;
-                bottom = 1.0 - heightFactor;
-            }
+    // the render atlas records the frames of the items in it before they are prepared, see RhiRenderAtlas::render
+    // it only knows the projection of the last frame, after a change the item draws its region again
+    if (!m_atlasFrameRecorded || m_frameProjection != *projectionMatrix()) {
+        updateFrame();
 
-            combinedMatrix.scale(scaleFactor, scaleFactor);
-            break;
+        // atlas regions are drawn right away into the command buffer of the frame, without an offscreen frame of their own
+        if (m_renderAtlas && !m_renderer->isFrameUnchanged()) {
+            m_currentRenderSurface = m_surfaceA;
+            renderNestedArtboards(commandBuffer);
+            m_renderer->render(commandBuffer);
+            m_textureProviderDirty = true;
         }
-        }
-
-        m_renderer->setProjectionMatrix(&projMatrix, &combinedMatrix);
     }
+    m_atlasFrameRecorded = false;
+    m_atlasPrepared = true;
 
-    artboardInstance->draw(m_renderer);
+    float left = m_artboardEdges.left();
+    float right = m_artboardEdges.right();
+    float top = m_artboardEdges.top();
+    float bottom = m_artboardEdges.bottom();
 
-    if (!m_cleanUpTextureTarget) {
+    if (!m_renderAtlas && !m_cleanUpTextureTarget) {
         const bool isMetal = rhi->backend() == QRhi::Metal;
         const bool renderInMsaaBuffer = sampleCount > 1 && !isMetal;
         QRhiColorAttachment colorAttachment;
@@ -675,12 +887,18 @@ void RiveQSGRHIRenderNode::prepare()
         if (m_postprocessing) {
             m_postprocessing->initializePostprocessingPipeline(rhi, commandBuffer, QSize(m_rect.width(), m_rect.height()),
                                                            m_renderSurfaceA.texture, m_renderSurfaceB.texture);
+            m_surfaceChanged = true;
         }
 
         m_verticesDirty = false;
     }
 
     if (!m_vertexBuffer) {
+        // the region of the surfaces the item was drawn to
+        const QRectF texCoordRect = surfaceTexCoordRect();
+        m_texCoords = { QVector2D(texCoordRect.left(), texCoordRect.top()), QVector2D(texCoordRect.left(), texCoordRect.bottom()),
+                        QVector2D(texCoordRect.right(), texCoordRect.top()), QVector2D(texCoordRect.right(), texCoordRect.bottom()) };
+
         int vertexCount = m_vertices.count();
 
         int positionBufferSize = vertexCount * sizeof(QVector2D);
@@ -711,8 +929,9 @@ void RiveQSGRHIRenderNode::prepare()
     }
 
     if (!m_finalDrawResourceBindings) {
+        QRhiSampler *sampler = m_registry->nearestSampler();
 
-        QRhiTexture *postprocessedBuffer = m_dummyTexture;
+        QRhiTexture *postprocessedBuffer = m_registry->dummyTexture();
 
         if (m_postprocessing) {
             postprocessedBuffer = m_postprocessing->getTarget();
@@ -724,9 +943,9 @@ void RiveQSGRHIRenderNode::prepare()
             QRhiShaderResourceBinding::uniformBuffer(0, QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage,
                                                      m_finalDrawUniformBuffer),
             // binding both buffers and decide in the final draw shader which to use.
-            QRhiShaderResourceBinding::sampledTexture(1, QRhiShaderResourceBinding::FragmentStage, getRenderBufferA(), m_sampler),
-            QRhiShaderResourceBinding::sampledTexture(2, QRhiShaderResourceBinding::FragmentStage, getRenderBufferB(), m_sampler),
-            QRhiShaderResourceBinding::sampledTexture(3, QRhiShaderResourceBinding::FragmentStage, postprocessedBuffer, m_sampler),
+            QRhiShaderResourceBinding::sampledTexture(1, QRhiShaderResourceBinding::FragmentStage, getRenderBufferA(), sampler),
+            QRhiShaderResourceBinding::sampledTexture(2, QRhiShaderResourceBinding::FragmentStage, getRenderBufferB(), sampler),
+            QRhiShaderResourceBinding::sampledTexture(3, QRhiShaderResourceBinding::FragmentStage, postprocessedBuffer, sampler),
         });
 
         m_finalDrawResourceBindings->create();
@@ -734,8 +953,11 @@ void RiveQSGRHIRenderNode::prepare()
     }
 
     if (!m_finalDrawPipeline) {
-        m_finalDrawPipeline = createDrawPipeline(rhi, true, false, QSGRenderNodePrivate::get(this)->m_rt.rpDesc,
-                                                 QRhiGraphicsPipeline::TriangleStrip, m_finalDrawShader, m_finalDrawResourceBindings);
+        // it draws into the render target of the scene graph, so it is not shared
+        m_finalDrawPipeline = m_registry->createDrawPipeline(true, false, QSGRenderNodePrivate::get(this)->m_rt.rpDesc,
+                                                             QRhiGraphicsPipeline::TriangleStrip, m_registry->finalDrawShader(),
+                                                             m_finalDrawResourceBindings);
+        m_cleanupList.append(m_finalDrawPipeline);
     }
 
     QMatrix4x4 mvp = *projectionMatrix();
@@ -758,6 +980,16 @@ void RiveQSGRHIRenderNode::prepare()
         useTextureNumber = 2;
     }
 
+    // the edges of the artboard within the region of the atlas, the shader compares them to the flipped coordinates
+    if (m_renderAtlas) {
+        const QRectF texCoordRect = surfaceTexCoordRect();
+        const float regionTop = flipped ? 1.0f - texCoordRect.bottom() : texCoordRect.top();
+        left = texCoordRect.left() + left * texCoordRect.width();
+        right = texCoordRect.left() + right * texCoordRect.width();
+        top = regionTop + top * texCoordRect.height();
+        bottom = regionTop + bottom * texCoordRect.height();
+    }
+
     resourceUpdates->updateDynamicBuffer(m_finalDrawUniformBuffer, 0, 64, mvp.constData());
     resourceUpdates->updateDynamicBuffer(m_finalDrawUniformBuffer, 64, 4, &opacity);
     resourceUpdates->updateDynamicBuffer(m_finalDrawUniformBuffer, 68, 4, &flipped);
@@ -769,146 +1001,21 @@ void RiveQSGRHIRenderNode::prepare()
 
     commandBuffer->resourceUpdate(resourceUpdates);
 
-    // postprocess display buffer
-    if (m_postprocessing) {
+    // postprocess display buffer, its result stays valid as long as the surface does not change
+    if (m_postprocessing && m_surfaceChanged) {
         m_postprocessing->postprocess(rhi, commandBuffer, isCurrentRenderBufferA());
+        m_surfaceChanged = false;
     }
-}
-
-QRhiGraphicsPipeline *RiveQSGRHIRenderNode::createClipPipeline(QRhi *rhi, QRhiRenderPassDescriptor *renderPassDescriptor,
-                                                               QRhiShaderResourceBindings *bindings)
-{
-    QRhiGraphicsPipeline *clipPipeLine = rhi->newGraphicsPipeline();
-
-    clipPipeLine->setShaderStages(m_clipShader.cbegin(), m_clipShader.cend());
-    clipPipeLine->setFlags(QRhiGraphicsPipeline::UsesStencilRef);
-    clipPipeLine->setDepthTest(true);
-    clipPipeLine->setDepthWrite(true);
-
-    QRhiGraphicsPipeline::TargetBlend disabledColorWrite;
-    disabledColorWrite.colorWrite = QRhiGraphicsPipeline::ColorMask(0);
-    clipPipeLine->setTargetBlends({ disabledColorWrite });
-
-    QRhiVertexInputLayout inputLayout;
-    inputLayout.setBindings({
-        { sizeof(QVector2D) }
-    });
-    inputLayout.setAttributes({
-        { 0, 0, QRhiVertexInputAttribute::Float2, 0 }
-    });
-
-    // Configure stencil operations for writing stencil values
-    QRhiGraphicsPipeline::StencilOpState stencilOpState = { QRhiGraphicsPipeline::Keep, QRhiGraphicsPipeline::Keep,
-                                                            QRhiGraphicsPipeline::Replace, QRhiGraphicsPipeline::Always };
-    clipPipeLine->setStencilFront(stencilOpState);
-    clipPipeLine->setStencilBack(stencilOpState);
-    clipPipeLine->setStencilTest(true);
-    clipPipeLine->setCullMode(QRhiGraphicsPipeline::None);
-    clipPipeLine->setTopology(QRhiGraphicsPipeline::Triangles);
-    clipPipeLine->setVertexInputLayout(inputLayout);
-    clipPipeLine->setRenderPassDescriptor(renderPassDescriptor);
-
-    clipPipeLine->setShaderResourceBindings(bindings);
-    clipPipeLine->create();
-    m_cleanupList.append(clipPipeLine);
-
-    return clipPipeLine;
-}
-
-QRhiGraphicsPipeline *RiveQSGRHIRenderNode::createDrawPipeline(QRhi *rhi, bool srcOverBlend, bool stencilBuffer,
-                                                               QRhiRenderPassDescriptor *renderPassDescriptor,
-                                                               QRhiGraphicsPipeline::Topology t, const QList<QRhiShaderStage> &shader,
-                                                               QRhiShaderResourceBindings *bindings)
-{
-    QRhiGraphicsPipeline *drawPipeLine = rhi->newGraphicsPipeline();
-
-    //
-    // If layer.enabled == true on our QQuickItem, the rendering face is flipped for
-    // backends with isYUpInFrameBuffer == true (OpenGL). This does not happen with
-    // RHI backends with isYUpInFrameBuffer == false. We swap the triangle winding
-    // order to work around this.
-    //
-    drawPipeLine->setFrontFace(rhi->isYUpInFramebuffer() ? QRhiGraphicsPipeline::CW : QRhiGraphicsPipeline::CCW);
-    drawPipeLine->setCullMode(QRhiGraphicsPipeline::None);
-    drawPipeLine->setTopology(t);
-
-    if (srcOverBlend) {
-        QRhiGraphicsPipeline::TargetBlend blend;
-        blend.enable = true;
-        blend.srcColor = QRhiGraphicsPipeline::SrcAlpha;
-        blend.dstColor = QRhiGraphicsPipeline::OneMinusSrcAlpha;
-        blend.srcAlpha = QRhiGraphicsPipeline::One;
-        blend.dstAlpha = QRhiGraphicsPipeline::OneMinusSrcAlpha;
-        drawPipeLine->setTargetBlends({ blend });
-    }
-
-    drawPipeLine->setShaderResourceBindings(bindings);
-    drawPipeLine->setShaderStages(shader.cbegin(), shader.cend());
-
-    QRhiVertexInputLayout inputLayout;
-    inputLayout.setBindings({
-        { sizeof(QVector2D) }, // Stride for position buffer
-        { sizeof(QVector2D) }, // Stride for texture coordinate buffer
-    });
-    inputLayout.setAttributes({
-        { 0, 0, QRhiVertexInputAttribute::Float2, 0 }, // Position1
-        { 1, 1, QRhiVertexInputAttribute::Float2, 0 } // Texture coordinate
-    });
-
-    drawPipeLine->setVertexInputLayout(inputLayout);
-    drawPipeLine->setRenderPassDescriptor(renderPassDescriptor);
-
-    if (stencilBuffer) {
-        QRhiGraphicsPipeline::StencilOpState stencilOpState = { QRhiGraphicsPipeline::Keep, QRhiGraphicsPipeline::Keep,
-                                                                QRhiGraphicsPipeline::Replace, QRhiGraphicsPipeline::Equal };
-        drawPipeLine->setDepthTest(false);
-        drawPipeLine->setDepthWrite(false);
-        drawPipeLine->setStencilFront(stencilOpState);
-        drawPipeLine->setStencilBack(stencilOpState);
-        drawPipeLine->setStencilTest(true);
-        drawPipeLine->setStencilWriteMask(0);
-        drawPipeLine->setFlags(QRhiGraphicsPipeline::UsesStencilRef);
-    }
-
-    drawPipeLine->create();
-    m_cleanupList.append(drawPipeLine);
-    return drawPipeLine;
-}
 
-QRhiGraphicsPipeline *RiveQSGRHIRenderNode::createBlendPipeline(QRhi *rhi, QRhiRenderPassDescriptor *renderPass,
-                                                                QRhiShaderResourceBindings *bindings)
-{
-    auto *blendPipeLine = rhi->newGraphicsPipeline();
-    m_cleanupList.append(blendPipeLine);
-    //
-    // If layer.enabled == true on our QQuickItem, the rendering face is flipped for
-    // backends with isYUpInFrameBuffer == true (OpenGL). This does not happen with
-    // RHI backends with isYUpInFrameBuffer == false. We swap the triangle winding
-    // order to work around this.
-    //
-    blendPipeLine->setFrontFace(rhi->isYUpInFramebuffer() ? QRhiGraphicsPipeline::CW : QRhiGraphicsPipeline::CCW);
-    blendPipeLine->setCullMode(QRhiGraphicsPipeline::None);
-    blendPipeLine->setTopology(QRhiGraphicsPipeline::TriangleStrip);
-
-    blendPipeLine->setStencilTest(false);
-    blendPipeLine->setShaderResourceBindings(bindings);
-    blendPipeLine->setShaderStages(m_blendShaders.cbegin(), m_blendShaders.cend());
-
-    QRhiVertexInputLayout inputLayout;
-    inputLayout.setBindings({
-        { sizeof(QVector2D) },
-        { sizeof(QVector2D) },
-    });
-    inputLayout.setAttributes({
-        { 0, 0, QRhiVertexInputAttribute::Float2, 0 }, // Position1
-        { 1, 1, QRhiVertexInputAttribute::Float2, 0 } // Texture coordinate
-    });
-
-    blendPipeLine->setVertexInputLayout(inputLayout);
-    blendPipeLine->setRenderPassDescriptor(renderPass);
-
-    blendPipeLine->create();
-    return blendPipeLine;
+    // the texture the final draw samples, other items show the same
+    if (m_textureProvider) {
+        QRhiTexture *finalTexture = m_postprocessing ? m_postprocessing->getTarget() : getCurrentRenderBuffer();
+        m_textureProvider->setTexture(finalTexture, surfaceRect(), rhi->isYUpInFramebuffer());
+        if (m_textureProviderDirty) {
+            m_textureProvider->contentChanged();
+            m_textureProviderDirty = false;
+        }
+    }
 }
 
 void RiveQSGRHIRenderNode::RenderSurface::cleanUp()
@@ -947,7 +1054,7 @@ void RiveQSGRHIRenderNode::RenderSurface::cleanUp()
 }
 
 bool RiveQSGRHIRenderNode::RenderSurface::create(QRhi *rhi, int samples, const QSize &surfaceSize, QRhiRenderBuffer *stencilClippingBuffer,
-                                                 QRhiTextureRenderTarget::Flags flags)
+                                                 QRhiTextureRenderTarget::Flags flags, QRhiTextureRenderTarget::Flags blendFlags)
 {
     
     const bool isMetal = rhi->backend() == QRhi::Metal;
@@ -995,7 +1102,7 @@ bool RiveQSGRHIRenderNode::RenderSurface::create(QRhi *rhi, int samples, const Q
         }
 
         QRhiTextureRenderTargetDescription textureTargetDesc(colorAttachment);
-        blendTarget = rhi->newTextureRenderTarget(textureTargetDesc);
+        blendTarget = rhi->newTextureRenderTarget(textureTargetDesc, blendFlags);
         blendDesc = blendTarget->newCompatibleRenderPassDescriptor();
         blendTarget->setRenderPassDescriptor(blendDesc);
         blendTarget->create();
@@ -7,7 +7,12 @@
 
 #include "riveqsgrendernode.h"
 #include "datatypes.h"
+#include "renderer/riveqtdisplaylist.h"
+#include "renderer/riveqtnestedartboardcache.h"
+#include "rhi/rhiresourceregistry.h"
+#include "riveqsgtextureprovider.h"
 
+#include <QPointer>
 #include <QQuickItem>
 #include <QSGRenderNode>
 #include <private/qrhi_p.h>
@@ -16,6 +21,8 @@
 
 class RiveQtRhiRenderer;
 class PostprocessingSMAA;
+class RhiRenderAtlas;
+struct RhiPassState;
 
 class RiveQSGRHIRenderNode : public RiveQSGRenderNode
 {
@@ -26,6 +33,14 @@ public:
     void setRect(const QRectF &bounds) override;
     void setFillMode(const RiveRenderSettings::FillMode mode);
     void setPostprocessingMode(const RiveRenderSettings::PostprocessingMode postprocessingMode);
+    void setFillRenderMode(const RiveRenderSettings::FillRenderMode fillRenderMode);
+    void setStrokeMode(const RiveRenderSettings::StrokeMode strokeMode);
+    void setAntialiasingMode(const RiveRenderSettings::AntialiasingMode antialiasingMode);
+    void setNestedArtboardCaching(bool nestedArtboardCaching) { m_nestedArtboardCaching = nestedArtboardCaching; }
+    void setRenderAtlas(bool renderAtlas) { m_renderAtlasEnabled = renderAtlas; }
+
+    void updateArtboardInstance(std::weak_ptr<rive::ArtboardInstance> artboardInstance) override;
+    void setTextureProvider(RiveQSGTextureProvider *textureProvider) override;
 
     void renderOffscreen() override;
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
@@ -44,6 +59,17 @@ public:
     QRhiTextureRenderTarget *currentBlendTarget();
     QRhiGraphicsPipeline *renderPipeline(bool shaderBlending);
     QRhiGraphicsPipeline *clippingPipeline();
+    QRhiGraphicsPipeline *stencilFillPipeline(bool evenOdd);
+    QRhiGraphicsPipeline *wedgeFillPipeline(bool evenOdd);
+    QRhiGraphicsPipeline *coverPipeline(bool shaderBlending);
+    QRhiGraphicsPipeline *writeOncePipeline(bool shaderBlending);
+    QRhiGraphicsPipeline *strokePipeline(bool shaderBlending);
+    QRhiGraphicsPipeline *overwritePipeline();
+    // nullptr in case the rhi does not support instancing
+    QRhiGraphicsPipeline *pathInstancePipeline();
+    // the draw pipeline with the fragment shader of the paint type, created on first use
+    // only texture paints bind a sampler, the others use the uniform buffer alone
+    QRhiGraphicsPipeline *paintPipeline(QRhiGraphicsPipeline *pipeline, RhiResourceRegistry::PaintType paintType);
     QRhiGraphicsPipeline *currentBlendPipeline();
     QRhiRenderPassDescriptor *currentRenderPassDescriptor(bool shaderBlending);
     QRhiRenderPassDescriptor *currentBlendPassDescriptor();
@@ -53,15 +79,22 @@ public:
     QRhiTexture *getRenderBufferB();
     QRhiTexture *getRenderBufferIntern();
     QRhiTexture *getDummyTexture();
+    QRhiSampler *linearSampler();
 
     bool isCurrentRenderBufferA();
 
+    // the pixels of the render surfaces this item draws to, all of them unless it uses a region of the render atlas
+    QRect surfaceRect() const;
+    // surfaceRect with the origin bottom left, as QRhi expects it
+    QRhiViewport surfaceViewport() const;
+    // surfaceRect in texture coordinates, not flipped
+    QRectF surfaceTexCoordRect() const;
+
     static RiveQSGRHIRenderNode *create(const RiveRenderSettings &renderSettings,
                                         QQuickWindow *window,
                                         std::weak_ptr<rive::ArtboardInstance> artboardInstance,
                                         const QRectF &geometry);
 
-protected:
     struct RenderSurface
     {
         QRhiRenderBuffer *buffer { nullptr };
@@ -79,16 +112,29 @@ protected:
 
         // this creates all resources needed to have a texture to draw on
         bool create(QRhi *rhi, int samples, const QSize &surfaceSize, QRhiRenderBuffer *stencilClippingBuffer,
-                    QRhiTextureRenderTarget::Flags flags = QRhiTextureRenderTarget::PreserveColorContents);
+                    QRhiTextureRenderTarget::Flags flags = QRhiTextureRenderTarget::PreserveColorContents,
+                    QRhiTextureRenderTarget::Flags blendFlags = {});
     };
 
+    // the nodes draw into the surface instead of the item's ones until restoreRenderSurfaces()
+    // used for the textures of cached nested artboards, which have a renderer of their own
+    void redirectRenderSurfaces(RenderSurface *surface);
+    void restoreRenderSurfaces();
+
+    QQuickWindow *window() const { return m_window; }
+    int sampleCount() const { return m_sampleCount; }
+    // the command buffer of the frame the window is rendering
+    QRhiCommandBuffer *frameCommandBuffer() const;
+
+    // the render atlas records the frames of its items into shared passes before the items are prepared
+    // updates the frame and uploads its resources, false in case the item has nothing to draw into the pass
+    bool prepareAtlasFrame(QRhiCommandBuffer *commandBuffer);
+    void recordAtlasFrame(QRhiCommandBuffer *commandBuffer, RhiPassState &passState);
+
+protected:
     QRhiBuffer *m_vertexBuffer { nullptr };
     QRhiBuffer *m_texCoordBuffer { nullptr };
     QRhiBuffer *m_finalDrawUniformBuffer { nullptr };
-    QRhiBuffer *m_drawUniformBuffer { nullptr };
-    QRhiBuffer *m_blendUniformBuffer { nullptr };
-
-    QRhiBuffer *m_clippingUniformBuffer { nullptr };
 
     // shared clipping buffer for all surfaces
     QRhiRenderBuffer *m_stencilClippingBuffer { nullptr };
@@ -96,18 +142,10 @@ protected:
     // those bind the texture of surfaceA and B for the final draw call
     QRhiShaderResourceBindings *m_finalDrawResourceBindings { nullptr };
 
-    QRhiShaderResourceBindings *m_blendResourceBindingsA { nullptr };
-    QRhiShaderResourceBindings *m_blendResourceBindingsB { nullptr };
-    QRhiShaderResourceBindings *m_drawPipelineResourceBindings { nullptr };
-    QRhiShaderResourceBindings *m_clippingResourceBindings { nullptr };
-
-    QRhiSampler *m_sampler { nullptr };
-    QRhiSampler *m_blendSampler { nullptr };
-
-    QList<QRhiShaderStage> m_finalDrawShader;
-    QList<QRhiShaderStage> m_blendShaders;
-    QList<QRhiShaderStage> m_pathShader;
-    QList<QRhiShaderStage> m_clipShader;
+    // shaders, samplers and pipelines are shared with the other items rendering with the same rhi
+    RhiResourceRegistry *m_registry { nullptr };
+    // the pipelines matching the format and sample count of our surfaces
+    RhiResourceRegistry::Pipelines *m_pipelines { nullptr };
 
     QList<QVector2D> m_vertices;
     QList<QVector2D> m_texCoords;
@@ -115,6 +153,25 @@ protected:
     QVector<QRhiResource *> m_cleanupList;
 
     RiveQtRhiRenderer *m_renderer { nullptr };
+    // rive records into the display list first, the renderer replays it
+    RiveQtDisplayList m_displayList;
+    // replays the display list in case nested artboards are drawn from textures
+    // one per artboard instance, so switching back to an artboard finds its textures again
+    struct NestedArtboardCacheEntry
+    {
+        std::weak_ptr<rive::ArtboardInstance> artboardInstance;
+        RiveQtNestedArtboardCache cache;
+    };
+    QHash<const rive::ArtboardInstance *, NestedArtboardCacheEntry> m_nestedArtboardCaches;
+    bool m_nestedArtboardCaching { false };
+    // renders the textures of the nested artboards that changed, before m_renderer draws them
+    void renderNestedArtboards(QRhiCommandBuffer *commandBuffer);
+    // projection, display list and tessellation of the frame, m_renderer draws it afterwards
+    void updateFrame();
+    // the projection of the scene graph updateFrame() used
+    QMatrix4x4 m_frameProjection;
+    // value range of 0 to 1 to describe the edges of the artboard on the final render ("clip the final texture")
+    QRectF m_artboardEdges { 0, 0, 1, 1 };
 
     // RenderSurface A and B swap during the renderpathes
     // since we can not read and write from a texture at the same time
@@ -124,9 +181,6 @@ protected:
     RenderSurface m_renderSurfaceB;
     RenderSurface m_renderSurfaceIntern;
 
-    // dummy texture to make the shader binding happy
-    QRhiTexture *m_dummyTexture { nullptr };
-
     // pointer that holds the current render surface (a/b)
     // this will be set to &m_renderSurfaceA or &m_renderSurfaceB by the renderprocess
     RenderSurface *m_currentRenderSurface { nullptr };
@@ -134,34 +188,41 @@ protected:
     // used to draw the final texture on the qt surface
     QRhiGraphicsPipeline *m_finalDrawPipeline { nullptr };
 
-    // used in the main draw call to paint directly to the renderSurface texture
-    QRhiGraphicsPipeline *m_drawPipeline { nullptr };
-
-    // used in the main draw call in case we need to draw a to-be-blend geometry
-    QRhiGraphicsPipeline *m_drawPipelineIntern { nullptr };
-
-    // used to shader-blend the to-be-blend geomentry texture to the current renderSurface
-    QRhiGraphicsPipeline *m_blendPipeline { nullptr };
-
-    // used to draw into the stencil buffer during the main draw call
-    QRhiGraphicsPipeline *m_clipPipeline { nullptr };
-
     // we need this since our default target preserves colors
     // this is configured to not preserve
     QRhiTextureRenderTarget *m_cleanUpTextureTarget { nullptr };
 
+    // takes a region of the render atlas in case the item is small enough and the atlas has space left
+    bool allocateAtlasRegion();
+    void releaseAtlasRegion();
+
+    bool m_renderAtlasEnabled { false };
+    // set while the item draws into m_atlasRegion of the atlas surfaces instead of its own
+    RhiRenderAtlas *m_renderAtlas { nullptr };
+    QRect m_atlasRegion;
+    // the atlas updated and recorded the frame already, prepare() only has to compose it
+    bool m_atlasFrameRecorded { false };
+    // prepared since the last atlas frame, items that are not may be hidden and are left out by the atlas
+    bool m_atlasPrepared { false };
+    // either our own surfaces or the ones of the atlas
+    RenderSurface *m_surfaceA { &m_renderSurfaceA };
+    RenderSurface *m_surfaceB { &m_renderSurfaceB };
+    RenderSurface *m_surfaceIntern { &m_renderSurfaceIntern };
+    // the surface drawn to while redirected, and what the pointers above were before
+    RenderSurface *m_redirectSurface { nullptr };
+    RenderSurface *m_redirectedSurfaces[4] { nullptr, nullptr, nullptr, nullptr };
+
     bool m_verticesDirty = true;
     RiveRenderSettings::FillMode m_fillMode;
 
     PostprocessingSMAA *m_postprocessing { nullptr };
+    // the surface was drawn to since the last postprocessing pass
+    bool m_surfaceChanged { true };
 
-    int m_sampleCount { 1 };
+    // shows the final texture in other items, owned by the quick item
+    QPointer<RiveQSGTextureProvider> m_textureProvider;
+    // the surface was drawn to since the provider was told last
+    bool m_textureProviderDirty { true };
 
-private:
-    QRhiGraphicsPipeline *createBlendPipeline(QRhi *rhi, QRhiRenderPassDescriptor *renderPass, QRhiShaderResourceBindings *bindings);
-    QRhiGraphicsPipeline *createClipPipeline(QRhi *rhi, QRhiRenderPassDescriptor *renderPassDescriptor,
-                                             QRhiShaderResourceBindings *bindings);
-    QRhiGraphicsPipeline *createDrawPipeline(QRhi *rhi, bool srcOverBlend, bool stencilBuffer,
-                                             QRhiRenderPassDescriptor *renderPassDescriptor, QRhiGraphicsPipeline::Topology t,
-                                             const QList<QRhiShaderStage> &shader, QRhiShaderResourceBindings *bindings);
+    int m_sampleCount { 1 };
 };
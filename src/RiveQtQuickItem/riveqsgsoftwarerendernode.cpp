@@ -85,7 +85,9 @@ void RiveQSGSoftwareRenderNode::paint(QPainter *painter, const QRect &bounds, co
         painter->setTransform(transformation, false);
 
         m_renderer.setPainter(painter);
-        artboardInstance->draw(&m_renderer);
+        m_displayList.clear();
+        artboardInstance->draw(&m_displayList);
+        m_displayList.replay(&m_renderer);
     }
     painter->restore();
 }
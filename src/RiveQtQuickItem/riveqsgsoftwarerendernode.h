@@ -7,6 +7,7 @@
 
 #include "riveqsgrendernode.h"
 #include "renderer/riveqtpainterrenderer.h"
+#include "renderer/riveqtdisplaylist.h"
 
 class QQuickWindow;
 
@@ -24,4 +25,5 @@ public:
 
 private:
     RiveQtPainterRenderer m_renderer;
+    RiveQtDisplayList m_displayList;
 };
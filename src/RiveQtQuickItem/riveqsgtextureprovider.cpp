@@ -0,0 +1,51 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "riveqsgtextureprovider.h"
+
+RiveQSGTextureProvider::RiveQSGTextureProvider()
+    : m_texture(new Texture)
+{
+    // the surfaces belong to the render node
+    m_texture->setOwnsTexture(false);
+    m_texture->setHasAlphaChannel(true);
+}
+
+RiveQSGTextureProvider::~RiveQSGTextureProvider() { }
+
+QSGTexture *RiveQSGTextureProvider::texture() const
+{
+    return m_texture->rhiTexture() ? m_texture.data() : nullptr;
+}
+
+void RiveQSGTextureProvider::setTexture(QRhiTexture *texture, const QRect &region, bool mirrored)
+{
+    if (m_texture->rhiTexture() == texture && m_region == region && m_mirrored == mirrored) {
+        return;
+    }
+
+    m_region = region;
+    m_mirrored = mirrored;
+
+    m_texture->setTexture(texture);
+    if (texture && !region.isEmpty()) {
+        const QSizeF textureSize = texture->pixelSize();
+        QRectF subRect(region.x() / textureSize.width(), region.y() / textureSize.height(), region.width() / textureSize.width(),
+                       region.height() / textureSize.height());
+        // a negative height lets the consumers read the rows top down
+        if (mirrored) {
+            subRect = QRectF(subRect.left(), 1.0 - subRect.top(), subRect.width(), -subRect.height());
+        }
+        m_texture->subRect = subRect;
+        m_texture->setTextureSize(region.size());
+    }
+
+    emit textureChanged();
+}
+
+void RiveQSGTextureProvider::contentChanged()
+{
+    emit textureChanged();
+}
@@ -0,0 +1,45 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#pragma once
+
+#include <QSGTextureProvider>
+#include <QScopedPointer>
+#include <private/qrhi_p.h>
+#include <private/qsgtexture_p.h>
+
+// hands the final texture of a rive item to other items of the same window, lives in the render thread
+// the render node updates it once a frame was drawn, the texture is only valid until the node draws the next one
+class RiveQSGTextureProvider : public QSGTextureProvider
+{
+    Q_OBJECT
+
+public:
+    RiveQSGTextureProvider();
+    ~RiveQSGTextureProvider();
+
+    // nullptr as long as the item has not drawn anything
+    QSGTexture *texture() const override;
+
+    // region is the part of the texture showing the item, in pixels with the origin top left
+    // mirrored textures store their rows bottom up, as OpenGL renders them
+    void setTexture(QRhiTexture *texture, const QRect &region, bool mirrored);
+    // the item drew a new frame into the same texture
+    void contentChanged();
+
+private:
+    // a plain texture limited to the region of the item
+    class Texture : public QSGPlainTexture
+    {
+    public:
+        QRectF normalizedTextureSubRect() const override { return subRect; }
+
+        QRectF subRect { 0, 0, 1, 1 };
+    };
+
+    QScopedPointer<Texture> m_texture;
+    QRect m_region;
+    bool m_mirrored { false };
+};
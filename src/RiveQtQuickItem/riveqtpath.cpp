@@ -5,6 +5,7 @@
 // SPDX-License-Identifier: LGPL-3.0-or-later
 
 #include "riveqtpath.h"
+#include "riveqtpathkernels.h"
 #include "rqqplogging.h"
 #include "riveqtutils.h"
 
@@ -12,84 +13,323 @@
 #include <QMatrix2x2>
 #include <QtMath>
 #include <private/qtriangulator_p.h>
+#include <private/qvectorpath_p.h>
 
-#if !defined(USE_QPAINTERPATH_STROKER)
-#include <optional>
-#endif
+#include <atomic>
+#include <limits>
+
+// upper bound for the number of line segments a single cubic is flattened into
+#define MAX_CUBIC_SEGMENTS 100
+
+// upper bound for the number of triangles a round join or cap is built from
+#define MAX_ROUND_SEGMENTS 64
+
+// one counter for all paths (tessellation runs on several threads), equal versions mean equal geometry
+static quint64 nextGeometryVersion()
+{
+    static std::atomic<quint64> version { 0 };
+    return ++version;
+}
+
+// Wang's formula: number of segments needed to keep the flattened cubic within the tolerance
+static int cubicSegmentCount(const QVector2D &p0, const QVector2D &p1, const QVector2D &p2, const QVector2D &p3, const float tolerance)
+{
+    const float d1 = (p0 - 2.0f * p1 + p2).length();
+    const float d2 = (p1 - 2.0f * p2 + p3).length();
+    const int segments = qCeil(qSqrt(0.75f * qMax(d1, d2) / tolerance));
+    return qBound(1, segments, MAX_CUBIC_SEGMENTS);
+}
+
+// stores the indices as 16 bit whenever the vertex count allows it
+static void setGeometryIndices(RiveQtPathGeometry &geometry, const quint32 *indices, int indexCount)
+{
+    geometry.uses32BitIndices = geometry.vertices.size() > std::numeric_limits<quint16>::max();
+
+    if (geometry.uses32BitIndices) {
+        geometry.indices = QByteArray(reinterpret_cast<const char *>(indices), indexCount * sizeof(quint32));
+        return;
+    }
+
+    geometry.indices.resize(indexCount * sizeof(quint16));
+    RiveQtPathKernels::narrowIndices(indices, indexCount, reinterpret_cast<quint16 *>(geometry.indices.data()));
+}
+
+// number of segments an arc needs to stay within the tolerance
+static int roundSegmentCount(const float angle, const float radius, const float tolerance)
+{
+    if (radius <= tolerance) {
+        return 1;
+    }
+
+    const float step = 2.0f * qAcos(1.0f - tolerance / radius);
+    return qBound(1, qCeil(angle / step), MAX_ROUND_SEGMENTS);
+}
+
+static QVector2D rotated(const QVector2D &vector, const float cosPhi, const float sinPhi)
+{
+    return QVector2D(cosPhi * vector.x() - sinPhi * vector.y(), sinPhi * vector.x() + cosPhi * vector.y());
+}
+
+// emits stroke triangles straight from the flattened centre line, the pieces overlap
+// at joins and caps and are meant to be drawn with each pixel touched only once
+struct NativeStroker
+{
+    NativeStroker(float halfWidth, float tolerance, float miterLimit, Qt::PenJoinStyle joinStyle, Qt::PenCapStyle capStyle)
+        : halfWidth(halfWidth)
+        , tolerance(tolerance)
+        , miterLimit(miterLimit)
+        , joinStyle(joinStyle)
+        , capStyle(capStyle)
+    {
+    }
+
+    int addVertex(const QVector2D &vertex)
+    {
+        vertices.append(vertex);
+        return vertices.size() - 1;
+    }
+
+    void addTriangle(int a, int b, int c) { indices << a << b << c; }
+
+    void addQuad(const QVector2D &a, const QVector2D &b, const QVector2D &c, const QVector2D &d)
+    {
+        const int first = vertices.size();
+        vertices << a << b << c << d;
+        addTriangle(first, first + 1, first + 2);
+        addTriangle(first + 2, first + 1, first + 3);
+    }
+
+    // fan around center, from the offset start rotated by angle (signed) in segments
+    void addArc(const QVector2D &center, const QVector2D &start, const float angle)
+    {
+        const int segments = roundSegmentCount(qAbs(angle), halfWidth, tolerance);
+        const float phi = angle / segments;
+        const float cosPhi = qCos(phi);
+        const float sinPhi = qSin(phi);
+
+        const int centerIndex = addVertex(center);
+        QVector2D offset = start;
+        int previous = addVertex(center + offset);
+        for (int i = 0; i < segments; ++i) {
+            offset = rotated(offset, cosPhi, sinPhi);
+            const int next = addVertex(center + offset);
+            addTriangle(centerIndex, previous, next);
+            previous = next;
+        }
+    }
+
+    // quads along the segments between consecutive points, writes the direction of each segment
+    void addSegments(const QVector2D *points, int segmentCount, QVector2D *directions)
+    {
+        const int first = vertices.size();
+        vertices.resize(first + 4 * segmentCount);
+        RiveQtPathKernels::offsetSegments(points, segmentCount, halfWidth, directions, vertices.data() + first);
+
+        indices.reserve(indices.size() + 6 * segmentCount);
+        for (int i = 0; i < segmentCount; ++i) {
+            const int quad = first + 4 * i;
+            addTriangle(quad, quad + 1, quad + 2);
+            addTriangle(quad + 2, quad + 1, quad + 3);
+        }
+    }
+
+    void addJoin(const QVector2D &center, const QVector2D &incoming, const QVector2D &outgoing)
+    {
+        const float cross = incoming.x() * outgoing.y() - incoming.y() * outgoing.x();
+        const float dot = QVector2D::dotProduct(incoming, outgoing);
+
+        // straight continuation, the segment quads already meet
+        if (qAbs(cross) < 1e-6f && dot > 0.0f) {
+            return;
+        }
+
+        // the gap to fill opens on the outer side of the turn
+        const float side = cross > 0.0f ? -1.0f : 1.0f;
+        const QVector2D incomingOffset = QVector2D(-incoming.y(), incoming.x()) * (halfWidth * side);
+        const QVector2D outgoingOffset = QVector2D(-outgoing.y(), outgoing.x()) * (halfWidth * side);
+
+        switch (joinStyle) {
+        case Qt::RoundJoin: {
+            const float angle = qAcos(qBound(-1.0f, dot, 1.0f));
+            addArc(center, incomingOffset, cross > 0.0f ? angle : -angle);
+            return;
+        }
+        case Qt::MiterJoin:
+        case Qt::SvgMiterJoin: {
+            // the miter length relative to the half width is 1 / cos(theta / 2)
+            const float cosHalfAngle = qSqrt(qMax(0.0f, (1.0f + dot) / 2.0f));
+            if (cosHalfAngle > 0.0f && 1.0f / cosHalfAngle <= miterLimit) {
+                const QVector2D miter = (incomingOffset + outgoingOffset).normalized() * (halfWidth / cosHalfAngle);
+                const int centerIndex = addVertex(center);
+                const int incomingIndex = addVertex(center + incomingOffset);
+                const int miterIndex = addVertex(center + miter);
+                const int outgoingIndex = addVertex(center + outgoingOffset);
+                addTriangle(centerIndex, incomingIndex, miterIndex);
+                addTriangle(centerIndex, miterIndex, outgoingIndex);
+                return;
+            }
+            // beyond the miter limit it is a bevel
+            Q_FALLTHROUGH();
+        }
+        case Qt::BevelJoin:
+        default:
+            addTriangle(addVertex(center), addVertex(center + incomingOffset), addVertex(center + outgoingOffset));
+            return;
+        }
+    }
+
+    // direction points away from the stroke
+    void addCap(const QVector2D &center, const QVector2D &direction)
+    {
+        const QVector2D offset = QVector2D(-direction.y(), direction.x()) * halfWidth;
+
+        switch (capStyle) {
+        case Qt::SquareCap:
+            addQuad(center + offset, center - offset, center + offset + direction * halfWidth, center - offset + direction * halfWidth);
+            return;
+        case Qt::RoundCap:
+            addArc(center, offset, -M_PI);
+            return;
+        case Qt::FlatCap:
+        default:
+            return;
+        }
+    }
+
+    const float halfWidth;
+    const float tolerance;
+    const float miterLimit;
+    const Qt::PenJoinStyle joinStyle;
+    const Qt::PenCapStyle capStyle;
+
+    QVector<QVector2D> vertices;
+    QVector<quint32> indices;
+};
+
+// two triangles covering the given bounds
+static RiveQtPathGeometry coverQuad(float minX, float minY, float maxX, float maxY)
+{
+    RiveQtPathGeometry geometry;
+    geometry.vertices = { QVector2D(minX, minY), QVector2D(maxX, minY), QVector2D(maxX, maxY), QVector2D(minX, maxY) };
+    const quint16 coverIndices[] = { 0, 1, 2, 0, 2, 3 };
+    geometry.indices = QByteArray(reinterpret_cast<const char *>(coverIndices), sizeof(coverIndices));
+    return geometry;
+}
+
+// keeps the indexed triangles as they are, only the vertices are converted to float
+static RiveQtPathGeometry toPathGeometry(const QTriangleSet &triangles)
+{
+    RiveQtPathGeometry geometry;
+
+    const int vertexCount = triangles.vertices.size() / 2;
+    geometry.vertices.resize(vertexCount);
+    RiveQtPathKernels::packVertices(triangles.vertices.constData(), vertexCount, geometry.vertices.data());
+
+    const int indexCount = triangles.indices.size();
+    const char *indexData = static_cast<const char *>(triangles.indices.data());
+
+    if (triangles.indices.type() == QVertexIndexVector::UnsignedShort) {
+        geometry.indices = QByteArray(indexData, indexCount * sizeof(quint16));
+    } else {
+        // qTriangulate always produces 32 bit indices, most paths are fine with 16 bit
+        setGeometryIndices(geometry, reinterpret_cast<const quint32 *>(indexData), indexCount);
+    }
+
+    return geometry;
+}
 
 RiveQtPath::RiveQtPath()
     : rive::RenderPath()
 {
-    m_path.setFillRule(Qt::FillRule::WindingFill);
 }
 
 RiveQtPath::RiveQtPath(const RiveQtPath &other)
     : rive::RenderPath()
-#if !defined(USE_QPAINTERPATH_STROKER)
-    , m_pathSegmentsOutlineData(other.m_pathSegmentsOutlineData)
-    , m_segmentCount(other.m_segmentCount)
-#endif
-    , m_path(other.m_path)
-    , m_pathVertices(other.m_pathVertices)
-    , m_pathOutlineVertices(other.m_pathOutlineVertices)
+    , m_verbs(other.m_verbs)
+    , m_points(other.m_points)
+    , m_fillRule(other.m_fillRule)
+    , m_qPainterPath(other.m_qPainterPath)
+    , m_qPainterPathDirty(other.m_qPainterPathDirty)
+    , m_controlPointBounds(other.m_controlPointBounds)
+    , m_controlPointBoundsDirty(other.m_controlPointBoundsDirty)
+    // the copy has the same content, so it may share the version like it shares the geometry versions
+    , m_contentVersion(other.m_contentVersion)
+    , m_fillGeometry(other.m_fillGeometry)
+    , m_strokeGeometry(other.m_strokeGeometry)
+    , m_stencilFanGeometry(other.m_stencilFanGeometry)
+    , m_coverGeometry(other.m_coverGeometry)
+    , m_strokeCenterline(other.m_strokeCenterline)
+    , m_fillOutline(other.m_fillOutline)
+    , m_curveWedges(other.m_curveWedges)
+    , m_strokePen(other.m_strokePen)
+    , m_strokeMode(other.m_strokeMode)
+    , m_pathSegmentDataDirty(other.m_pathSegmentDataDirty)
+    , m_pathSegmentOutlineDataDirty(other.m_pathSegmentOutlineDataDirty)
+    , m_stencilFillDataDirty(other.m_stencilFillDataDirty)
+    , m_strokeCenterlineDirty(other.m_strokeCenterlineDirty)
+    , m_fillOutlineDirty(other.m_fillOutlineDirty)
+    , m_curveWedgesDirty(other.m_curveWedgesDirty)
+    , m_retained(other.m_retained)
     , m_renderQuality(other.m_renderQuality)
 {
 }
 
 RiveQtPath::RiveQtPath(const rive::RawPath &rawPath, rive::FillRule fillRule, RiveRenderSettings::RenderQuality renderQuality)
     : rive::RenderPath()
+    , m_fillRule(fillRule)
     , m_renderQuality(renderQuality)
 {
-    m_path.clear();
-    m_path.setFillRule(RiveQtUtils::convert(fillRule));
-
     addRawPathImpl(rawPath);
 }
 
 void RiveQtPath::rewind()
 {
-    m_pathVertices.clear();
-
-#if !defined(USE_QPAINTERPATH_STROKER)
-    m_pathSegmentsOutlineData.clear();
-#endif
-
-    m_path.clear();
-    m_pathSegmentOutlineDataDirty = true;
-    m_pathSegmentDataDirty = true;
+    m_fillGeometry = {};
+    m_strokeGeometry = {};
+    m_stencilFanGeometry = {};
+    m_coverGeometry = {};
+
+    m_verbs.clear();
+    m_points.clear();
+    markDirty();
 }
 
 void RiveQtPath::moveTo(float x, float y)
 {
-    m_path.moveTo(x, y);
+    m_verbs.append(rive::PathVerb::move);
+    m_points.append(QVector2D(x, y));
+    markDirty();
 }
 
 void RiveQtPath::lineTo(float x, float y)
 {
-    m_path.lineTo(x, y);
+    m_verbs.append(rive::PathVerb::line);
+    m_points.append(QVector2D(x, y));
+    markDirty();
 }
 
 void RiveQtPath::cubicTo(float ox, float oy, float ix, float iy, float x, float y)
 {
-    m_path.cubicTo(ox, oy, ix, iy, x, y);
+    m_verbs.append(rive::PathVerb::cubic);
+    m_points.append(QVector2D(ox, oy));
+    m_points.append(QVector2D(ix, iy));
+    m_points.append(QVector2D(x, y));
+    markDirty();
 }
 
 void RiveQtPath::close()
 {
-    m_path.closeSubpath();
+    m_verbs.append(rive::PathVerb::close);
+    markDirty();
 }
 
 void RiveQtPath::fillRule(rive::FillRule value)
 {
-    switch (value) {
-    case rive::FillRule::evenOdd:
-        m_path.setFillRule(Qt::FillRule::OddEvenFill);
-        break;
-    case rive::FillRule::nonZero:
-    default:
-        m_path.setFillRule(Qt::FillRule::WindingFill);
-        break;
+    if (m_fillRule == value) {
+        return;
     }
+    m_fillRule = value;
+    markDirty();
 }
 
 void RiveQtPath::addRenderPath(rive::RenderPath *path, const rive::Mat2D &transform)
@@ -101,444 +341,648 @@ void RiveQtPath::addRenderPath(rive::RenderPath *path, const rive::Mat2D &transf
 
     RiveQtPath *qtPath = static_cast<RiveQtPath *>(path);
 
-    QTransform qTransform(transform[0], transform[1], transform[2], transform[3], transform[4], transform[5]);
+    // take (implicitly shared) copies, the path might be added to itself
+    const QVector<rive::PathVerb> verbs = qtPath->m_verbs;
+    const QVector<QVector2D> points = qtPath->m_points;
 
-    QPainterPath qPath = qtPath->toQPainterPath() * qTransform;
-    m_path.addPath(qPath);
+    m_verbs.append(verbs);
+    m_points.reserve(m_points.size() + points.size());
+    for (const QVector2D &point : points) {
+        m_points.append(QVector2D(transform[0] * point.x() + transform[2] * point.y() + transform[4],
+                                  transform[1] * point.x() + transform[3] * point.y() + transform[5]));
+    }
 
-    m_pathSegmentOutlineDataDirty = true;
-    m_pathSegmentDataDirty = true;
+    markDirty();
 }
 
 void RiveQtPath::addRawPath(const rive::RawPath &path)
 {
     addRawPathImpl(path);
+    markDirty();
+}
 
-    m_pathSegmentOutlineDataDirty = true;
+void RiveQtPath::applyMatrix(const QMatrix4x4 &matrix)
+{
+    RiveQtPathKernels::transformPoints(m_points.data(), m_points.size(), matrix);
+    markDirty();
+}
+
+void RiveQtPath::markDirty()
+{
     m_pathSegmentDataDirty = true;
+    m_pathSegmentOutlineDataDirty = true;
+    m_stencilFillDataDirty = true;
+    m_strokeCenterlineDirty = true;
+    m_fillOutlineDirty = true;
+    m_curveWedgesDirty = true;
+    m_qPainterPathDirty = true;
+    m_controlPointBoundsDirty = true;
+    m_contentVersion = 0;
 }
 
-void RiveQtPath::applyMatrix(const QMatrix4x4 &matrix)
+quint64 RiveQtPath::contentVersion() const
 {
-    m_path = m_path * matrix.toTransform();
+    // only taken on request, rebuilding a path marks it dirty once per verb
+    if (m_contentVersion == 0) {
+        m_contentVersion = nextGeometryVersion();
+    }
+    return m_contentVersion;
+}
+
+QRectF RiveQtPath::controlPointBounds() const
+{
+    if (!m_controlPointBoundsDirty) {
+        return m_controlPointBounds;
+    }
+
+    m_controlPointBounds = QRectF();
+    if (!m_points.isEmpty()) {
+        float minX = m_points.first().x();
+        float minY = m_points.first().y();
+        float maxX = minX;
+        float maxY = minY;
+        for (const QVector2D &point : m_points) {
+            minX = qMin(minX, point.x());
+            minY = qMin(minY, point.y());
+            maxX = qMax(maxX, point.x());
+            maxY = qMax(maxY, point.y());
+        }
+        m_controlPointBounds = QRectF(QPointF(minX, minY), QPointF(maxX, maxY));
+    }
+
+    m_controlPointBoundsDirty = false;
+    return m_controlPointBounds;
 }
 
-QVector<QVector<QVector2D>> RiveQtPath::toVertices()
+RiveQtPathGeometry RiveQtPath::fillGeometry()
 {
     if (m_pathSegmentDataDirty) {
         updatePathSegmentsData();
+        m_fillGeometry.version = nextGeometryVersion();
     }
-    return m_pathVertices;
+    return m_fillGeometry;
 }
 
 void RiveQtPath::setQPainterPath(const QPainterPath &path)
 {
-    m_path = path;
+    m_verbs.clear();
+    m_points.clear();
+    m_verbs.reserve(path.elementCount());
+    m_points.reserve(path.elementCount());
+
+    for (int i = 0; i < path.elementCount(); ++i) {
+        const QPainterPath::Element &element = path.elementAt(i);
+
+        switch (element.type) {
+        case QPainterPath::MoveToElement:
+            m_verbs.append(rive::PathVerb::move);
+            m_points.append(QVector2D(element.x, element.y));
+            break;
+        case QPainterPath::LineToElement:
+            m_verbs.append(rive::PathVerb::line);
+            m_points.append(QVector2D(element.x, element.y));
+            break;
+        case QPainterPath::CurveToElement: {
+            const QPainterPath::Element &controlPoint2 = path.elementAt(i + 1);
+            const QPainterPath::Element &endPoint = path.elementAt(i + 2);
+            m_verbs.append(rive::PathVerb::cubic);
+            m_points.append(QVector2D(element.x, element.y));
+            m_points.append(QVector2D(controlPoint2.x, controlPoint2.y));
+            m_points.append(QVector2D(endPoint.x, endPoint.y));
+            i += 2; // Skip the curve data elements, as we already processed them.
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    m_fillRule = path.fillRule() == Qt::OddEvenFill ? rive::FillRule::evenOdd : rive::FillRule::nonZero;
+    markDirty();
+
+    // we already have the QPainterPath, no need to build it again
+    m_qPainterPath = path;
+    m_qPainterPathDirty = false;
 }
 
 bool RiveQtPath::intersectWith(const QPainterPath &other)
 {
-    if (!m_path.isEmpty() && !other.isEmpty()) {
-        if (other.intersects(m_path)) {
-            QPainterPath tempQPainterPath = other.intersected(m_path);
+    const QPainterPath path = toQPainterPath();
+    if (!path.isEmpty() && !other.isEmpty()) {
+        if (other.intersects(path)) {
+            QPainterPath tempQPainterPath = other.intersected(path);
             if (!tempQPainterPath.isEmpty()) {
-                m_path = tempQPainterPath;
-                m_pathSegmentDataDirty = true;
-                m_pathSegmentOutlineDataDirty = true;
+                setQPainterPath(tempQPainterPath);
                 return true;
             }
         }
     }
-    m_path = other;
+    setQPainterPath(other);
     return false;
 }
 
 QPainterPath RiveQtPath::toQPainterPath() const
 {
-    return m_path;
+    if (!m_qPainterPathDirty) {
+        return m_qPainterPath;
+    }
+
+    QPainterPath path;
+    path.setFillRule(RiveQtUtils::convert(m_fillRule));
+    path.reserve(m_points.size());
+
+    const QVector2D *points = m_points.constData();
+    for (const rive::PathVerb verb : m_verbs) {
+        switch (verb) {
+        case rive::PathVerb::move:
+            path.moveTo(points[0].toPointF());
+            points += 1;
+            break;
+        case rive::PathVerb::line:
+            path.lineTo(points[0].toPointF());
+            points += 1;
+            break;
+        case rive::PathVerb::cubic:
+            path.cubicTo(points[0].toPointF(), points[1].toPointF(), points[2].toPointF());
+            points += 3;
+            break;
+        case rive::PathVerb::close:
+            path.closeSubpath();
+            break;
+        default:
+            break;
+        }
+    }
+
+    m_qPainterPath = path;
+    m_qPainterPathDirty = false;
+    return m_qPainterPath;
 }
 
-QVector<QVector<QVector2D>> RiveQtPath::toVerticesLine(const QPen &pen)
+bool RiveQtPath::isAxisAlignedRect(const QMatrix4x4 &transform, QRectF &rect) const
 {
-    if (!m_pathSegmentOutlineDataDirty) {
-        return m_pathOutlineVertices;
+    // a single contour of straight lines, a line back to the start is allowed in place of close
+    if (m_verbs.size() < 4 || m_verbs.size() > 6 || m_verbs.first() != rive::PathVerb::move) {
+        return false;
+    }
+
+    constexpr qreal epsilon = 1e-4;
+
+    QVector<QPointF> corners;
+    corners.reserve(5);
+    for (int i = 0; i < m_verbs.size(); ++i) {
+        const rive::PathVerb verb = m_verbs[i];
+        if (verb == rive::PathVerb::close && i == m_verbs.size() - 1) {
+            break;
+        }
+        if ((verb != rive::PathVerb::line && i > 0) || corners.size() == 5) {
+            return false;
+        }
+        corners.append(transform.map(m_points[i].toPointF()));
     }
 
-#if !defined(USE_QPAINTERPATH_STROKER)
-    updatePathSegmentsOutlineData();
-    m_pathOutlineVertices.clear();
-    // Early exit, nothing to do.
-    if (m_pathSegmentsOutlineData.isEmpty()) {
-        return m_pathOutlineVertices;
+    if (corners.size() == 5) {
+        if ((corners.first() - corners.last()).manhattanLength() >= epsilon) {
+            return false;
+        }
+        corners.removeLast();
     }
-#endif
 
-    updatePathOutlineVertices(pen);
-    m_pathSegmentOutlineDataDirty = false;
+    if (corners.size() != 4) {
+        return false;
+    }
+
+    // every edge has to be horizontal or vertical, alternating, otherwise it could be a bow tie
+    bool previousHorizontal = false;
+    for (int i = 0; i < 4; ++i) {
+        const QPointF &from = corners[i];
+        const QPointF &to = corners[(i + 1) % 4];
+        const bool horizontal = qAbs(from.y() - to.y()) < epsilon;
+        const bool vertical = qAbs(from.x() - to.x()) < epsilon;
+        if (horizontal == vertical || (i > 0 && horizontal == previousHorizontal)) {
+            return false;
+        }
+        previousHorizontal = horizontal;
+    }
 
-    return m_pathOutlineVertices;
+    rect = QRectF(corners[0], corners[2]).normalized();
+    return true;
 }
 
-#if !defined(USE_QPAINTERPATH_STROKER)
-std::optional<QVector2D> calculateIntersection(const QVector2D &p1, const QVector2D &p2, const QVector2D &p3, const QVector2D &p4)
+RiveQtPathGeometry RiveQtPath::stencilFanGeometry()
 {
-    const float x1 = p1.x(), y1 = p1.y();
-    const float x2 = p2.x(), y2 = p2.y();
-    const float x3 = p3.x(), y3 = p3.y();
-    const float x4 = p4.x(), y4 = p4.y();
-
-    float denominator = (x1 - x2) * (y3 - y4) - (y1 - y2) * (x3 - x4);
-
-    // If the lines are parallel or coincident, return an invalid point
-    if (abs(denominator) < 0.01f) {
-        return {};
+    if (m_stencilFillDataDirty) {
+        updateStencilFillData();
     }
+    return m_stencilFanGeometry;
+}
 
-    const float factor1 = (x1 * y2 - y1 * x2);
-    const float factor2 = (x3 * y4 - y3 * x4);
+RiveQtPathGeometry RiveQtPath::coverGeometry()
+{
+    if (m_stencilFillDataDirty) {
+        updateStencilFillData();
+    }
+    return m_coverGeometry;
+}
 
-    const float intersectX = (factor1 * (x3 - x4) - (x1 - x2) * factor2) / denominator;
-    const float intersectY = (factor1 * (y3 - y4) - (y1 - y2) * factor2) / denominator;
-    return QVector2D(intersectX, intersectY);
+RiveQtCurveWedges RiveQtPath::curveWedges()
+{
+    if (m_curveWedgesDirty) {
+        updateCurveWedges();
+        m_curveWedges.version = nextGeometryVersion();
+        m_curveWedges.coverGeometry.version = nextGeometryVersion();
+    }
+    return m_curveWedges;
 }
 
-QPointF RiveQtPath::cubicBezier(const QPointF &startPoint, const QPointF &controlPoint1, const QPointF &controlPoint2,
-                                const QPointF &endPoint, qreal t)
+RiveQtPathGeometry RiveQtPath::strokeGeometry(const QPen &pen, RiveRenderSettings::StrokeMode strokeMode)
 {
-    qreal oneMinusT = 1 - t;
-    qreal oneMinusTSquared = oneMinusT * oneMinusT;
-    qreal oneMinusTCubed = oneMinusTSquared * oneMinusT;
-    qreal tSquared = t * t;
-    qreal tCubed = tSquared * t;
+    if (!m_pathSegmentOutlineDataDirty && pen == m_strokePen && strokeMode == m_strokeMode) {
+        return m_strokeGeometry;
+    }
+
+    m_strokeGeometry = {};
+
+    if (strokeMode == RiveRenderSettings::NativeStroking) {
+        updateNativeStrokeGeometry(pen);
+    } else {
+        updateQtStrokeGeometry(pen);
+    }
 
-    QPointF point = oneMinusTCubed * startPoint + 3 * oneMinusTSquared * t * controlPoint1 + 3 * oneMinusT * tSquared * controlPoint2
-        + tCubed * endPoint;
-    return point;
+    m_strokeGeometry.version = nextGeometryVersion();
+    m_strokePen = pen;
+    m_strokeMode = strokeMode;
+    m_pathSegmentOutlineDataDirty = false;
+
+    return m_strokeGeometry;
 }
 
-QVector2D cubicBezierTangent(const QPointF &p0, const QPointF &p1, const QPointF &p2, const QPointF &p3, const float t)
+void RiveQtPath::updateQtStrokeGeometry(const QPen &pen)
 {
-    const auto r = 3.f * (1.f - t) * (1.f - t) * (p1 - p0) + 6.f * (1.f - t) * t * (p2 - p1) + 3.f * t * t * (p3 - p2);
-    return QVector2D(r.x(), r.y()).normalized();
+    QPainterPathStroker painterPathStroker(pen);
+    painterPathStroker.setCurveThreshold(0.1);
+    QPainterPath strokedPath = painterPathStroker.createStroke(toQPainterPath());
+    m_strokeGeometry = toPathGeometry(qTriangulate(strokedPath, QTransform(), static_cast<qreal>(m_renderQuality)));
 }
 
-void RiveQtPath::updatePathSegmentsOutlineData()
+void RiveQtPath::updateNativeStrokeGeometry(const QPen &pen)
 {
-    m_pathSegmentsOutlineData.clear();
-
-    if (m_path.isEmpty()) {
-        m_pathSegmentOutlineDataDirty = false;
+    const float halfWidth = static_cast<float>(pen.widthF()) / 2.0f;
+    if (halfWidth <= 0.0f || m_verbs.isEmpty()) {
         return;
     }
 
-    QVector<PathDataPoint> pathDataEnhanced;
-    pathDataEnhanced.reserve(m_path.elementCount());
+    QVector<QVector2D> points;
+    QVector<Contour> contours;
+    flattenForStroking(points, contours);
 
-    const QPointF &point = m_path.elementAt(0);
-    const QVector2D &centerPoint = QVector2D(point.x(), point.y());
-    int currentStepIndex { 0 };
+    NativeStroker stroker(halfWidth, flatteningTolerance(), static_cast<float>(pen.miterLimit()), pen.joinStyle(), pen.capStyle());
 
-    // Add the current point
-    pathDataEnhanced.append({ centerPoint, QVector2D(), currentStepIndex });
+    QVector<QVector2D> directions;
 
-    for (int i = 1; i < m_path.elementCount(); ++i) {
-        QPainterPath::Element element = m_path.elementAt(i);
+    for (const Contour &contour : qAsConst(contours)) {
+        const QVector2D *contourPoints = points.constData() + contour.start;
+        const int pointCount = contour.count;
 
-        switch (element.type) {
-        case QPainterPath::MoveToElement:
-            if (pathDataEnhanced.size() > 1)
-                m_pathSegmentsOutlineData.append(pathDataEnhanced);
-            pathDataEnhanced.clear();
-            currentStepIndex = 0;
-            pathDataEnhanced.append({ QVector2D(element.x, element.y), QVector2D(), currentStepIndex });
-            ++currentStepIndex;
-            break;
+        // a zero length subpath only shows its caps, like QPainterPathStroker does it
+        if (pointCount == 1) {
+            if (!contour.closed) {
+                stroker.addCap(contourPoints[0], QVector2D(1.0f, 0.0f));
+                stroker.addCap(contourPoints[0], QVector2D(-1.0f, 0.0f));
+            }
+            continue;
+        }
 
-        case QPainterPath::LineToElement:
-            pathDataEnhanced.append({ QVector2D(element.x, element.y), QVector2D(), currentStepIndex });
-            ++currentStepIndex;
-            break;
+        const int segmentCount = contour.closed ? pointCount : pointCount - 1;
 
-        case QPainterPath::CurveToElement: {
-            const QPointF &startPoint = pathDataEnhanced.last().point.toPointF();
-            const QPointF &controlPoint1 = element;
-            const QPointF &controlPoint2 = m_path.elementAt(i + 1);
-            const QPointF &endPoint = m_path.elementAt(i + 2);
-
-            pathDataEnhanced.last().tangent = cubicBezierTangent(startPoint, controlPoint1, controlPoint2, endPoint, 0.f);
-
-            for (int j = 1; j <= m_segmentCount; ++j) {
-                const qreal t = static_cast<qreal>(j) / m_segmentCount;
-                const QPointF &point = cubicBezier(startPoint, controlPoint1, controlPoint2, endPoint, t);
-                //                pathData.append(QVector2D(point.x(), point.y()));
-                pathDataEnhanced.append({ QVector2D(point.x(), point.y()),
-                                          cubicBezierTangent(startPoint, controlPoint1, controlPoint2, endPoint, t), currentStepIndex });
-            }
+        directions.resize(segmentCount);
+        stroker.addSegments(contourPoints, pointCount - 1, directions.data());
+        if (contour.closed) {
+            const QVector2D closingSegment[] = { contourPoints[pointCount - 1], contourPoints[0] };
+            stroker.addSegments(closingSegment, 1, directions.data() + pointCount - 1);
+        }
 
-            i += 2; // Skip the next two control points, as we already processed them.
-            ++currentStepIndex;
-            break;
+        for (int i = 1; i < segmentCount; ++i) {
+            stroker.addJoin(contourPoints[i], directions.at(i - 1), directions.at(i));
         }
-        default:
-            break;
+        if (contour.closed) {
+            stroker.addJoin(contourPoints[0], directions.last(), directions.first());
+        }
+
+        if (!contour.closed) {
+            stroker.addCap(contourPoints[0], -directions.first());
+            stroker.addCap(contourPoints[pointCount - 1], directions.last());
         }
     }
 
-    m_pathSegmentsOutlineData.append(pathDataEnhanced);
-    m_pathSegmentOutlineDataDirty = false;
+    m_strokeGeometry.vertices = stroker.vertices;
+    setGeometryIndices(m_strokeGeometry, stroker.indices.constData(), stroker.indices.size());
+    m_strokeGeometry.overlappingTriangles = true;
 }
-#endif
 
-void RiveQtPath::updatePathOutlineVertices(const QPen &pen)
+RiveQtStrokeCenterline RiveQtPath::strokeCenterline()
 {
+    if (m_strokeCenterlineDirty) {
+        updateStrokeCenterline();
+    }
+    return m_strokeCenterline;
+}
 
-#if defined(USE_QPAINTERPATH_STROKER)
-    m_pathOutlineVertices.clear();
-    QPainterPathStroker painterPathStroker(pen);
-    painterPathStroker.setCurveThreshold(0.1);
-    QPainterPath strokedPath = painterPathStroker.createStroke(m_path);
-    QTriangleSet triangles = qTriangulate(strokedPath, QTransform(), static_cast<qreal>(m_renderQuality));
-
-    QVector<QVector2D> pathData;
-    pathData.reserve(triangles.indices.size());
-    int index;
-    for (int i = 0; i < triangles.indices.size(); i++) {
-        if (triangles.indices.type() == QVertexIndexVector::UnsignedInt) {
-            index = static_cast<const quint32 *>(triangles.indices.data())[i];
-        } else {
-            index = static_cast<const quint16 *>(triangles.indices.data())[i];
-        }
+RiveQtStrokeCenterline RiveQtPath::fillOutline()
+{
+    if (m_fillOutlineDirty) {
+        m_fillOutline = buildCenterline(true);
+        m_fillOutline.version = nextGeometryVersion();
+        m_fillOutlineDirty = false;
+    }
+    return m_fillOutline;
+}
 
-        const qreal x = triangles.vertices[2 * index];
-        const qreal y = triangles.vertices[2 * index + 1];
+void RiveQtPath::updateStrokeCenterline()
+{
+    m_strokeCenterline = buildCenterline(false);
+    m_strokeCenterline.version = nextGeometryVersion();
+    m_strokeCenterlineDirty = false;
+}
 
-        pathData.append(QVector2D(x, y));
+RiveQtStrokeCenterline RiveQtPath::buildCenterline(bool closeContours) const
+{
+    RiveQtStrokeCenterline centerline;
+
+    if (m_verbs.isEmpty()) {
+        return centerline;
     }
 
-    m_pathOutlineVertices.append(pathData);
-#else
+    QVector<QVector2D> points;
+    QVector<Contour> contours;
+    flattenForStroking(points, contours);
 
-    const qreal lineWidth = pen.widthF();
-    const Qt::PenJoinStyle &joinType = pen.joinStyle();
-    const Qt::PenCapStyle &capStyle = pen.capStyle();
+    // the same pieces the native stroker emits, but only their defining points
+    QVector<RiveQtStrokeInstance> segments;
+    QVector<RiveQtStrokeInstance> joins;
+    QVector<RiveQtStrokeInstance> caps;
+    segments.reserve(points.size());
+    joins.reserve(points.size());
 
-    for (const auto &pathData : qAsConst(m_pathSegmentsOutlineData)) {
-        if (pathData.size() <= 1) {
-            continue;
-        }
-
-        QVector<QVector2D> lineDataSegment;
+    for (Contour contour : qAsConst(contours)) {
+        const QVector2D *contourPoints = points.constData() + contour.start;
 
-        bool closed = false;
+        // a fill closes every contour implicitly, an explicit closing point would give an empty segment
+        if (closeContours && !contour.closed) {
+            if (contour.count > 1 && contourPoints[0] == contourPoints[contour.count - 1]) {
+                --contour.count;
+            }
+            contour.closed = true;
+        }
+        const int pointCount = contour.count;
 
-        if (pathData.first().point == pathData.last().point) {
-            closed = true;
+        if (pointCount == 1) {
+            if (!contour.closed) {
+                caps.append({ QVector2D(1.0f, 0.0f), contourPoints[0], {}, RiveQtStrokeInstance::Cap });
+                caps.append({ QVector2D(-1.0f, 0.0f), contourPoints[0], {}, RiveQtStrokeInstance::Cap });
+            }
+            continue;
         }
 
-        const int endIndex = closed ? pathData.count() : pathData.count() - 1;
+        const int segmentCount = contour.closed ? pointCount : pointCount - 1;
 
-        for (int i = 0; i < endIndex; ++i) {
-            int nextI = (i + 1) % (pathData.count());
-            const QVector2D &p1 = pathData[i].point;
-            const QVector2D &p2 = pathData[nextI].point; // if endIndex, take 0
-            const auto &t1 = pathData[i].tangent;
-            const auto &t2 = pathData[nextI].tangent;
+        QVector2D firstDirection;
+        QVector2D previousDirection;
+        for (int i = 0; i < segmentCount; ++i) {
+            const QVector2D &from = contourPoints[i];
+            const QVector2D &to = contourPoints[(i + 1) % pointCount];
+            const QVector2D direction = (to - from).normalized();
 
-            QVector2D normal, normal2;
-            const QVector2D diff = p2 - p1;
+            segments.append({ from, to, {}, RiveQtStrokeInstance::Segment });
 
-            if (pathData.at(i).tangent.isNull()) {
-                normal = QVector2D(-diff.y(), diff.x()).normalized();
+            if (i > 0) {
+                joins.append({ previousDirection, from, direction, RiveQtStrokeInstance::Join });
             } else {
-                normal = QVector2D(-pathData.at(i).tangent.y(), pathData.at(i).tangent.x()).normalized();
+                firstDirection = direction;
             }
-            if (pathData.at(nextI).tangent.isNull()) {
-                normal2 = normal;
-            } else {
-                normal2 = QVector2D(-pathData.at(nextI).tangent.y(), pathData.at(nextI).tangent.x()).normalized();
-            }
-            const QVector2D offset = normal * (lineWidth / 2.0);
-            const QVector2D offset2 = normal2 * (lineWidth / 2.0);
-
-            // add the line segment
-            lineDataSegment.append(p1 + offset);
-            lineDataSegment.append(p1 - offset);
-            lineDataSegment.append(p2 + offset2);
-
-            lineDataSegment.append(p2 + offset2);
-            lineDataSegment.append(p2 - offset2);
-            lineDataSegment.append(p1 - offset);
-
-            if (!closed && (i == 0 || i == endIndex - 1)) {
-                switch (capStyle) {
-                case Qt::PenCapStyle::FlatCap:
-                    // No additional vertices needed for FlatCap
-                    break;
-                case Qt::PenCapStyle::RoundCap: {
-                    int numSegments = m_segmentCount;
-
-                    float phi = i == 0 ? M_PI / numSegments : -M_PI / numSegments;
-
-                    const float cPhi = cos(phi);
-                    const float sPhi = sin(phi);
-                    float rotation[4] = { cPhi, -sPhi, sPhi, cPhi };
-
-                    QVector<QVector2D> capVertices;
-                    capVertices.reserve(3 * numSegments);
-
-                    QVector2D currentOffset = i == 0 ? offset : offset2;
-                    const auto centerPoint = i == 0 ? p1 : p2;
-
-                    for (int i = 0; i < numSegments; ++i) {
-                        capVertices.append(centerPoint + currentOffset);
-                        capVertices.append(centerPoint);
-                        const auto tmp = rotation[0] * currentOffset[0] + rotation[1] * currentOffset[1];
-                        currentOffset[1] = rotation[2] * currentOffset[0] + rotation[3] * currentOffset[1];
-                        currentOffset[0] = tmp;
-                        capVertices.append(centerPoint + currentOffset);
-                    }
-
-                    lineDataSegment = i == 0 ? capVertices + lineDataSegment : lineDataSegment + capVertices;
-                    break;
-                }
-                case Qt::PenCapStyle::SquareCap: {
-                    if (lineDataSegment.size() < 6)
-                        break;
-
-                    const auto direction = i == 0 ? pathData.at(i).tangent : pathData.at(nextI).tangent;
-
-                    if (i == 0) {
-                        lineDataSegment[0] -= direction * lineWidth / 2.0;
-                        lineDataSegment[1] -= direction * lineWidth / 2.0;
-                        lineDataSegment[5] -= direction * lineWidth / 2.0;
-                    } else { // is last element
-                        const auto end = lineDataSegment.size();
-                        lineDataSegment[end - 2] += direction * lineWidth / 2.0;
-                        lineDataSegment[end - 3] += direction * lineWidth / 2.0;
-                        lineDataSegment[end - 4] += direction * lineWidth / 2.0;
-                    }
-                    break;
-                }
-                default:
-                    // No additional vertices needed for other cap styles
-                    break;
-                }
-            }
-            if (i < endIndex - 1) {
-                auto p3 = pathData[(i + 2) % pathData.count()].point;
-                auto t3 = pathData[(i + 2) % pathData.count()].tangent;
-                bool needsJoin = pathData[nextI].stepIndex != pathData[(i + 2) % pathData.count()].stepIndex;
-
-                if (closed && (i + 2) == pathData.count()) {
-                    p3 = pathData[(i + 3) % pathData.count()].point;
-                    t3 = pathData[(i + 3) % pathData.count()].tangent;
-                    needsJoin = pathData[nextI].stepIndex != pathData[(i + 3) % pathData.count()].stepIndex;
-                }
-
-                if (!needsJoin)
-                    continue;
+            previousDirection = direction;
+        }
 
-                const auto &diff2 = p3 - p2;
-                const auto &normal2 = QVector2D(-diff2.y(), diff2.x()).normalized();
-                const auto &offset2 = normal2 * lineWidth / 2.0;
-                const bool turnLeft = normal.x() * normal2.y() - normal.y() * normal2.x() > 0;
+        if (contour.closed) {
+            joins.append({ previousDirection, contourPoints[0], firstDirection, RiveQtStrokeInstance::Join });
+        } else {
+            caps.append({ -firstDirection, contourPoints[0], {}, RiveQtStrokeInstance::Cap });
+            caps.append({ previousDirection, contourPoints[pointCount - 1], {}, RiveQtStrokeInstance::Cap });
+        }
+    }
 
-                switch (joinType) {
-                default:
-                    // this should never be the case, since we handle all rive types.
-                    qCDebug(rqqpRendering) << "Unhandled path join type. Using rounded join. Type:" << joinType;
-                    Q_FALLTHROUGH();
-                case Qt::PenJoinStyle::RoundJoin: {
-                    auto phi = acos(normal.x() * normal2.x() + normal.y() * normal2.y()) / m_segmentCount;
+    centerline.segmentCount = segments.size();
+    centerline.joinCount = joins.size();
+    centerline.capCount = caps.size();
+    centerline.instances = segments + joins + caps;
+    return centerline;
+}
 
-                    phi = turnLeft ? phi : -phi;
-                    QVector2D currentOffset = turnLeft ? -offset : offset;
+void RiveQtPath::updateCurveWedges()
+{
+    m_curveWedges = {};
+    m_curveWedgesDirty = false;
 
-                    const float cPhi = cos(phi);
-                    const float sPhi = sin(phi);
-                    const float rotation[4] = { cPhi, -sPhi, sPhi, cPhi };
+    if (m_points.isEmpty()) {
+        return;
+    }
 
-                    QVector<QVector2D> capVertices;
-                    capVertices.reserve(3 * m_segmentCount);
+    QVector<RiveQtCurveWedge> lines;
+    QVector<RiveQtCurveWedge> cubics;
+
+    const QVector2D *pathPoints = m_points.constData();
+    QVector2D contourStart = pathPoints[0];
+    QVector2D current = contourStart;
+
+    float minX = contourStart.x();
+    float minY = contourStart.y();
+    float maxX = minX;
+    float maxY = minY;
+    const auto extendBounds = [&](const QVector2D &point) {
+        minX = qMin(minX, point.x());
+        minY = qMin(minY, point.y());
+        maxX = qMax(maxX, point.x());
+        maxY = qMax(maxY, point.y());
+    };
+
+    // the closing segment of a contour ends in the anchor, its wedge is empty and left out
+    for (const rive::PathVerb verb : qAsConst(m_verbs)) {
+        switch (verb) {
+        case rive::PathVerb::move:
+            contourStart = pathPoints[0];
+            current = contourStart;
+            extendBounds(current);
+            pathPoints += 1;
+            break;
+        case rive::PathVerb::line:
+            lines.append({ contourStart, current, current, pathPoints[0], pathPoints[0], {} });
+            current = pathPoints[0];
+            extendBounds(current);
+            pathPoints += 1;
+            break;
+        case rive::PathVerb::cubic:
+            cubics.append({ contourStart, current, pathPoints[0], pathPoints[1], pathPoints[2], {} });
+            extendBounds(pathPoints[0]);
+            extendBounds(pathPoints[1]);
+            extendBounds(pathPoints[2]);
+            current = pathPoints[2];
+            pathPoints += 3;
+            break;
+        case rive::PathVerb::close:
+            // drawing after a close continues at the start of the last subpath
+            current = contourStart;
+            break;
+        default:
+            break;
+        }
+    }
 
-                    const auto centerPoint = p2;
+    if (lines.isEmpty() && cubics.isEmpty()) {
+        return;
+    }
 
-                    for (int i = 0; i < m_segmentCount; ++i) {
-                        capVertices.append(centerPoint + currentOffset);
-                        capVertices.append(centerPoint);
+    m_curveWedges.lineCount = lines.size();
+    m_curveWedges.cubicCount = cubics.size();
+    m_curveWedges.wedges = lines + cubics;
+    m_curveWedges.coverGeometry = coverQuad(minX, minY, maxX, maxY);
+}
 
-                        const auto tmp = rotation[0] * currentOffset[0] + rotation[1] * currentOffset[1];
-                        currentOffset[1] = rotation[2] * currentOffset[0] + rotation[3] * currentOffset[1];
-                        currentOffset[0] = tmp;
+void RiveQtPath::addRawPathImpl(const rive::RawPath &path)
+{
+    m_verbs.reserve(m_verbs.size() + static_cast<int>(path.verbs().size()));
+    m_points.reserve(m_points.size() + static_cast<int>(path.points().size()));
 
-                        capVertices.append(centerPoint + currentOffset);
-                    }
+    for (const auto &[verb, pts] : path) {
+        switch (verb) {
+        case rive::PathVerb::move:
+            m_verbs.append(rive::PathVerb::move);
+            m_points.append(QVector2D(pts[0].x, pts[0].y));
+            break;
+        case rive::PathVerb::line:
+            m_verbs.append(rive::PathVerb::line);
+            m_points.append(QVector2D(pts[1].x, pts[1].y));
+            break;
+        case rive::PathVerb::quad: {
+            // we only store cubics, elevate the quad
+            const QVector2D start(pts[0].x, pts[0].y);
+            const QVector2D control(pts[1].x, pts[1].y);
+            const QVector2D end(pts[2].x, pts[2].y);
+            m_verbs.append(rive::PathVerb::cubic);
+            m_points.append(start + (control - start) * (2.0f / 3.0f));
+            m_points.append(end + (control - end) * (2.0f / 3.0f));
+            m_points.append(end);
+            break;
+        }
+        case rive::PathVerb::cubic:
+            m_verbs.append(rive::PathVerb::cubic);
+            m_points.append(QVector2D(pts[1].x, pts[1].y));
+            m_points.append(QVector2D(pts[2].x, pts[2].y));
+            m_points.append(QVector2D(pts[3].x, pts[3].y));
+            break;
+        case rive::PathVerb::close:
+            m_verbs.append(rive::PathVerb::close);
+            break;
+        }
+    }
+}
 
-                    lineDataSegment = lineDataSegment + capVertices;
+float RiveQtPath::flatteningTolerance() const
+{
+    // matches the flattening precision qTriangulate used with the render quality as lossy scaling
+    return 0.5f / static_cast<float>(m_renderQuality);
+}
 
-                    break;
-                }
-                case Qt::PenJoinStyle::MiterJoin: {
-                    if (!offset.isNull() && !offset2.isNull()) {
-                        if (turnLeft) {
-                            // calculate the intersection of the offset from p1 and p2
-                            if (const auto pM = calculateIntersection(p1 - offset, p2 - offset, p3 - offset2, p2 - offset2);
-                                pM.has_value()) {
-                                lineDataSegment.append(p1 - offset);
-                                lineDataSegment.append(pM.value());
-                                lineDataSegment.append(p2 - offset2);
-                            }
-                        } else {
-                            if (const auto pM = calculateIntersection(p1 + offset, p2 + offset, p3 + offset2, p2 + offset2);
-                                pM.has_value()) {
-                                lineDataSegment.append(p1 + offset);
-                                lineDataSegment.append(pM.value());
-                                lineDataSegment.append(p2 + offset2);
-                            }
-                        }
-                    }
-                    Q_FALLTHROUGH();
-                }
-                case Qt::PenJoinStyle::BevelJoin:
-                    if (turnLeft) {
-                        lineDataSegment.append(p1 - offset);
-                        lineDataSegment.append(p2);
-                        lineDataSegment.append(p2 - offset2);
-                    } else {
-                        lineDataSegment.append(p1 + offset);
-                        lineDataSegment.append(p2);
-                        lineDataSegment.append(p2 + offset2);
-                    }
-                    break;
-                }
+void RiveQtPath::flattenForStroking(QVector<QVector2D> &points, QVector<Contour> &contours) const
+{
+    QVector<QVector2D> flattenedPoints;
+    QVector<Contour> flattenedContours;
+    flatten(flatteningTolerance(), flattenedPoints, flattenedContours);
+
+    points.clear();
+    contours.clear();
+    points.reserve(flattenedPoints.size());
+
+    for (const Contour &flattenedContour : qAsConst(flattenedContours)) {
+        Contour contour { static_cast<int>(points.size()), 0, flattenedContour.closed };
+
+        // repeated points have no direction, drop them
+        for (int i = 0; i < flattenedContour.count; ++i) {
+            const QVector2D &point = flattenedPoints.at(flattenedContour.start + i);
+            if (contour.count == 0 || (point - points.last()).lengthSquared() > 1e-12f) {
+                points.append(point);
+                ++contour.count;
             }
         }
 
-        m_pathOutlineVertices.append(lineDataSegment);
+        if (contour.closed && contour.count > 1 && (points.at(contour.start) - points.last()).lengthSquared() <= 1e-12f) {
+            points.removeLast();
+            --contour.count;
+        }
+
+        if (contour.count > 0) {
+            contours.append(contour);
+        }
     }
-#endif
 }
 
-void RiveQtPath::addRawPathImpl(const rive::RawPath &path)
+void RiveQtPath::flatten(float tolerance, QVector<QVector2D> &points, QVector<Contour> &contours) const
 {
-    for (const auto &[verb, pts] : path) {
+    points.clear();
+    contours.clear();
+    points.reserve(m_points.size());
+
+    const QVector2D *pathPoints = m_points.constData();
+    QVector2D contourStart;
+
+    // drawing after a close (or without a move) continues at the start of the last subpath
+    const auto ensureContour = [&]() {
+        if (contours.isEmpty() || contours.last().closed) {
+            contours.append({ static_cast<int>(points.size()), 1, false });
+            points.append(contourStart);
+        }
+    };
+
+    for (const rive::PathVerb verb : m_verbs) {
         switch (verb) {
         case rive::PathVerb::move:
-            m_path.moveTo(pts[0].x, pts[0].y);
+            contourStart = pathPoints[0];
+            contours.append({ static_cast<int>(points.size()), 1, false });
+            points.append(contourStart);
+            pathPoints += 1;
             break;
         case rive::PathVerb::line:
-            m_path.lineTo(pts[1].x, pts[1].y);
-            break;
-        case rive::PathVerb::quad:
-            m_path.quadTo(pts[1].x, pts[1].y, pts[2].x, pts[2].y);
+            ensureContour();
+            points.append(pathPoints[0]);
+            ++contours.last().count;
+            pathPoints += 1;
             break;
-        case rive::PathVerb::cubic:
-            m_path.cubicTo(pts[1].x, pts[1].y, pts[2].x, pts[2].y, pts[3].x, pts[3].y);
+        case rive::PathVerb::cubic: {
+            ensureContour();
+            const QVector2D p0 = points.last();
+            const QVector2D &p1 = pathPoints[0];
+            const QVector2D &p2 = pathPoints[1];
+            const QVector2D &p3 = pathPoints[2];
+
+            const int segments = cubicSegmentCount(p0, p1, p2, p3, tolerance);
+            const int first = points.size();
+            points.resize(first + segments);
+            RiveQtPathKernels::flattenCubic(p0, p1, p2, p3, segments, points.data() + first);
+            contours.last().count += segments;
+            pathPoints += 3;
             break;
+        }
         case rive::PathVerb::close:
-            // why was this done?
-            // m_path.lineTo(pts->x, pts->y);
-            m_path.closeSubpath();
+            if (!contours.isEmpty() && !contours.last().closed) {
+                Contour &contour = contours.last();
+                // the closing point is implicit
+                if (contour.count > 1 && points.last() == points.at(contour.start)) {
+                    points.removeLast();
+                    --contour.count;
+                }
+                contour.closed = true;
+            }
+            break;
+        default:
             break;
         }
     }
@@ -546,31 +990,105 @@ void RiveQtPath::addRawPathImpl(const rive::RawPath &path)
 
 void RiveQtPath::updatePathSegmentsData()
 {
-    m_pathVertices.clear();
+    m_fillGeometry = {};
+    m_pathSegmentDataDirty = false;
 
-    if (m_path.isEmpty()) {
-        m_pathSegmentDataDirty = false;
+    QVector<QVector2D> points;
+    QVector<Contour> contours;
+    flatten(flatteningTolerance(), points, contours);
+
+    // hand the polygons directly to the triangulator, there is no need for a QPainterPath here
+    QVector<qreal> coordinates;
+    QVector<QPainterPath::ElementType> elements;
+    coordinates.reserve(points.size() * 2);
+    elements.reserve(points.size());
+
+    for (const Contour &contour : qAsConst(contours)) {
+        if (contour.count < 3) {
+            continue;
+        }
+
+        for (int i = 0; i < contour.count; ++i) {
+            const QVector2D &point = points.at(contour.start + i);
+            coordinates.append(point.x());
+            coordinates.append(point.y());
+            elements.append(i == 0 ? QPainterPath::MoveToElement : QPainterPath::LineToElement);
+        }
+    }
+
+    if (elements.isEmpty()) {
         return;
     }
 
-    QTriangleSet triangles = qTriangulate(m_path, QTransform(), m_renderQuality);
+    const uint hints = QVectorPath::PolygonHint | (m_fillRule == rive::FillRule::evenOdd ? QVectorPath::OddEvenFill : QVectorPath::WindingFill);
+    const QVectorPath vectorPath(coordinates.constData(), elements.size(), elements.constData(), hints);
+    m_fillGeometry = toPathGeometry(qTriangulate(vectorPath, QTransform(), m_renderQuality));
+}
 
-    QVector<QVector2D> pathData;
-    pathData.reserve(triangles.indices.size());
-    int index;
-    for (int i = 0; i < triangles.indices.size(); i++) {
-        if (triangles.indices.type() == QVertexIndexVector::UnsignedInt) {
-            index = static_cast<const quint32 *>(triangles.indices.data())[i];
+void RiveQtPath::updateStencilFillData()
+{
+    m_stencilFanGeometry = {};
+    m_coverGeometry = {};
+    m_stencilFillDataDirty = false;
+
+    QVector<QVector2D> points;
+    QVector<Contour> contours;
+    flatten(flatteningTolerance(), points, contours);
+
+    int triangleCount = 0;
+    for (const Contour &contour : qAsConst(contours)) {
+        triangleCount += qMax(0, contour.count - 2);
+    }
+
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // the fan is anchored at the first point of each contour, overlapping and inverted triangles are fine
+    // since the winding is resolved by the stencil operations and not here
+    m_stencilFanGeometry.vertices = points;
+    m_stencilFanGeometry.uses32BitIndices = points.size() > std::numeric_limits<quint16>::max();
+
+    const int indexSize = m_stencilFanGeometry.uses32BitIndices ? sizeof(quint32) : sizeof(quint16);
+    m_stencilFanGeometry.indices.resize(triangleCount * 3 * indexSize);
+    quint16 *indices16 = reinterpret_cast<quint16 *>(m_stencilFanGeometry.indices.data());
+    quint32 *indices32 = reinterpret_cast<quint32 *>(m_stencilFanGeometry.indices.data());
+
+    int index = 0;
+    const auto appendIndex = [&](int vertex) {
+        if (m_stencilFanGeometry.uses32BitIndices) {
+            indices32[index++] = static_cast<quint32>(vertex);
         } else {
-            index = static_cast<const quint16 *>(triangles.indices.data())[i];
+            indices16[index++] = static_cast<quint16>(vertex);
+        }
+    };
+
+    float minX = points.first().x();
+    float minY = points.first().y();
+    float maxX = minX;
+    float maxY = minY;
+
+    for (const Contour &contour : qAsConst(contours)) {
+        if (contour.count < 3) {
+            continue;
         }
 
-        const qreal x = triangles.vertices[2 * index];
-        const qreal y = triangles.vertices[2 * index + 1];
+        for (int i = 1; i < contour.count - 1; ++i) {
+            appendIndex(contour.start);
+            appendIndex(contour.start + i);
+            appendIndex(contour.start + i + 1);
+        }
 
-        pathData.append(QVector2D(x, y));
+        for (int i = 0; i < contour.count; ++i) {
+            const QVector2D &point = points.at(contour.start + i);
+            minX = qMin(minX, point.x());
+            minY = qMin(minY, point.y());
+            maxX = qMax(maxX, point.x());
+            maxY = qMax(maxY, point.y());
+        }
     }
 
-    m_pathVertices.append(pathData);
-    m_pathSegmentDataDirty = false;
+    m_coverGeometry = coverQuad(minX, minY, maxX, maxY);
+    m_stencilFanGeometry.version = nextGeometryVersion();
+    m_coverGeometry.version = nextGeometryVersion();
 }
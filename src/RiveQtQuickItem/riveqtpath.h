@@ -5,8 +5,6 @@
 
 #pragma once
 
-#define USE_QPAINTERPATH_STROKER
-
 #include <rive/renderer.hpp>
 #include <rive/math/raw_path.hpp>
 
@@ -17,6 +15,91 @@
 
 #include "datatypes.h"
 
+// indexed triangle list as produced by the tessellation of a path
+struct RiveQtPathGeometry
+{
+    QVector<QVector2D> vertices;
+    // 16 bit indices, unless there are too many vertices for them
+    QByteArray indices;
+    bool uses32BitIndices { false };
+    // triangles may overlap each other (e.g. at stroke joins), each pixel must only be drawn once
+    bool overlappingTriangles { false };
+    // increases with every rebuild, unique over all paths, so a node only needs to upload when it changes (0: not tracked)
+    quint64 version { 0 };
+
+    int indexCount() const { return indices.size() / (uses32BitIndices ? sizeof(quint32) : sizeof(quint16)); }
+    bool isEmpty() const { return indices.isEmpty() || vertices.isEmpty(); }
+};
+
+// one instance of the stroke expansion in the vertex shader, read as two vec4
+struct RiveQtStrokeInstance
+{
+    enum Kind
+    {
+        Segment,
+        Join,
+        Cap
+    };
+
+    // segment: start and end point, join: incoming direction and corner, cap: direction away from the stroke and end point
+    QVector2D a;
+    QVector2D b;
+    // join: outgoing direction
+    QVector2D c;
+    float kind { Segment };
+    float padding { 0.0f };
+};
+
+// the flattened centre line of a path, independent of the pen it is stroked with
+struct RiveQtStrokeCenterline
+{
+    // sorted by kind: segments, then joins, then caps
+    QVector<RiveQtStrokeInstance> instances;
+    int segmentCount { 0 };
+    int joinCount { 0 };
+    int capCount { 0 };
+    quint64 version { 0 };
+
+    bool isEmpty() const { return instances.isEmpty(); }
+};
+
+// the triangle fan from the contour start over one path segment, tessellated in the vertex shader
+struct RiveQtCurveWedge
+{
+    QVector2D anchor;
+    // cubic control points, lines put them on their end points
+    QVector2D p0;
+    QVector2D p1;
+    QVector2D p2;
+    QVector2D p3;
+    QVector2D padding;
+};
+
+// the segments of a path as they are, for stencil then cover with the curves tessellated on the GPU
+struct RiveQtCurveWedges
+{
+    // sorted: lines first, then cubics
+    QVector<RiveQtCurveWedge> wedges;
+    int lineCount { 0 };
+    int cubicCount { 0 };
+    // bounds of the control points, which contain the curves
+    RiveQtPathGeometry coverGeometry;
+    quint64 version { 0 };
+
+    bool isEmpty() const { return wedges.isEmpty(); }
+};
+
+// one draw of a path that is drawn several times with the same paint, read as two vec4
+struct RiveQtPathInstance
+{
+    // the 2D transform: x axis, y axis and translation
+    QVector2D xAxis;
+    QVector2D yAxis;
+    QVector2D translation;
+    float opacity { 1.0f };
+    float padding { 0.0f };
+};
+
 class RiveQtPath : public rive::RenderPath
 {
 public:
@@ -35,41 +118,95 @@ public:
 
     void setQPainterPath(const QPainterPath &path);
     bool intersectWith(const QPainterPath &other);
+    // the QPainterPath is only build on request and cached until the path changes
     QPainterPath toQPainterPath() const;
-
-    QVector<QVector<QVector2D>> toVertices();
-    QVector<QVector<QVector2D>> toVerticesLine(const QPen &pen);
+    // true in case the path is a single rectangle that is still axis aligned after the transform, rect gets its bounds
+    bool isAxisAlignedRect(const QMatrix4x4 &transform, QRectF &rect) const;
+
+    RiveQtPathGeometry fillGeometry();
+    RiveQtPathGeometry strokeGeometry(const QPen &pen, RiveRenderSettings::StrokeMode strokeMode = RiveRenderSettings::QtStroking);
+    // the centre line for GpuStroking, only rebuilt when the path changes
+    RiveQtStrokeCenterline strokeCenterline();
+    // the same for the outline of the fill, every contour is closed
+    RiveQtStrokeCenterline fillOutline();
+
+    // stencil then cover: a triangle fan per contour that is only used to count the winding in the
+    // stencil buffer, and a quad covering the bounds that is drawn where the stencil says inside
+    RiveQtPathGeometry stencilFanGeometry();
+    RiveQtPathGeometry coverGeometry();
+    // GpuTessellatedFill: no flattening at all, only rebuilt when the path changes
+    RiveQtCurveWedges curveWedges();
+    bool isEvenOddFill() const { return m_fillRule == rive::FillRule::evenOdd; }
+    // number of path segments, a cheap measure for how costly the triangulation will be
+    int segmentCount() const { return m_verbs.size(); }
 
     void applyMatrix(const QMatrix4x4 &matrix);
 
+    bool isEmpty() const { return m_verbs.isEmpty(); }
+    // bounds of all points including the curve control points, they contain the curves, cached until the path changes
+    QRectF controlPointBounds() const;
+    // changes whenever the path changes, unique over all paths like the geometry versions
+    quint64 contentVersion() const;
+
+    // set by the load time analysis for paths of shapes that nothing animates,
+    // their geometry is uploaded once into immutable buffers
+    void setRetained(bool retained) { m_retained = retained; }
+    bool isRetained() const { return m_retained; }
+
 private:
-#if !defined(USE_QPAINTERPATH_STROKER)
-    struct PathDataPoint
+    // a flattened subpath, start and count index into the flattened point list
+    struct Contour
     {
-        QVector2D point;
-        QVector2D tangent; // only used in cubic bezier
-        int stepIndex;
+        int start { 0 };
+        int count { 0 };
+        bool closed { false };
     };
 
-    static QPointF cubicBezier(const QPointF &startPoint, const QPointF &controlPoint1, const QPointF &controlPoint2,
-                               const QPointF &endPoint, qreal t);
-
-    void updatePathSegmentsOutlineData();
-    unsigned m_segmentCount { 10 };
-    QVector<QVector<PathDataPoint>> m_pathSegmentsOutlineData;
-#endif
-
     void updatePathSegmentsData();
-    void updatePathOutlineVertices(const QPen &pen);
+    void updateStencilFillData();
+    void updateQtStrokeGeometry(const QPen &pen);
+    void updateNativeStrokeGeometry(const QPen &pen);
+    void updateStrokeCenterline();
+    RiveQtStrokeCenterline buildCenterline(bool closeContours) const;
+    void updateCurveWedges();
 
     void addRawPathImpl(const rive::RawPath &path);
-
-    QPainterPath m_path;
-
-    QVector<QVector<QVector2D>> m_pathVertices;
-    QVector<QVector<QVector2D>> m_pathOutlineVertices;
+    void markDirty();
+
+    // flattens all curves with the given tolerance (in path units) into polylines
+    void flatten(float tolerance, QVector<QVector2D> &points, QVector<Contour> &contours) const;
+    float flatteningTolerance() const;
+    // flattens for stroking: repeated points are dropped and closed contours do not repeat their first point
+    void flattenForStroking(QVector<QVector2D> &points, QVector<Contour> &contours) const;
+
+    // flat path storage: one verb per segment, move and line use 1 point, cubic uses 3 points, close none
+    QVector<rive::PathVerb> m_verbs;
+    QVector<QVector2D> m_points;
+    rive::FillRule m_fillRule { rive::FillRule::nonZero };
+
+    mutable QPainterPath m_qPainterPath;
+    mutable bool m_qPainterPathDirty { true };
+    mutable QRectF m_controlPointBounds;
+    mutable bool m_controlPointBoundsDirty { true };
+    mutable quint64 m_contentVersion { 0 };
+
+    RiveQtPathGeometry m_fillGeometry;
+    RiveQtPathGeometry m_strokeGeometry;
+    RiveQtPathGeometry m_stencilFanGeometry;
+    RiveQtPathGeometry m_coverGeometry;
+    RiveQtStrokeCenterline m_strokeCenterline;
+    RiveQtStrokeCenterline m_fillOutline;
+    RiveQtCurveWedges m_curveWedges;
+    // the stroke geometry is only valid for the pen and stroker it was built with
+    QPen m_strokePen;
+    RiveRenderSettings::StrokeMode m_strokeMode { RiveRenderSettings::QtStroking };
 
     bool m_pathSegmentDataDirty { true };
     bool m_pathSegmentOutlineDataDirty { true };
+    bool m_stencilFillDataDirty { true };
+    bool m_strokeCenterlineDirty { true };
+    bool m_fillOutlineDirty { true };
+    bool m_curveWedgesDirty { true };
+    bool m_retained { false };
     RiveRenderSettings::RenderQuality m_renderQuality { RiveRenderSettings::RenderQuality::Medium };
 };
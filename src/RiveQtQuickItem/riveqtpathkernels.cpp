@@ -0,0 +1,546 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "riveqtpathkernels.h"
+#include "rqqplogging.h"
+
+#include <private/qsimd_p.h>
+
+#include <cmath>
+
+#if defined(__SSE2__)
+#    include <immintrin.h>
+#    define RQQP_SSE2
+#    if QT_COMPILER_SUPPORTS(AVX2)
+#        define RQQP_AVX2
+#    endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#    include <arm_neon.h>
+#    define RQQP_NEON
+#endif
+
+// qreal is double unless Qt was configured with another coordinate type
+#if !defined(QT_COORD_TYPE)
+#    define RQQP_QREAL_IS_DOUBLE
+#endif
+
+// all variants evaluate in the same order as the scalar code, the SIMD ones only process several points at once
+// and leave the remainder of each loop to the scalar code
+
+namespace {
+
+using FlattenCubicFunction = void (*)(const QVector2D &, const QVector2D &, const QVector2D &, const QVector2D &, int, QVector2D *);
+using TransformPointsFunction = void (*)(float *, int, const float *);
+using PackVerticesFunction = void (*)(const qreal *, int, float *);
+using NarrowIndicesFunction = void (*)(const quint32 *, int, quint16 *);
+using OffsetSegmentsFunction = void (*)(const float *, int, float, float *, float *);
+
+struct Kernels
+{
+    FlattenCubicFunction flattenCubic;
+    TransformPointsFunction transformPoints;
+    PackVerticesFunction packVertices;
+    NarrowIndicesFunction narrowIndices;
+    OffsetSegmentsFunction offsetSegments;
+    const char *name;
+};
+
+void flattenCubicRemainder(const QVector2D &p0, const QVector2D &p1, const QVector2D &p2, const QVector2D &p3, int first, int segments,
+                           QVector2D *points)
+{
+    for (int i = first; i <= segments; ++i) {
+        const float t = static_cast<float>(i) / segments;
+        const float oneMinusT = 1.0f - t;
+        points[i - 1] = p0 * (oneMinusT * oneMinusT * oneMinusT) + p1 * (3.0f * oneMinusT * oneMinusT * t)
+            + p2 * (3.0f * oneMinusT * t * t) + p3 * (t * t * t);
+    }
+}
+
+void flattenCubicScalar(const QVector2D &p0, const QVector2D &p1, const QVector2D &p2, const QVector2D &p3, int segments,
+                        QVector2D *points)
+{
+    flattenCubicRemainder(p0, p1, p2, p3, 1, segments, points);
+}
+
+// QMatrix4x4 is column major, only the 2D affine part is relevant here
+void transformPointsRemainder(float *points, int first, int count, const float *m)
+{
+    for (int i = first; i < count; ++i) {
+        const float x = points[2 * i];
+        const float y = points[2 * i + 1];
+        points[2 * i] = m[0] * x + m[4] * y + m[12];
+        points[2 * i + 1] = m[1] * x + m[5] * y + m[13];
+    }
+}
+
+void transformPointsScalar(float *points, int count, const float *m)
+{
+    transformPointsRemainder(points, 0, count, m);
+}
+
+void packVerticesRemainder(const qreal *coordinates, int first, int vertexCount, float *vertices)
+{
+    for (int i = 2 * first; i < 2 * vertexCount; ++i) {
+        vertices[i] = static_cast<float>(coordinates[i]);
+    }
+}
+
+void packVerticesScalar(const qreal *coordinates, int vertexCount, float *vertices)
+{
+    packVerticesRemainder(coordinates, 0, vertexCount, vertices);
+}
+
+void narrowIndicesRemainder(const quint32 *indices, int first, int indexCount, quint16 *target)
+{
+    for (int i = first; i < indexCount; ++i) {
+        target[i] = static_cast<quint16>(indices[i]);
+    }
+}
+
+void narrowIndicesScalar(const quint32 *indices, int indexCount, quint16 *target)
+{
+    narrowIndicesRemainder(indices, 0, indexCount, target);
+}
+
+void offsetSegmentsRemainder(const float *points, int first, int segmentCount, float halfWidth, float *directions, float *vertices)
+{
+    for (int i = first; i < segmentCount; ++i) {
+        const float *from = points + 2 * i;
+        const float *to = from + 2;
+        const float dx = to[0] - from[0];
+        const float dy = to[1] - from[1];
+        const float length = std::sqrt(dx * dx + dy * dy);
+        // a zero length segment has no direction
+        const float x = length > 0.0f ? dx / length : 0.0f;
+        const float y = length > 0.0f ? dy / length : 0.0f;
+        directions[2 * i] = x;
+        directions[2 * i + 1] = y;
+
+        const float offsetX = y * -halfWidth;
+        const float offsetY = x * halfWidth;
+        float *quad = vertices + 8 * i;
+        quad[0] = from[0] + offsetX;
+        quad[1] = from[1] + offsetY;
+        quad[2] = from[0] - offsetX;
+        quad[3] = from[1] - offsetY;
+        quad[4] = to[0] + offsetX;
+        quad[5] = to[1] + offsetY;
+        quad[6] = to[0] - offsetX;
+        quad[7] = to[1] - offsetY;
+    }
+}
+
+void offsetSegmentsScalar(const float *points, int segmentCount, float halfWidth, float *directions, float *vertices)
+{
+    offsetSegmentsRemainder(points, 0, segmentCount, halfWidth, directions, vertices);
+}
+
+#if defined(RQQP_SSE2)
+// two points per register, laid out as x0, y0, x1, y1
+void flattenCubicSse2(const QVector2D &p0, const QVector2D &p1, const QVector2D &p2, const QVector2D &p3, int segments,
+                      QVector2D *points)
+{
+    const __m128 c0 = _mm_setr_ps(p0.x(), p0.y(), p0.x(), p0.y());
+    const __m128 c1 = _mm_setr_ps(p1.x(), p1.y(), p1.x(), p1.y());
+    const __m128 c2 = _mm_setr_ps(p2.x(), p2.y(), p2.x(), p2.y());
+    const __m128 c3 = _mm_setr_ps(p3.x(), p3.y(), p3.x(), p3.y());
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 three = _mm_set1_ps(3.0f);
+    float *target = reinterpret_cast<float *>(points);
+
+    int i = 1;
+    for (; i + 1 <= segments; i += 2) {
+        const float t0 = static_cast<float>(i) / segments;
+        const float t1 = static_cast<float>(i + 1) / segments;
+        const __m128 t = _mm_setr_ps(t0, t0, t1, t1);
+        const __m128 s = _mm_sub_ps(one, t);
+
+        const __m128 w0 = _mm_mul_ps(_mm_mul_ps(s, s), s);
+        const __m128 w1 = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(three, s), s), t);
+        const __m128 w2 = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(three, s), t), t);
+        const __m128 w3 = _mm_mul_ps(_mm_mul_ps(t, t), t);
+
+        __m128 result = _mm_add_ps(_mm_mul_ps(c0, w0), _mm_mul_ps(c1, w1));
+        result = _mm_add_ps(result, _mm_mul_ps(c2, w2));
+        result = _mm_add_ps(result, _mm_mul_ps(c3, w3));
+        _mm_storeu_ps(target + 2 * (i - 1), result);
+    }
+
+    flattenCubicRemainder(p0, p1, p2, p3, i, segments, points);
+}
+
+void transformPointsSse2(float *points, int count, const float *m)
+{
+    const __m128 m0 = _mm_setr_ps(m[0], m[1], m[0], m[1]);
+    const __m128 m1 = _mm_setr_ps(m[4], m[5], m[4], m[5]);
+    const __m128 m2 = _mm_setr_ps(m[12], m[13], m[12], m[13]);
+
+    int i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const __m128 xy = _mm_loadu_ps(points + 2 * i);
+        const __m128 xx = _mm_shuffle_ps(xy, xy, _MM_SHUFFLE(2, 2, 0, 0));
+        const __m128 yy = _mm_shuffle_ps(xy, xy, _MM_SHUFFLE(3, 3, 1, 1));
+        const __m128 result = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, xx), _mm_mul_ps(m1, yy)), m2);
+        _mm_storeu_ps(points + 2 * i, result);
+    }
+
+    transformPointsRemainder(points, i, count, m);
+}
+
+#    if defined(RQQP_QREAL_IS_DOUBLE)
+void packVerticesSse2(const qreal *coordinates, int vertexCount, float *vertices)
+{
+    int i = 0;
+    for (; i + 2 <= vertexCount; i += 2) {
+        const __m128 first = _mm_cvtpd_ps(_mm_loadu_pd(coordinates + 2 * i));
+        const __m128 second = _mm_cvtpd_ps(_mm_loadu_pd(coordinates + 2 * i + 2));
+        _mm_storeu_ps(vertices + 2 * i, _mm_movelh_ps(first, second));
+    }
+
+    packVerticesRemainder(coordinates, i, vertexCount, vertices);
+}
+#    endif
+
+void narrowIndicesSse2(const quint32 *indices, int indexCount, quint16 *target)
+{
+    int i = 0;
+    for (; i + 8 <= indexCount; i += 8) {
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(indices + i));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(indices + i + 4));
+        // SSE2 only packs with signed saturation, sign extending the lower 16 bit first keeps them as they are
+        low = _mm_srai_epi32(_mm_slli_epi32(low, 16), 16);
+        high = _mm_srai_epi32(_mm_slli_epi32(high, 16), 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(target + i), _mm_packs_epi32(low, high));
+    }
+
+    narrowIndicesRemainder(indices, i, indexCount, target);
+}
+
+// two segments per register, sqrt and div are exact, so the result is the same as the scalar one
+void offsetSegmentsSse2(const float *points, int segmentCount, float halfWidth, float *directions, float *vertices)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 width = _mm_setr_ps(-halfWidth, halfWidth, -halfWidth, halfWidth);
+
+    int i = 0;
+    for (; i + 2 <= segmentCount; i += 2) {
+        const __m128 from = _mm_loadu_ps(points + 2 * i);
+        const __m128 to = _mm_loadu_ps(points + 2 * i + 2);
+        const __m128 delta = _mm_sub_ps(to, from);
+        const __m128 squared = _mm_mul_ps(delta, delta);
+        const __m128 length = _mm_sqrt_ps(_mm_add_ps(squared, _mm_shuffle_ps(squared, squared, _MM_SHUFFLE(2, 3, 0, 1))));
+        const __m128 direction = _mm_and_ps(_mm_div_ps(delta, length), _mm_cmpgt_ps(length, zero));
+        _mm_storeu_ps(directions + 2 * i, direction);
+
+        // (-y, x) * half width
+        const __m128 offset = _mm_mul_ps(_mm_shuffle_ps(direction, direction, _MM_SHUFFLE(2, 3, 0, 1)), width);
+        const __m128 fromPlus = _mm_add_ps(from, offset);
+        const __m128 fromMinus = _mm_sub_ps(from, offset);
+        const __m128 toPlus = _mm_add_ps(to, offset);
+        const __m128 toMinus = _mm_sub_ps(to, offset);
+
+        float *quad = vertices + 8 * i;
+        _mm_storeu_ps(quad, _mm_movelh_ps(fromPlus, fromMinus));
+        _mm_storeu_ps(quad + 4, _mm_movelh_ps(toPlus, toMinus));
+        _mm_storeu_ps(quad + 8, _mm_movehl_ps(fromMinus, fromPlus));
+        _mm_storeu_ps(quad + 12, _mm_movehl_ps(toMinus, toPlus));
+    }
+
+    offsetSegmentsRemainder(points, i, segmentCount, halfWidth, directions, vertices);
+}
+#endif
+
+#if defined(RQQP_AVX2)
+// four points per register
+QT_FUNCTION_TARGET(AVX2)
+void flattenCubicAvx2(const QVector2D &p0, const QVector2D &p1, const QVector2D &p2, const QVector2D &p3, int segments,
+                      QVector2D *points)
+{
+    const __m256 c0 = _mm256_setr_ps(p0.x(), p0.y(), p0.x(), p0.y(), p0.x(), p0.y(), p0.x(), p0.y());
+    const __m256 c1 = _mm256_setr_ps(p1.x(), p1.y(), p1.x(), p1.y(), p1.x(), p1.y(), p1.x(), p1.y());
+    const __m256 c2 = _mm256_setr_ps(p2.x(), p2.y(), p2.x(), p2.y(), p2.x(), p2.y(), p2.x(), p2.y());
+    const __m256 c3 = _mm256_setr_ps(p3.x(), p3.y(), p3.x(), p3.y(), p3.x(), p3.y(), p3.x(), p3.y());
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 three = _mm256_set1_ps(3.0f);
+    const __m256 steps = _mm256_setr_ps(0.0f, 0.0f, 1.0f, 1.0f, 2.0f, 2.0f, 3.0f, 3.0f);
+    const __m256 segmentCount = _mm256_set1_ps(static_cast<float>(segments));
+    float *target = reinterpret_cast<float *>(points);
+
+    int i = 1;
+    for (; i + 3 <= segments; i += 4) {
+        const __m256 t = _mm256_div_ps(_mm256_add_ps(_mm256_set1_ps(static_cast<float>(i)), steps), segmentCount);
+        const __m256 s = _mm256_sub_ps(one, t);
+
+        const __m256 w0 = _mm256_mul_ps(_mm256_mul_ps(s, s), s);
+        const __m256 w1 = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(three, s), s), t);
+        const __m256 w2 = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(three, s), t), t);
+        const __m256 w3 = _mm256_mul_ps(_mm256_mul_ps(t, t), t);
+
+        __m256 result = _mm256_add_ps(_mm256_mul_ps(c0, w0), _mm256_mul_ps(c1, w1));
+        result = _mm256_add_ps(result, _mm256_mul_ps(c2, w2));
+        result = _mm256_add_ps(result, _mm256_mul_ps(c3, w3));
+        _mm256_storeu_ps(target + 2 * (i - 1), result);
+    }
+
+    flattenCubicRemainder(p0, p1, p2, p3, i, segments, points);
+}
+
+QT_FUNCTION_TARGET(AVX2)
+void transformPointsAvx2(float *points, int count, const float *m)
+{
+    const __m256 m0 = _mm256_setr_ps(m[0], m[1], m[0], m[1], m[0], m[1], m[0], m[1]);
+    const __m256 m1 = _mm256_setr_ps(m[4], m[5], m[4], m[5], m[4], m[5], m[4], m[5]);
+    const __m256 m2 = _mm256_setr_ps(m[12], m[13], m[12], m[13], m[12], m[13], m[12], m[13]);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256 xy = _mm256_loadu_ps(points + 2 * i);
+        const __m256 xx = _mm256_shuffle_ps(xy, xy, _MM_SHUFFLE(2, 2, 0, 0));
+        const __m256 yy = _mm256_shuffle_ps(xy, xy, _MM_SHUFFLE(3, 3, 1, 1));
+        const __m256 result = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m0, xx), _mm256_mul_ps(m1, yy)), m2);
+        _mm256_storeu_ps(points + 2 * i, result);
+    }
+
+    transformPointsRemainder(points, i, count, m);
+}
+
+#    if defined(RQQP_QREAL_IS_DOUBLE)
+QT_FUNCTION_TARGET(AVX2)
+void packVerticesAvx2(const qreal *coordinates, int vertexCount, float *vertices)
+{
+    int i = 0;
+    for (; i + 4 <= vertexCount; i += 4) {
+        const __m128 first = _mm256_cvtpd_ps(_mm256_loadu_pd(coordinates + 2 * i));
+        const __m128 second = _mm256_cvtpd_ps(_mm256_loadu_pd(coordinates + 2 * i + 4));
+        _mm256_storeu_ps(vertices + 2 * i, _mm256_insertf128_ps(_mm256_castps128_ps256(first), second, 1));
+    }
+
+    packVerticesRemainder(coordinates, i, vertexCount, vertices);
+}
+#    endif
+
+QT_FUNCTION_TARGET(AVX2)
+void narrowIndicesAvx2(const quint32 *indices, int indexCount, quint16 *target)
+{
+    int i = 0;
+    for (; i + 16 <= indexCount; i += 16) {
+        const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(indices + i));
+        const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(indices + i + 8));
+        // packing works per 128 bit lane, the permute restores the order
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(low, high), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(target + i), packed);
+    }
+
+    narrowIndicesRemainder(indices, i, indexCount, target);
+}
+#endif
+
+#if defined(RQQP_NEON)
+void flattenCubicNeon(const QVector2D &p0, const QVector2D &p1, const QVector2D &p2, const QVector2D &p3, int segments,
+                      QVector2D *points)
+{
+    const float32x4_t c0 = { p0.x(), p0.y(), p0.x(), p0.y() };
+    const float32x4_t c1 = { p1.x(), p1.y(), p1.x(), p1.y() };
+    const float32x4_t c2 = { p2.x(), p2.y(), p2.x(), p2.y() };
+    const float32x4_t c3 = { p3.x(), p3.y(), p3.x(), p3.y() };
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t three = vdupq_n_f32(3.0f);
+    float *target = reinterpret_cast<float *>(points);
+
+    int i = 1;
+    for (; i + 1 <= segments; i += 2) {
+        const float t0 = static_cast<float>(i) / segments;
+        const float t1 = static_cast<float>(i + 1) / segments;
+        const float32x4_t t = { t0, t0, t1, t1 };
+        const float32x4_t s = vsubq_f32(one, t);
+
+        const float32x4_t w0 = vmulq_f32(vmulq_f32(s, s), s);
+        const float32x4_t w1 = vmulq_f32(vmulq_f32(vmulq_f32(three, s), s), t);
+        const float32x4_t w2 = vmulq_f32(vmulq_f32(vmulq_f32(three, s), t), t);
+        const float32x4_t w3 = vmulq_f32(vmulq_f32(t, t), t);
+
+        float32x4_t result = vaddq_f32(vmulq_f32(c0, w0), vmulq_f32(c1, w1));
+        result = vaddq_f32(result, vmulq_f32(c2, w2));
+        result = vaddq_f32(result, vmulq_f32(c3, w3));
+        vst1q_f32(target + 2 * (i - 1), result);
+    }
+
+    flattenCubicRemainder(p0, p1, p2, p3, i, segments, points);
+}
+
+void transformPointsNeon(float *points, int count, const float *m)
+{
+    const float32x4_t m0 = { m[0], m[1], m[0], m[1] };
+    const float32x4_t m1 = { m[4], m[5], m[4], m[5] };
+    const float32x4_t m2 = { m[12], m[13], m[12], m[13] };
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        // de-interleaves x and y of four points
+        const float32x4x2_t xy = vld2q_f32(points + 2 * i);
+        const float32x4x2_t xx = vzipq_f32(xy.val[0], xy.val[0]);
+        const float32x4x2_t yy = vzipq_f32(xy.val[1], xy.val[1]);
+        for (int half = 0; half < 2; ++half) {
+            const float32x4_t result = vaddq_f32(vaddq_f32(vmulq_f32(m0, xx.val[half]), vmulq_f32(m1, yy.val[half])), m2);
+            vst1q_f32(points + 2 * i + 4 * half, result);
+        }
+    }
+
+    transformPointsRemainder(points, i, count, m);
+}
+
+#    if defined(RQQP_QREAL_IS_DOUBLE) && (defined(__aarch64__) || defined(_M_ARM64))
+void packVerticesNeon(const qreal *coordinates, int vertexCount, float *vertices)
+{
+    int i = 0;
+    for (; i + 2 <= vertexCount; i += 2) {
+        const float32x2_t first = vcvt_f32_f64(vld1q_f64(coordinates + 2 * i));
+        const float32x2_t second = vcvt_f32_f64(vld1q_f64(coordinates + 2 * i + 2));
+        vst1q_f32(vertices + 2 * i, vcombine_f32(first, second));
+    }
+
+    packVerticesRemainder(coordinates, i, vertexCount, vertices);
+}
+#        define RQQP_NEON_PACK_VERTICES
+#    endif
+
+void narrowIndicesNeon(const quint32 *indices, int indexCount, quint16 *target)
+{
+    int i = 0;
+    for (; i + 8 <= indexCount; i += 8) {
+        const uint16x4_t low = vmovn_u32(vld1q_u32(indices + i));
+        const uint16x4_t high = vmovn_u32(vld1q_u32(indices + i + 4));
+        vst1q_u16(target + i, vcombine_u16(low, high));
+    }
+
+    narrowIndicesRemainder(indices, i, indexCount, target);
+}
+
+#    if defined(__aarch64__) || defined(_M_ARM64)
+// sqrt and div of vectors only exist on AArch64
+void offsetSegmentsNeon(const float *points, int segmentCount, float halfWidth, float *directions, float *vertices)
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t width = { -halfWidth, halfWidth, -halfWidth, halfWidth };
+
+    int i = 0;
+    for (; i + 2 <= segmentCount; i += 2) {
+        const float32x4_t from = vld1q_f32(points + 2 * i);
+        const float32x4_t to = vld1q_f32(points + 2 * i + 2);
+        const float32x4_t delta = vsubq_f32(to, from);
+        const float32x4_t squared = vmulq_f32(delta, delta);
+        const float32x4_t length = vsqrtq_f32(vaddq_f32(squared, vrev64q_f32(squared)));
+        const uint32x4_t valid = vcgtq_f32(length, zero);
+        const float32x4_t direction = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vdivq_f32(delta, length)), valid));
+        vst1q_f32(directions + 2 * i, direction);
+
+        // (-y, x) * half width
+        const float32x4_t offset = vmulq_f32(vrev64q_f32(direction), width);
+        const float32x4_t fromPlus = vaddq_f32(from, offset);
+        const float32x4_t fromMinus = vsubq_f32(from, offset);
+        const float32x4_t toPlus = vaddq_f32(to, offset);
+        const float32x4_t toMinus = vsubq_f32(to, offset);
+
+        float *quad = vertices + 8 * i;
+        vst1q_f32(quad, vcombine_f32(vget_low_f32(fromPlus), vget_low_f32(fromMinus)));
+        vst1q_f32(quad + 4, vcombine_f32(vget_low_f32(toPlus), vget_low_f32(toMinus)));
+        vst1q_f32(quad + 8, vcombine_f32(vget_high_f32(fromPlus), vget_high_f32(fromMinus)));
+        vst1q_f32(quad + 12, vcombine_f32(vget_high_f32(toPlus), vget_high_f32(toMinus)));
+    }
+
+    offsetSegmentsRemainder(points, i, segmentCount, halfWidth, directions, vertices);
+}
+#        define RQQP_NEON_OFFSET_SEGMENTS
+#    endif
+#endif
+
+Kernels selectKernels()
+{
+    Kernels kernels { flattenCubicScalar, transformPointsScalar, packVerticesScalar, narrowIndicesScalar, offsetSegmentsScalar, "scalar" };
+
+    if (qEnvironmentVariableIsSet("RIVEQTQUICKPLUGIN_DISABLE_SIMD")) {
+        return kernels;
+    }
+
+#if defined(RQQP_SSE2)
+    kernels = { flattenCubicSse2, transformPointsSse2, packVerticesScalar, narrowIndicesSse2, offsetSegmentsSse2, "SSE2" };
+#    if defined(RQQP_QREAL_IS_DOUBLE)
+    kernels.packVertices = packVerticesSse2;
+#    endif
+#    if defined(RQQP_AVX2)
+    if (qCpuHasFeature(AVX2)) {
+        // the offsets stay with SSE2, two segments already fill a register and the quads do not cross 128 bit lanes well
+        kernels = { flattenCubicAvx2, transformPointsAvx2, kernels.packVertices, narrowIndicesAvx2, offsetSegmentsSse2, "AVX2" };
+#        if defined(RQQP_QREAL_IS_DOUBLE)
+        kernels.packVertices = packVerticesAvx2;
+#        endif
+    }
+#    endif
+#elif defined(RQQP_NEON)
+    kernels = { flattenCubicNeon, transformPointsNeon, packVerticesScalar, narrowIndicesNeon, offsetSegmentsScalar, "NEON" };
+#    if defined(RQQP_NEON_PACK_VERTICES)
+    kernels.packVertices = packVerticesNeon;
+#    endif
+#    if defined(RQQP_NEON_OFFSET_SEGMENTS)
+    kernels.offsetSegments = offsetSegmentsNeon;
+#    endif
+#endif
+
+    return kernels;
+}
+
+const Kernels &kernels()
+{
+    static const Kernels selected = [] {
+        const Kernels kernels = selectKernels();
+        qCDebug(rqqpRendering) << "Path kernels use" << kernels.name;
+        return kernels;
+    }();
+    return selected;
+}
+
+} // namespace
+
+namespace RiveQtPathKernels {
+
+void flattenCubic(const QVector2D &p0, const QVector2D &p1, const QVector2D &p2, const QVector2D &p3, int segments, QVector2D *points)
+{
+    if (segments <= 0) {
+        return;
+    }
+
+    kernels().flattenCubic(p0, p1, p2, p3, segments, points);
+    // contours are closed by comparing points, the end point must not depend on the instruction set
+    points[segments - 1] = p3;
+}
+
+void transformPoints(QVector2D *points, int count, const QMatrix4x4 &matrix)
+{
+    static_assert(sizeof(QVector2D) == 2 * sizeof(float), "QVector2D is expected to be two tightly packed floats");
+    kernels().transformPoints(reinterpret_cast<float *>(points), count, matrix.constData());
+}
+
+void packVertices(const qreal *coordinates, int vertexCount, QVector2D *vertices)
+{
+    kernels().packVertices(coordinates, vertexCount, reinterpret_cast<float *>(vertices));
+}
+
+void narrowIndices(const quint32 *indices, int indexCount, quint16 *target)
+{
+    kernels().narrowIndices(indices, indexCount, target);
+}
+
+void offsetSegments(const QVector2D *points, int segmentCount, float halfWidth, QVector2D *directions, QVector2D *vertices)
+{
+    kernels().offsetSegments(reinterpret_cast<const float *>(points), segmentCount, halfWidth, reinterpret_cast<float *>(directions),
+                             reinterpret_cast<float *>(vertices));
+}
+
+const char *instructionSet()
+{
+    return kernels().name;
+}
+
+}
@@ -0,0 +1,29 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#pragma once
+
+#include <QVector2D>
+#include <QMatrix4x4>
+
+// the inner loops of the path tessellation, the SSE2, AVX2 or NEON variant is picked once at runtime
+// setting RIVEQTQUICKPLUGIN_DISABLE_SIMD in the environment forces the scalar variant
+namespace RiveQtPathKernels {
+    // writes the points at t = 1 / segments ... 1 of the cubic, the last point is exactly p3
+    void flattenCubic(const QVector2D &p0, const QVector2D &p1, const QVector2D &p2, const QVector2D &p3, int segments,
+                      QVector2D *points);
+    // applies the 2D affine part of the matrix in place
+    void transformPoints(QVector2D *points, int count, const QMatrix4x4 &matrix);
+    // converts interleaved x, y coordinates into vertices
+    void packVertices(const qreal *coordinates, int vertexCount, QVector2D *vertices);
+    // the caller guarantees that all indices fit into 16 bit
+    void narrowIndices(const quint32 *indices, int indexCount, quint16 *target);
+    // offsets the segments between consecutive points by half the width to both sides, points holds segmentCount + 1 points
+    // writes the direction of each segment and 4 vertices per segment: from + offset, from - offset, to + offset, to - offset
+    void offsetSegments(const QVector2D *points, int segmentCount, float halfWidth, QVector2D *directions, QVector2D *vertices);
+
+    // name of the selected variant, for logging
+    const char *instructionSet();
+}
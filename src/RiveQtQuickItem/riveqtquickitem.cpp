@@ -7,17 +7,26 @@
 #include "riveqsgrendernode.h"
 #include "rqqplogging.h"
 #include "riveqsgsoftwarerendernode.h"
+#include "riveqtstaticshapes.h"
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 #include "riveqsgrhirendernode.h"
+#include "riveqsgtextureprovider.h"
 #endif
 
 #include <QSGRendererInterface>
 #include <QQmlEngine>
 #include <QQuickWindow>
 #include <QFile>
+#include <private/qquickwindow_p.h>
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+#include <QQuickGraphicsConfiguration>
+#endif
 
 #include <rive/file.hpp>
 
+// artboard instances kept per item, older ones are dropped once more artboards have been shown
+#define MAX_CACHED_ARTBOARD_INSTANCES 8
+
 RiveQtQuickItem::RiveQtQuickItem(QQuickItem *parent)
     : RiveQtQuickItemBase(parent)
 {
@@ -29,6 +38,8 @@ RiveQtQuickItem::RiveQtQuickItem(QQuickItem *parent)
 
     // we require a window to know the render backend and setup the correct.
     connect(this, &RiveQtQuickItem::windowChanged, this, [this]() { loadRiveFile(m_fileSource); });
+    // the pipeline cache has to be configured before the window creates its rhi
+    connect(this, &RiveQtQuickItem::windowChanged, this, &RiveQtQuickItem::applyPipelineCacheFile);
 
     // TODO: 1) shall we make this Interval match the FPS of the current selected animation
     // TODO: 2) we may want to move this into the render thread to allow the render thread control over the timer,
@@ -59,7 +70,23 @@ RiveQtQuickItem::RiveQtQuickItem(QQuickItem *parent)
     update();
 }
 
-RiveQtQuickItem::~RiveQtQuickItem() { }
+RiveQtQuickItem::~RiveQtQuickItem()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    // only left in case the item never had its resources released, it still belongs to the render thread
+    if (m_textureProvider) {
+        if (window()) {
+            QQuickWindowQObjectCleanupJob::schedule(window(), m_textureProvider);
+        } else {
+            m_textureProvider->deleteLater();
+        }
+        m_textureProvider = nullptr;
+    }
+#else
+    // the painted item draws the node itself, it is not part of the scene graph
+    delete m_renderNode;
+#endif
+}
 
 void RiveQtQuickItem::triggerAnimation(int id)
 {
@@ -94,7 +121,19 @@ bool RiveQtQuickItem::isTextureProvider() const
 
 QSGTextureProvider *RiveQtQuickItem::textureProvider() const
 {
-    return m_textureProvider.data();
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    return RiveQtQuickItemBase::textureProvider();
+#else
+    // only called on the render thread, like in QQuickImage the provider is created once another item asks for it
+    // the render node hands its final texture to the provider with every frame
+    if (!m_textureProvider) {
+        m_textureProvider = new RiveQSGTextureProvider;
+        if (m_renderNode) {
+            m_renderNode->setTextureProvider(m_textureProvider);
+        }
+    }
+    return m_textureProvider;
+#endif
 }
 
 QString RiveQtQuickItem::fileSource() const
@@ -113,6 +152,8 @@ void RiveQtQuickItem::updateInternalArtboard()
     if (m_loadingStatus == Idle && m_currentArtboardInstance) {
         qCDebug(rqqpItem) << "Unloading artboard instance";
         m_currentArtboardInstance = nullptr;
+        m_artboardInstances.clear();
+        m_artboardInstanceOrder.clear();
         emit internalArtboardChanged();
         return;
     }
@@ -122,12 +163,7 @@ void RiveQtQuickItem::updateInternalArtboard()
         return;
     }
 
-    if (m_currentArtboardIndex == -1) {
-        m_currentArtboardInstance = m_riveFile->artboardDefault();
-    } else if (!m_currentArtboardInstance
-               || m_riveFile->artboardAt(m_currentArtboardIndex).get() != m_currentArtboardInstance->artboard()) {
-        m_currentArtboardInstance = m_riveFile->artboardAt(m_currentArtboardIndex);
-    }
+    m_currentArtboardInstance = cachedArtboardInstance(m_currentArtboardIndex);
 
     if (!m_currentArtboardInstance) {
         qCDebug(rqqpItem) << "Artboard changed, but instance is null";
@@ -150,6 +186,43 @@ void RiveQtQuickItem::updateInternalArtboard()
     emit internalArtboardChanged();
 }
 
+std::shared_ptr<rive::ArtboardInstance> RiveQtQuickItem::cachedArtboardInstance(int index)
+{
+    const auto cached = m_artboardInstances.constFind(index);
+    if (cached != m_artboardInstances.constEnd()) {
+        m_artboardInstanceOrder.removeOne(index);
+        m_artboardInstanceOrder.append(index);
+        return cached.value();
+    }
+
+    std::shared_ptr<rive::ArtboardInstance> artboardInstance = index == -1 ? m_riveFile->artboardDefault() : m_riveFile->artboardAt(index);
+    if (!artboardInstance) {
+        return nullptr;
+    }
+
+    // the render paths exist after the first update, which shapes are static does not change afterwards
+    artboardInstance->updateComponents();
+    const int staticShapes = RiveQtStaticShapes::markRetainedPaths(artboardInstance.get());
+    qCDebug(rqqpItem) << "Artboard has" << staticShapes << "static shapes with retained geometry";
+
+    // the artboard shown least recently goes first, never the one still shown
+    if (m_artboardInstances.size() >= MAX_CACHED_ARTBOARD_INSTANCES) {
+        for (int i = 0; i < m_artboardInstanceOrder.size(); ++i) {
+            const int leastRecentIndex = m_artboardInstanceOrder.at(i);
+            if (m_artboardInstances.value(leastRecentIndex) != m_currentArtboardInstance) {
+                qCDebug(rqqpItem) << "Dropping cached instance of artboard" << leastRecentIndex;
+                m_artboardInstances.remove(leastRecentIndex);
+                m_artboardInstanceOrder.removeAt(i);
+                break;
+            }
+        }
+    }
+
+    m_artboardInstances.insert(index, artboardInstance);
+    m_artboardInstanceOrder.append(index);
+    return artboardInstance;
+}
+
 QSGNode *RiveQtQuickItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
 {
     if (m_loadingGuard) {
@@ -179,6 +252,9 @@ QSGNode *RiveQtQuickItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData
 
         m_renderNode->updateArtboardInstance(std::weak_ptr<rive::ArtboardInstance>());
         m_currentArtboardInstance.reset();
+        // the instances belong to the file, they have to go first
+        m_artboardInstances.clear();
+        m_artboardInstanceOrder.clear();
 
         // reset all
         m_riveFile = nullptr;
@@ -277,6 +353,7 @@ QSGNode *RiveQtQuickItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData
     }
 
     if (m_renderNode) {
+        m_renderNode->setTextureProvider(m_textureProvider);
         m_renderNode->markDirty(QSGNode::DirtyForceUpdate);
     }
 
@@ -317,6 +394,19 @@ void RiveQtQuickItem::componentComplete()
     m_stateMachineInterface->initializeInternal();
 }
 
+void RiveQtQuickItem::releaseResources()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    // the provider belongs to the render thread, like the render node feeding it
+    if (m_textureProvider) {
+        QQuickWindowQObjectCleanupJob::schedule(window(), m_textureProvider);
+        m_textureProvider = nullptr;
+    }
+#endif
+
+    RiveQtQuickItemBase::releaseResources();
+}
+
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 void RiveQtQuickItem::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry)
 {
@@ -781,7 +871,6 @@ void RiveQtQuickItem::setCurrentArtboardIndex(int index)
         emit currentArtboardIndexChanged();
 
         m_scheduleArtboardChange = true; // we have to do this in the render thread.
-        m_renderNode = nullptr;
         return;
     }
 
@@ -793,8 +882,8 @@ void RiveQtQuickItem::setCurrentArtboardIndex(int index)
     m_currentArtboardIndex = index;
     emit currentArtboardIndexChanged();
 
+    // the render node is kept, it receives the new artboard instance with the next updatePaintNode
     m_scheduleArtboardChange = true; // we have to do this in the render thread.
-    m_renderNode = nullptr;
     update();
 }
 
@@ -905,6 +994,138 @@ void RiveQtQuickItem::setFillMode(RiveRenderSettings::FillMode fillMode)
     emit fillModeChanged();
 }
 
+RiveRenderSettings::FillRenderMode RiveQtQuickItem::fillRenderMode() const
+{
+    return m_renderSettings.fillRenderMode;
+}
+
+void RiveQtQuickItem::setFillRenderMode(RiveRenderSettings::FillRenderMode fillRenderMode)
+{
+    if (m_renderSettings.fillRenderMode == fillRenderMode) {
+        return;
+    }
+
+    m_renderSettings.fillRenderMode = fillRenderMode;
+    emit fillRenderModeChanged();
+}
+
+RiveRenderSettings::StrokeMode RiveQtQuickItem::strokeMode() const
+{
+    return m_renderSettings.strokeMode;
+}
+
+void RiveQtQuickItem::setStrokeMode(RiveRenderSettings::StrokeMode strokeMode)
+{
+    if (m_renderSettings.strokeMode == strokeMode) {
+        return;
+    }
+
+    m_renderSettings.strokeMode = strokeMode;
+    emit strokeModeChanged();
+}
+
+RiveRenderSettings::AntialiasingMode RiveQtQuickItem::antialiasingMode() const
+{
+    return m_renderSettings.antialiasingMode;
+}
+
+void RiveQtQuickItem::setAntialiasingMode(RiveRenderSettings::AntialiasingMode antialiasingMode)
+{
+    if (m_renderSettings.antialiasingMode == antialiasingMode) {
+        return;
+    }
+
+    m_renderSettings.antialiasingMode = antialiasingMode;
+    emit antialiasingModeChanged();
+}
+
+bool RiveQtQuickItem::nestedArtboardCaching() const
+{
+    return m_renderSettings.nestedArtboardCaching;
+}
+
+void RiveQtQuickItem::setNestedArtboardCaching(bool nestedArtboardCaching)
+{
+    if (m_renderSettings.nestedArtboardCaching == nestedArtboardCaching) {
+        return;
+    }
+
+    m_renderSettings.nestedArtboardCaching = nestedArtboardCaching;
+    emit nestedArtboardCachingChanged();
+}
+
+bool RiveQtQuickItem::renderAtlas() const
+{
+    return m_renderSettings.renderAtlas;
+}
+
+void RiveQtQuickItem::setRenderAtlas(bool renderAtlas)
+{
+    if (m_renderSettings.renderAtlas == renderAtlas) {
+        return;
+    }
+
+    m_renderSettings.renderAtlas = renderAtlas;
+    emit renderAtlasChanged();
+}
+
+QString RiveQtQuickItem::pipelineCacheFile() const
+{
+    return m_pipelineCacheFile;
+}
+
+void RiveQtQuickItem::setPipelineCacheFile(const QString &pipelineCacheFile)
+{
+    if (m_pipelineCacheFile == pipelineCacheFile) {
+        return;
+    }
+
+    m_pipelineCacheFile = pipelineCacheFile;
+#if QT_VERSION < QT_VERSION_CHECK(6, 5, 0)
+    // QQuickGraphicsConfiguration has no pipeline cache before Qt 6.5, warned once for all items
+    static bool pipelineCacheWarned = false;
+    if (!pipelineCacheWarned && !m_pipelineCacheFile.isEmpty()) {
+        qCWarning(rqqpItem) << "Pipeline cache file" << m_pipelineCacheFile << "ignored, it requires Qt 6.5 or newer.";
+        pipelineCacheWarned = true;
+    }
+#endif
+    applyPipelineCacheFile();
+    emit pipelineCacheFileChanged();
+}
+
+void RiveQtQuickItem::applyPipelineCacheFile()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+    QQuickWindow *currentWindow = window();
+    if (!currentWindow || m_pipelineCacheFile.isEmpty()) {
+        return;
+    }
+
+    QQuickGraphicsConfiguration configuration = currentWindow->graphicsConfiguration();
+    if (configuration.pipelineCacheSaveFile() == m_pipelineCacheFile) {
+        return;
+    }
+
+    // qt quick only reads the configuration when it creates the rhi
+    if (currentWindow->isSceneGraphInitialized()) {
+        qCWarning(rqqpItem) << "Pipeline cache file" << m_pipelineCacheFile << "ignored, the window is already initialized.";
+        return;
+    }
+
+    // several items may share one window, the first file wins
+    if (!configuration.pipelineCacheSaveFile().isEmpty()) {
+        qCWarning(rqqpItem) << "Pipeline cache file" << m_pipelineCacheFile << "ignored, the window already uses"
+                            << configuration.pipelineCacheSaveFile();
+        return;
+    }
+
+    qCDebug(rqqpItem) << "Using pipeline cache file" << m_pipelineCacheFile;
+    configuration.setPipelineCacheLoadFile(m_pipelineCacheFile);
+    configuration.setPipelineCacheSaveFile(m_pipelineCacheFile);
+    currentWindow->setGraphicsConfiguration(configuration);
+#endif
+}
+
 int RiveQtQuickItem::frameRate()
 {
     return m_frameRate;
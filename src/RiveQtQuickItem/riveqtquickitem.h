@@ -9,6 +9,7 @@
 #include <QSGRenderNode>
 #include <QSGTextureProvider>
 #include <QElapsedTimer>
+#include <QHash>
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
 #include <QQuickPaintedItem>
 #define RiveQtQuickItemBase QQuickPaintedItem
@@ -32,6 +33,7 @@
 #endif
 
 class RiveQSGRenderNode;
+class RiveQSGTextureProvider;
 /**
  * \class RiveQtQuickItem
  * \brief A quick item for Rive-based animations.
@@ -170,6 +172,10 @@ class RiveQtQuickItem : public RiveQtQuickItemBase
      * to the position of the artboard in the `artboards` list. Changing the index will
      * immediately reflect the change in the displayed content.
      *
+     * The item keeps the instances of the last 8 artboards it showed, so switching back is cheap. Such an artboard is
+     * not reset: its animation and state machine start again, but its objects keep the values they were left with
+     * until the animation or state machine changes them.
+     *
      * \par Example:
      * \code
      * RiveQtQuickItem {
@@ -335,6 +341,155 @@ class RiveQtQuickItem : public RiveQtQuickItemBase
      */
     Q_PROPERTY(RiveRenderSettings::FillMode fillMode READ fillMode WRITE setFillMode NOTIFY fillModeChanged)
 
+    /**
+     * \property RiveQtQuickItem::fillRenderMode
+     *
+     * \brief Selects how filled paths are rasterized by the RHI renderer.
+     *
+     * The possible modes are:
+     * - \em TriangulatedFill: Every path is triangulated on the CPU.
+     * - \em StencilCoverFill: Every path is drawn as triangle fans into the stencil buffer and covered afterwards.
+     *   The fill rule is resolved on the GPU, which makes this cheap for complex paths.
+     * - \em AutomaticFill: Picks one of the above per path, depending on its complexity.
+     * - \em GpuTessellatedFill: Like StencilCoverFill, but the curves are not flattened on the CPU. Each segment is
+     *   uploaded with its control points and tessellated in the vertex shader, as fine as the current zoom requires.
+     *   Falls back to StencilCoverFill if the graphics API does not support instancing.
+     *
+     * The mode is applied when the render node is created. It has no effect on the software renderer.
+     *
+     * \par Example:
+     * \code
+     * RiveQtQuickItem {
+     *     fillRenderMode: RiveRenderSettings.StencilCoverFill
+     * }
+     * \endcode
+     */
+    Q_PROPERTY(RiveRenderSettings::FillRenderMode fillRenderMode READ fillRenderMode WRITE setFillRenderMode NOTIFY fillRenderModeChanged)
+
+    /**
+     * \property RiveQtQuickItem::strokeMode
+     *
+     * \brief Selects how strokes are turned into triangles by the RHI renderer.
+     *
+     * The possible modes are:
+     * - \em QtStroking: The outline is created by QPainterPathStroker and triangulated afterwards.
+     * - \em NativeStroking: Triangles are emitted directly along the path, including joins, caps and miter limits.
+     *   This is considerably faster for animated strokes.
+     * - \em GpuStroking: Only the flattened centre line is uploaded, the vertex shader expands it into segments, joins
+     *   and caps. Changing the stroke width costs no tessellation at all. Falls back to NativeStroking if the graphics API
+     *   does not support instancing.
+     *
+     * The mode is applied when the render node is created. It has no effect on the software renderer.
+     *
+     * \par Example:
+     * \code
+     * RiveQtQuickItem {
+     *     strokeMode: RiveRenderSettings.NativeStroking
+     * }
+     * \endcode
+     */
+    Q_PROPERTY(RiveRenderSettings::StrokeMode strokeMode READ strokeMode WRITE setStrokeMode NOTIFY strokeModeChanged)
+
+    /**
+     * \property RiveQtQuickItem::antialiasingMode
+     *
+     * \brief Selects the edge antialiasing of the RHI renderer.
+     *
+     * The possible modes are:
+     * - \em NoAntialiasing: Edges are as smooth as the sample count of the window allows.
+     * - \em AnalyticAntialiasing: Every path gets a one pixel wide fringe outside of its edges, which fades out by its
+     *   coverage. This smooths fills and strokes at sample count 1, without MSAA surfaces or a postprocessing pass.
+     *   Needs instancing support of the graphics API, otherwise it is disabled.
+     *
+     * The mode is applied when the render node is created. It has no effect on the software renderer.
+     *
+     * \par Example:
+     * \code
+     * RiveQtQuickItem {
+     *     antialiasingMode: RiveRenderSettings.AnalyticAntialiasing
+     * }
+     * \endcode
+     */
+    Q_PROPERTY(RiveRenderSettings::AntialiasingMode antialiasingMode READ antialiasingMode WRITE setAntialiasingMode NOTIFY
+                   antialiasingModeChanged)
+
+    /**
+     * \property RiveQtQuickItem::nestedArtboardCaching
+     *
+     * \brief Draws nested artboards from a cached texture while they do not change.
+     *
+     * When enabled, every nested artboard is rendered into a texture once and the texture is drawn instead of its paths.
+     * The texture is rendered again on the GPU when anything inside of the nested artboard changes, or when it is drawn
+     * at a scale beyond the next power of two. Moving the nested artboard does not invalidate the texture.
+     *
+     * Nested artboards with blend modes other than srcOver, images or meshes, or larger than 2048 pixels, are always
+     * drawn path by path. Disabled by default, since every texture costs GPU memory and a render pass of its own.
+     *
+     * The setting is applied when the render node is created. It has no effect on the software renderer.
+     *
+     * \par Example:
+     * \code
+     * RiveQtQuickItem {
+     *     nestedArtboardCaching: true
+     * }
+     * \endcode
+     */
+    Q_PROPERTY(bool nestedArtboardCaching READ nestedArtboardCaching WRITE setNestedArtboardCaching NOTIFY nestedArtboardCachingChanged)
+
+    /**
+     * \property RiveQtQuickItem::renderAtlas
+     *
+     * \brief Lets small items share their render surfaces with the other items of the window.
+     *
+     * Every item normally owns render surfaces of its size and draws them in an offscreen frame of its own. For
+     * views showing many small animations, like icons on a dashboard, these surfaces and frames dominate. When
+     * enabled, items up to 256 x 256 pixels take a region of shared 1024 x 1024 surfaces instead and draw into it
+     * within the frame of the window. Items that are larger, or do not fit anymore, use their own surfaces.
+     *
+     * Before the scene graph draws the window, the draws of all these items are recorded into shared render passes,
+     * one per surface. A new pass only begins where a draw needs the stencil cleared or uses a shader blend mode.
+     *
+     * Items with the SMAA postprocessingMode keep their own surfaces, since the postprocessing works on whole surfaces,
+     * and the shared surfaces are not used with multisampling. The setting is applied when the render node is created.
+     * It has no effect on the software renderer.
+     *
+     * \par Example:
+     * \code
+     * RiveQtQuickItem {
+     *     width: 48
+     *     height: 48
+     *     renderAtlas: true
+     * }
+     * \endcode
+     */
+    Q_PROPERTY(bool renderAtlas READ renderAtlas WRITE setRenderAtlas NOTIFY renderAtlasChanged)
+
+    /**
+     * \property RiveQtQuickItem::pipelineCacheFile
+     *
+     * \brief File used to keep the compiled graphics pipelines between application starts.
+     *
+     * Creating the pipelines of the render node, and of the post processing, makes the graphics driver compile
+     * shaders, which can take noticeable time on the first frame. When set, Qt Quick loads the pipeline cache from
+     * this file when it creates the graphics backend of the window, and writes it back when the backend is destroyed,
+     * so that following starts of the application skip the compilation.
+     *
+     * The cache belongs to the window, not to the item. It has to be set before the window is shown, later changes are
+     * ignored with a warning, and only the first file set on a window is used. It has no effect on the software renderer.
+     * The QSG_RHI_PIPELINE_CACHE_LOAD and QSG_RHI_PIPELINE_CACHE_SAVE environment variables can be used instead.
+     *
+     * \note Requires Qt 6.5 or newer. When the plugin is built against an older Qt version the file is ignored, which
+     * is logged once as a warning.
+     *
+     * \par Example:
+     * \code
+     * RiveQtQuickItem {
+     *     pipelineCacheFile: StandardPaths.writableLocation(StandardPaths.CacheLocation) + "/pipelines.bin"
+     * }
+     * \endcode
+     */
+    Q_PROPERTY(QString pipelineCacheFile READ pipelineCacheFile WRITE setPipelineCacheFile NOTIFY pipelineCacheFileChanged)
+
     /**
      * \property RiveQtQuickItem::frameRate
      *
@@ -408,6 +563,24 @@ public:
     RiveRenderSettings::FillMode fillMode() const;
     void setFillMode(RiveRenderSettings::FillMode fillMode);
 
+    RiveRenderSettings::FillRenderMode fillRenderMode() const;
+    void setFillRenderMode(RiveRenderSettings::FillRenderMode fillRenderMode);
+
+    RiveRenderSettings::StrokeMode strokeMode() const;
+    void setStrokeMode(RiveRenderSettings::StrokeMode strokeMode);
+
+    RiveRenderSettings::AntialiasingMode antialiasingMode() const;
+    void setAntialiasingMode(RiveRenderSettings::AntialiasingMode antialiasingMode);
+
+    bool nestedArtboardCaching() const;
+    void setNestedArtboardCaching(bool nestedArtboardCaching);
+
+    bool renderAtlas() const;
+    void setRenderAtlas(bool renderAtlas);
+
+    QString pipelineCacheFile() const;
+    void setPipelineCacheFile(const QString &pipelineCacheFile);
+
     int frameRate();
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
@@ -437,12 +610,19 @@ signals:
     void renderQualityChanged();
     void postprocessingModeChanged();
     void fillModeChanged();
+    void fillRenderModeChanged();
+    void strokeModeChanged();
+    void antialiasingModeChanged();
+    void nestedArtboardCachingChanged();
+    void renderAtlasChanged();
+    void pipelineCacheFileChanged();
 
     void frameRateChanged();
 
 protected:
     QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
     void componentComplete() override;
+    void releaseResources() override;
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
     void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
@@ -460,6 +640,9 @@ private:
     void loadRiveFile(const QString &source);
 
     void updateInternalArtboard();
+    // returns the cached instance of the artboard, creates it on first use (-1 is the default artboard)
+    // a cached instance is not reset, its objects keep the values the last animation or state machine left them with
+    std::shared_ptr<rive::ArtboardInstance> cachedArtboardInstance(int index);
     void updateAnimations();
     void updateStateMachines();
     void updateCurrentArtboardIndex();
@@ -470,6 +653,8 @@ private:
 
     void renderOffscreen();
 
+    void applyPipelineCacheFile();
+
     bool hitTest(const QPointF &pos, const rive::ListenerType &type);
 
     RiveQSGRenderNode *createRenderNode(const RiveRenderSettings &renderSettings,
@@ -483,12 +668,18 @@ private:
 
     std::unique_ptr<rive::File> m_riveFile;
 
-    mutable QScopedPointer<QSGTextureProvider> m_textureProvider;
+    // created in the render thread once another item asks for our texture, released through the window like the render node
+    mutable RiveQSGTextureProvider *m_textureProvider { nullptr };
 
     QString m_fileSource;
+    QString m_pipelineCacheFile;
     LoadingStatus m_loadingStatus { Idle };
 
     std::shared_ptr<rive::ArtboardInstance> m_currentArtboardInstance { nullptr };
+    // instances of the artboards shown so far, switching back reuses them together with their retained geometry
+    QHash<int, std::shared_ptr<rive::ArtboardInstance>> m_artboardInstances;
+    // the indices of the cached instances, the one shown least recently first
+    QList<int> m_artboardInstanceOrder;
     std::unique_ptr<rive::LinearAnimationInstance> m_animationInstance { nullptr };
     std::shared_ptr<rive::StateMachineInstance> m_currentStateMachineInstance { nullptr };
 
@@ -6,6 +6,7 @@
 #include <QtQml>
 
 #include "riveqtquickitem.h"
+#include "riveqttextureview.h"
 #include "rivestatemachineinput.h"
 #include "datatypes.h"
 #include "riveqtquickplugin.h"
@@ -14,6 +15,7 @@ void RiveQtQuickPlugin::registerTypes(const char *uri)
 {
     qmlRegisterType<RiveQtQuickItem>("RiveQtQuickPlugin", 1, 0, "RiveQtQuickItem");
     qmlRegisterType<RiveStateMachineInput>("RiveQtQuickPlugin", 1, 0, "RiveStateMachineInput");
+    qmlRegisterType<RiveQtTextureView>("RiveQtQuickPlugin", 1, 0, "RiveQtTextureView");
 
     qRegisterMetaType<RiveRenderSettings>("RiveRenderSettings");
 
@@ -0,0 +1,100 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "riveqtstaticshapes.h"
+#include "riveqtpath.h"
+
+#include <rive/artboard.hpp>
+#include <rive/animation/linear_animation.hpp>
+#include <rive/animation/keyed_object.hpp>
+#include <rive/bones/skin.hpp>
+#include <rive/constraints/constraint.hpp>
+#include <rive/shapes/shape.hpp>
+#include <rive/shapes/path_composer.hpp>
+
+#include <QSet>
+
+namespace RiveQtStaticShapes {
+
+int markRetainedPaths(rive::Artboard *artboard)
+{
+    if (!artboard) {
+        return 0;
+    }
+
+    // everything an animation, a constraint or a skin changes
+    QSet<const rive::Component *> animated;
+
+    for (size_t i = 0; i < artboard->animationCount(); ++i) {
+        const rive::LinearAnimation *animation = artboard->animation(i);
+        for (size_t j = 0; j < animation->numKeyedObjects(); ++j) {
+            rive::Core *object = artboard->resolve(animation->getObject(j)->objectId());
+            if (object && object->is<rive::Component>()) {
+                animated.insert(object->as<rive::Component>());
+            }
+        }
+    }
+
+    for (rive::Core *object : artboard->objects()) {
+        if (!object) {
+            continue;
+        }
+        // both change their parent, the constrained transform or the skinned path
+        if (object->is<rive::Constraint>() || object->is<rive::Skin>()) {
+            const rive::Component *parent = object->as<rive::Component>()->parent();
+            if (parent) {
+                animated.insert(parent);
+            }
+        }
+    }
+
+    // a shape depends on its parents (world space paths) and on its children (paths and their vertices)
+    QSet<const rive::Component *> containsAnimated;
+    for (const rive::Component *component : std::as_const(animated)) {
+        for (const rive::Component *parent = component; parent; parent = parent->parent()) {
+            if (containsAnimated.contains(parent)) {
+                break;
+            }
+            containsAnimated.insert(parent);
+        }
+    }
+
+    const auto isAnimated = [&](const rive::Shape *shape) {
+        if (containsAnimated.contains(shape)) {
+            return true;
+        }
+        for (const rive::Component *parent = shape->parent(); parent; parent = parent->parent()) {
+            if (animated.contains(parent)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    int staticShapes = 0;
+    for (rive::Core *object : artboard->objects()) {
+        if (!object || !object->is<rive::Shape>()) {
+            continue;
+        }
+
+        rive::Shape *shape = object->as<rive::Shape>();
+        if (isAnimated(shape)) {
+            continue;
+        }
+
+        ++staticShapes;
+        const rive::PathComposer *pathComposer = shape->pathComposer();
+        if (auto *localPath = pathComposer->localPath()) {
+            static_cast<RiveQtPath *>(localPath)->setRetained(true);
+        }
+        if (auto *worldPath = pathComposer->worldPath()) {
+            static_cast<RiveQtPath *>(worldPath)->setRetained(true);
+        }
+    }
+
+    return staticShapes;
+}
+
+}
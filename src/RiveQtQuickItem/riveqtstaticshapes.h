@@ -0,0 +1,18 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#pragma once
+
+namespace rive {
+class Artboard;
+}
+
+// load time analysis of an artboard: a shape is static when no animation keys it, one of its parents or
+// anything inside of it, and no constraint or skin moves it - state machines only play the artboard animations
+namespace RiveQtStaticShapes {
+    // marks the paths of all static shapes as retained, returns the number of static shapes
+    // the render paths are created by the first update of the artboard, so it has to be updated before
+    int markRetainedPaths(rive::Artboard *artboard);
+}
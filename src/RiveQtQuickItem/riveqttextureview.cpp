@@ -0,0 +1,78 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#include "riveqttextureview.h"
+#include "rqqplogging.h"
+
+#include <QQuickWindow>
+#include <QSGImageNode>
+
+RiveQtTextureView::RiveQtTextureView(QQuickItem *parent)
+    : QQuickItem(parent)
+{
+    setFlag(QQuickItem::ItemHasContents, true);
+}
+
+QQuickItem *RiveQtTextureView::source() const
+{
+    return m_source;
+}
+
+void RiveQtTextureView::setSource(QQuickItem *source)
+{
+    if (m_source == source) {
+        return;
+    }
+
+    if (source && !source->isTextureProvider()) {
+        qCWarning(rqqpItem) << "Texture view source" << source << "is not a texture provider";
+    }
+
+    m_source = source;
+    emit sourceChanged();
+    update();
+}
+
+QSGNode *RiveQtTextureView::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data)
+
+    auto *node = static_cast<QSGImageNode *>(oldNode);
+
+    QSGTextureProvider *textureProvider = nullptr;
+    if (m_source && m_source->isTextureProvider() && m_source->window() == window()) {
+        textureProvider = m_source->textureProvider();
+    }
+
+    if (textureProvider != m_textureProvider) {
+        if (m_textureProvider) {
+            disconnect(m_textureProvider, nullptr, this, nullptr);
+        }
+        m_textureProvider = textureProvider;
+        // the provider emits from the render thread, each frame of the source is shown once it is drawn
+        if (m_textureProvider) {
+            connect(m_textureProvider, &QSGTextureProvider::textureChanged, this, &QQuickItem::update, Qt::QueuedConnection);
+        }
+    }
+
+    QSGTexture *texture = m_textureProvider ? m_textureProvider->texture() : nullptr;
+    if (!texture || width() <= 0 || height() <= 0) {
+        delete node;
+        return nullptr;
+    }
+
+    if (!node) {
+        node = window()->createImageNode();
+    }
+
+    node->setTexture(texture);
+    node->setRect(boundingRect());
+    node->setSourceRect(QRectF(QPointF(0, 0), texture->textureSize()));
+    node->setFiltering(smooth() ? QSGTexture::Linear : QSGTexture::Nearest);
+    // the texture object stays the same while its content changes
+    node->markDirty(QSGNode::DirtyMaterial);
+
+    return node;
+}
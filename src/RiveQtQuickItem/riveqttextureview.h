@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#pragma once
+
+#include <QPointer>
+#include <QQuickItem>
+#include <QSGTextureProvider>
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+#include <QtQml/qqmlregistration.h>
+#else
+#include <QtQml/qqml.h>
+#endif
+
+/**
+ * \class RiveQtTextureView
+ * \brief Shows what another item has drawn, without drawing it again.
+ *
+ * The view displays the texture of its source item, scaled to its own size. A RiveQtQuickItem is animated and
+ * drawn once, no matter in how many places its texture is shown, for example as thumbnail or reflection. Any other
+ * texture provider, like a layered item or a ShaderEffectSource, can be used as source as well.
+ *
+ * The source has to be in the same window as the view. The view shows nothing on the software renderer of Qt 6.
+ *
+ * \par Example:
+ * \code
+ * RiveQtQuickItem {
+ *     id: animation
+ *     fileSource: ":/animations/loader.riv"
+ * }
+ *
+ * RiveQtTextureView {
+ *     width: animation.width / 4
+ *     height: animation.height / 4
+ *     source: animation
+ * }
+ * \endcode
+ */
+class RiveQtTextureView : public QQuickItem
+{
+    Q_OBJECT
+
+    /**
+     * \property RiveQtTextureView::source
+     *
+     * \brief The item whose texture is shown, it has to be a texture provider.
+     */
+    Q_PROPERTY(QQuickItem *source READ source WRITE setSource NOTIFY sourceChanged)
+
+    QML_ELEMENT
+
+public:
+    RiveQtTextureView(QQuickItem *parent = nullptr);
+
+    QQuickItem *source() const;
+    void setSource(QQuickItem *source);
+
+signals:
+    void sourceChanged();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+
+private:
+    QPointer<QQuickItem> m_source;
+    // only accessed from the render thread, like the provider itself
+    QPointer<QSGTextureProvider> m_textureProvider;
+};
@@ -9,6 +9,7 @@ layout(location = 0) out vec4 fragColor;
 
 layout(location = 0) in vec2 texCoord;
 layout(location = 1) in vec2 originalVertex;
+layout(location = 2) in float coverage;
 
 layout(std140, binding = 0) uniform buf {
     mat4 qt_Matrix;                     //0
@@ -26,6 +27,8 @@ layout(std140, binding = 0) uniform buf {
     vec4 stopColors[20];                //144
     vec2 gradientPositions[20];         //464
     mat4 tranformMatrix;                //784
+    vec4 strokeParams;                  //848 only read by the stroke expansion
+    vec4 antialiasingParams;            //864 render target size in pixels, fringe width in pixels
 };
 layout(binding = 1) uniform sampler2D image;
 
@@ -48,8 +51,12 @@ vec4 getGradientColor( float gradientCoord) {
 
 void main()
 {
-    if (useTexture == 1) {
+    if (useTexture >= 1) {
         fragColor = texture(image, texCoord);
+        // 2 for premultiplied textures rendered by the rhi, the draw pipelines blend with the source alpha
+        if (useTexture == 2 && fragColor.a > 0.0) {
+            fragColor.rgb /= fragColor.a;
+        }
         //fragColor = vec4(1,0,0,1);
     } else {
         if (useGradient == 1) {
@@ -68,5 +75,5 @@ void main()
             fragColor = color;
         }
     }
-    fragColor = fragColor * qt_Opacity;
+    fragColor = fragColor * qt_Opacity * clamp(coverage, 0.0, 1.0);
 }
@@ -24,17 +24,21 @@ layout(std140, binding = 0) uniform buf {
     vec4 stopColors[20];                //144
     vec2 gradientPositions[20];         //464
     mat4 tranformMatrix;                //784
+    vec4 strokeParams;                  //848 only read by the stroke expansion
+    vec4 antialiasingParams;            //864 render target size in pixels, fringe width in pixels
 };
 
 out gl_PerVertex { vec4 gl_Position; };
 
 layout(location = 0) out vec2 texCoord; // Pass texture coordinates to the fragment shader
 layout(location = 1) out vec2 originalVertex;
+layout(location = 2) out float coverage;
 
 void main()
 {
     texCoord = aTexCoord;
     originalVertex = vertex;
+    coverage = 1.0;
 
     gl_Position = qt_Matrix * tranformMatrix * vec4(vertex, 0.0, 1.0);
 }
@@ -0,0 +1,51 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#version 440
+
+// the same path geometry drawn once per instance, each with its own transform and opacity
+layout(location = 0) in vec2 vertex;
+layout(location = 1) in vec2 aTexCoord;
+// instanceA = (x axis, y axis) of the 2D transform
+// instanceB.xy = translation, instanceB.z = opacity
+layout(location = 2) in vec4 instanceA;
+layout(location = 3) in vec4 instanceB;
+
+layout(std140, binding = 0) uniform buf {
+    mat4 qt_Matrix;                     //0
+    float qt_Opacity;                   //64
+    float gradientRadius;               //68
+    int useGradient;                    //72
+    int blendMode;                      //76
+    vec2 gradientFocalPoint;            //80
+    vec2 gradientCenter;                //88
+    vec2 startPoint;                    //96
+    vec2 endPoint;                      //104
+    int numberOfStops;                  //112
+    int gradientType;                   //116
+    vec4 color;                         //128
+    vec4 stopColors[20];                //144
+    vec2 gradientPositions[20];         //464
+    mat4 tranformMatrix;                //784 unused, every instance brings its own
+    vec4 strokeParams;                  //848 only read by the stroke expansion
+    vec4 antialiasingParams;            //864 render target size in pixels, fringe width in pixels
+};
+
+out gl_PerVertex { vec4 gl_Position; };
+
+layout(location = 0) out vec2 texCoord;
+layout(location = 1) out vec2 originalVertex;
+layout(location = 2) out float coverage;
+
+void main()
+{
+    texCoord = aTexCoord;
+    originalVertex = vertex;
+    // the fragment shader multiplies with the coverage, the node itself draws with an opacity of 1
+    coverage = instanceB.z;
+
+    vec2 transformed = instanceA.xy * vertex.x + instanceA.zw * vertex.y + instanceB.xy;
+    gl_Position = qt_Matrix * vec4(transformed, 0.0, 1.0);
+}
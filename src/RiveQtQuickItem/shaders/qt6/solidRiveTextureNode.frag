@@ -0,0 +1,39 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#version 440
+
+// solid fills, no branches and no texture binding
+
+layout(location = 0) out vec4 fragColor;
+
+layout(location = 0) in vec2 texCoord;
+layout(location = 1) in vec2 originalVertex;
+layout(location = 2) in float coverage;
+
+layout(std140, binding = 0) uniform buf {
+    mat4 qt_Matrix;                     //0
+    float qt_Opacity;                   //64
+    float gradientRadius;               //68
+    int useGradient;                    //72
+    int useTexture;                     //76
+    vec2 gradientFocalPoint;            //80
+    vec2 gradientCenter;                //88
+    vec2 startPoint;                    //96
+    vec2 endPoint;                      //104
+    int numberOfStops;                  //112
+    int gradientType;                   //116
+    vec4 color;                         //128
+    vec4 stopColors[20];                //144
+    vec2 gradientPositions[20];         //464
+    mat4 tranformMatrix;                //784
+    vec4 strokeParams;                  //848 only read by the stroke expansion
+    vec4 antialiasingParams;            //864 render target size in pixels, fringe width in pixels
+};
+
+void main()
+{
+    fragColor = color * qt_Opacity * clamp(coverage, 0.0, 1.0);
+}
@@ -0,0 +1,194 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#version 440
+
+// expands the flattened centre line of a stroke, one instance per segment, join or cap
+// segment: instanceA = (start, end)
+// join:    instanceA = (incoming direction, corner), instanceB.xy = outgoing direction
+// cap:     instanceA = (direction away from the stroke, end point)
+// instanceB.z is the kind: 0 segment, 1 join, 2 cap
+layout(location = 0) in vec4 instanceA;
+layout(location = 1) in vec4 instanceB;
+
+layout(std140, binding = 0) uniform buf {
+    mat4 qt_Matrix;                     //0
+    float qt_Opacity;                   //64
+    float gradientRadius;               //68
+    int useGradient;                    //72
+    int blendMode;                      //76
+    vec2 gradientFocalPoint;            //80
+    vec2 gradientCenter;                //88
+    vec2 startPoint;                    //96
+    vec2 endPoint;                      //104
+    int numberOfStops;                  //112
+    int gradientType;                   //116
+    vec4 color;                         //128
+    vec4 stopColors[20];                //144
+    vec2 gradientPositions[20];         //464
+    mat4 tranformMatrix;                //784
+    vec4 strokeParams;                  //848 half width, miter limit, join (0 bevel, 1 miter, 2 round), cap (0 flat, 1 square, 2 round)
+    vec4 antialiasingParams;            //864 render target size in pixels, fringe width in pixels
+};
+
+out gl_PerVertex { vec4 gl_Position; };
+
+layout(location = 0) out vec2 texCoord;
+layout(location = 1) out vec2 originalVertex;
+layout(location = 2) out float coverage;
+
+// has to match GPU_STROKE_ROUND_SEGMENTS in texturetargetnode.cpp
+const int roundSegments = 16;
+
+// a quad split along its middle, as (along, across) pairs, so the coverage can fall off to both sides
+const vec2 quadCorners[12] = vec2[12](vec2(0.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 1.0),
+                                      vec2(1.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 0.0),
+                                      vec2(0.0, 0.0), vec2(0.0, -1.0), vec2(1.0, 0.0),
+                                      vec2(1.0, 0.0), vec2(0.0, -1.0), vec2(1.0, -1.0));
+
+// the stroke is widened by the antialiasing fringe, which fades out from the stroke edge to the outer edge
+float fringe = 0.0;
+float centerCoverage = 1.0;
+float edgeCoverage = 1.0;
+
+vec2 toPixels(vec2 point)
+{
+    vec4 position = qt_Matrix * tranformMatrix * vec4(point, 0.0, 1.0);
+    return position.xy / position.w * antialiasingParams.xy * 0.5;
+}
+
+void setupFringe(vec2 point, vec2 direction, float halfWidth)
+{
+    if (antialiasingParams.z <= 0.0) {
+        return;
+    }
+
+    float pixelsPerUnit = length(toPixels(point + direction) - toPixels(point));
+    fringe = antialiasingParams.z / max(pixelsPerUnit, 1e-6);
+    centerCoverage = (halfWidth + fringe) / fringe;
+    edgeCoverage = 0.0;
+}
+
+vec2 rotated(vec2 vector, float phi)
+{
+    float c = cos(phi);
+    float s = sin(phi);
+    return vec2(c * vector.x - s * vector.y, s * vector.x + c * vector.y);
+}
+
+vec2 normalOf(vec2 direction)
+{
+    return vec2(-direction.y, direction.x);
+}
+
+vec2 quadVertex(int vertexId, vec2 from, vec2 to, vec2 offset)
+{
+    vec2 corner = quadCorners[vertexId % 12];
+    coverage = mix(centerCoverage, edgeCoverage, abs(corner.y));
+    return mix(from, to, corner.x) + offset * corner.y;
+}
+
+vec2 segmentVertex(int vertexId, vec2 from, vec2 to, float halfWidth)
+{
+    vec2 normal = normalOf(normalize(to - from));
+    setupFringe(from, normal, halfWidth);
+    return quadVertex(vertexId, from, to, normal * (halfWidth + fringe));
+}
+
+vec2 joinVertex(int vertexId, vec2 center, vec2 incoming, vec2 outgoing, float halfWidth)
+{
+    int triangle = vertexId / 3;
+    int corner = vertexId % 3;
+
+    setupFringe(center, normalOf(incoming), halfWidth);
+    float radius = halfWidth + fringe;
+
+    float crossValue = incoming.x * outgoing.y - incoming.y * outgoing.x;
+    float dotValue = dot(incoming, outgoing);
+
+    // the center is shared by all triangles, a straight continuation needs no join at all
+    coverage = centerCoverage;
+    if (corner == 0 || (abs(crossValue) < 1e-6 && dotValue > 0.0)) {
+        return center;
+    }
+
+    // the gap to fill opens on the outer side of the turn
+    float side = crossValue > 0.0 ? -1.0 : 1.0;
+    vec2 incomingOffset = normalOf(incoming) * (radius * side);
+    vec2 outgoingOffset = normalOf(outgoing) * (radius * side);
+
+    int joinStyle = int(strokeParams.z + 0.5);
+
+    if (joinStyle == 2) {
+        float angle = acos(clamp(dotValue, -1.0, 1.0)) * (crossValue > 0.0 ? 1.0 : -1.0);
+        float phi = angle * float(triangle + corner - 1) / float(roundSegments);
+        coverage = edgeCoverage;
+        return center + rotated(incomingOffset, phi);
+    }
+
+    if (joinStyle == 1) {
+        // the miter length relative to the half width is 1 / cos(theta / 2)
+        float cosHalfAngle = sqrt(max(0.0, (1.0 + dotValue) / 2.0));
+        if (cosHalfAngle > 0.0 && 1.0 / cosHalfAngle <= strokeParams.y) {
+            vec2 miter = normalize(incomingOffset + outgoingOffset) * (radius / cosHalfAngle);
+            coverage = edgeCoverage;
+            if (triangle == 0) {
+                return center + (corner == 1 ? incomingOffset : miter);
+            }
+            return center + (corner == 1 ? miter : outgoingOffset);
+        }
+    }
+
+    // bevel, beyond the miter limit the second triangle collapses
+    if (triangle > 0) {
+        return center;
+    }
+    coverage = edgeCoverage;
+    return center + (corner == 1 ? incomingOffset : outgoingOffset);
+}
+
+vec2 capVertex(int vertexId, vec2 center, vec2 direction, float halfWidth)
+{
+    vec2 normal = normalOf(direction);
+    setupFringe(center, normal, halfWidth);
+    float radius = halfWidth + fringe;
+
+    int capStyle = int(strokeParams.w + 0.5);
+
+    if (capStyle == 2) {
+        int triangle = vertexId / 3;
+        int corner = vertexId % 3;
+        if (corner == 0) {
+            coverage = centerCoverage;
+            return center;
+        }
+        float phi = -3.14159265358979 * float(triangle + corner - 1) / float(roundSegments);
+        coverage = edgeCoverage;
+        return center + rotated(normal * radius, phi);
+    }
+
+    // square
+    return quadVertex(vertexId, center, center + direction * radius, normal * radius);
+}
+
+void main()
+{
+    float halfWidth = strokeParams.x;
+    int kind = int(instanceB.z + 0.5);
+
+    vec2 vertex;
+    if (kind == 0) {
+        vertex = segmentVertex(gl_VertexIndex, instanceA.xy, instanceA.zw, halfWidth);
+    } else if (kind == 1) {
+        vertex = joinVertex(gl_VertexIndex, instanceA.zw, instanceA.xy, instanceB.xy, halfWidth);
+    } else {
+        vertex = capVertex(gl_VertexIndex, instanceA.zw, instanceA.xy, halfWidth);
+    }
+
+    texCoord = vec2(0.0, 0.0);
+    originalVertex = vertex;
+
+    gl_Position = qt_Matrix * tranformMatrix * vec4(vertex, 0.0, 1.0);
+}
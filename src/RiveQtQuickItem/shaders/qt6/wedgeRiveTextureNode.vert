@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: 2023 Jeremias Bosch <jeremias.bosch@basyskom.com>
+// SPDX-FileCopyrightText: 2023 basysKom GmbH
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+
+#version 440
+
+// one wedge per path segment: the triangle fan from the contour start over the segment
+// lines are cubics with the control points on their end points
+layout(location = 0) in vec4 anchorAndP0;
+layout(location = 1) in vec4 p1AndP2;
+layout(location = 2) in vec4 p3;
+
+layout(std140, binding = 0) uniform buf {
+    mat4 qt_Matrix;                  //0
+    mat4 tranformMatrix;             //64
+    vec4 tessellationParams;         //128 render target size in pixels, tolerance in pixels
+};
+
+out gl_PerVertex { vec4 gl_Position; };
+
+// has to match GPU_TESSELLATION_MAX_SEGMENTS in texturetargetnode.cpp
+const int maxSegments = 32;
+
+vec2 toPixels(vec2 point)
+{
+    vec4 position = qt_Matrix * tranformMatrix * vec4(point, 0.0, 1.0);
+    return position.xy / position.w * tessellationParams.xy * 0.5;
+}
+
+vec2 cubicPoint(vec2 p0, vec2 p1, vec2 p2, vec2 p3, float t)
+{
+    float oneMinusT = 1.0 - t;
+    return p0 * (oneMinusT * oneMinusT * oneMinusT) + p1 * (3.0 * oneMinusT * oneMinusT * t) + p2 * (3.0 * oneMinusT * t * t)
+        + p3 * (t * t * t);
+}
+
+void main()
+{
+    vec2 anchor = anchorAndP0.xy;
+    vec2 p0 = anchorAndP0.zw;
+    vec2 p1 = p1AndP2.xy;
+    vec2 p2 = p1AndP2.zw;
+
+    // Wang's formula on the control points in pixels, so the tessellation follows the zoom
+    vec2 pixel0 = toPixels(p0);
+    vec2 pixel1 = toPixels(p1);
+    vec2 pixel2 = toPixels(p2);
+    vec2 pixel3 = toPixels(p3.xy);
+    float d1 = length(pixel0 - 2.0 * pixel1 + pixel2);
+    float d2 = length(pixel1 - 2.0 * pixel2 + pixel3);
+    int segments = clamp(int(ceil(sqrt(0.75 * max(d1, d2) / tessellationParams.z))), 1, maxSegments);
+
+    int triangle = gl_VertexIndex / 3;
+    int corner = gl_VertexIndex % 3;
+
+    // unused triangles collapse onto the anchor
+    vec2 vertex = anchor;
+    if (corner != 0 && triangle < segments) {
+        vertex = cubicPoint(p0, p1, p2, p3.xy, float(triangle + corner - 1) / float(segments));
+    }
+
+    gl_Position = qt_Matrix * tranformMatrix * vec4(vertex, 0.0, 1.0);
+}